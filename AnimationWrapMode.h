@@ -0,0 +1,16 @@
+#ifndef __CCIMEDITOR_ANIMATIONWRAPMODE_H__
+#define __CCIMEDITOR_ANIMATIONWRAPMODE_H__
+
+namespace CCImEditor
+{
+    // Shared by NodeImDrawer and the runtime AnimationPlayer
+    enum class AnimationWrapMode
+    {
+        Normal,
+        Loop,
+        Reverse,
+        ReverseLoop,
+    };
+}
+
+#endif
@@ -0,0 +1,378 @@
+#include "AssetPack.h"
+#include "AtomicFile.h"
+#include "BinaryScene.h"
+#include "PrefabCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+
+namespace CCImEditor
+{
+    namespace
+    {
+        const char s_magic[4] = {'C', 'C', 'P', 'K'};
+        const uint32_t s_version = 1;
+        const size_t s_headerSize = 32;
+
+        std::shared_mutex s_mountedMutex;
+        std::vector<std::unique_ptr<AssetPack>> s_mountedPacks;
+
+        std::atomic<bool> s_isRecording(false);
+        std::mutex s_recordingMutex;
+        std::vector<std::string> s_recordedFiles;
+        std::unordered_set<std::string> s_recordedSet;
+
+        uint64_t readU64(const uint8_t* ptr)
+        {
+            return static_cast<uint64_t>(Internal::readU32(ptr)) | (static_cast<uint64_t>(Internal::readU32(ptr + 4)) << 32);
+        }
+
+        void appendU32(std::string& out, uint32_t value)
+        {
+            for (int i = 0; i < 4; i++)
+                out.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+        }
+
+        void appendU64(std::string& out, uint64_t value)
+        {
+            appendU32(out, static_cast<uint32_t>(value));
+            appendU32(out, static_cast<uint32_t>(value >> 32));
+        }
+
+        uint64_t align(uint64_t offset)
+        {
+            const uint64_t alignment = AssetPack::getAlignment();
+            return (offset + alignment - 1) / alignment * alignment;
+        }
+
+        // Name of a full path relative to the search path it is under, or the path itself
+        std::string getRelativeName(const std::string& fullPath)
+        {
+            for (const std::string& searchPath : cocos2d::FileUtils::getInstance()->getSearchPaths())
+            {
+                if (!searchPath.empty() && fullPath.size() > searchPath.size() && fullPath.compare(0, searchPath.size(), searchPath) == 0)
+                    return fullPath.substr(searchPath.size());
+            }
+
+            return fullPath;
+        }
+
+        bool isSceneFile(const std::string& file)
+        {
+            const std::string extension = cocos2d::FileUtils::getInstance()->getFileExtension(file);
+            return extension == BinaryScene::getFileExtension() || extension == ".json" || extension == ".plist";
+        }
+    }
+
+    bool AssetPack::open(const std::string& file)
+    {
+        _entries.clear();
+        if (!_mappedFile.open(file))
+            return false;
+
+        const uint8_t* data = _mappedFile.getData();
+        const size_t size = _mappedFile.getSize();
+        if (size < s_headerSize || memcmp(data, s_magic, sizeof(s_magic)) != 0 || Internal::readU32(data + 4) != s_version)
+        {
+            CCLOGWARN("%s is not an asset pack", file.c_str());
+            return false;
+        }
+
+        const uint32_t count = Internal::readU32(data + 8);
+        const uint64_t indexOffset = readU64(data + 16);
+        const uint64_t indexSize = readU64(data + 24);
+        if (indexOffset > size || indexSize > size - indexOffset)
+            return false;
+
+        const uint8_t* ptr = data + indexOffset;
+        const uint8_t* end = ptr + indexSize;
+        _entries.reserve(count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (end - ptr < 20)
+                return false;
+
+            Entry entry;
+            entry._offset = readU64(ptr);
+            entry._size = readU64(ptr + 8);
+            const uint32_t nameLength = Internal::readU32(ptr + 16);
+            ptr += 20;
+
+            if (static_cast<uint64_t>(end - ptr) < nameLength || entry._offset > indexOffset || entry._size > indexOffset - entry._offset)
+            {
+                CCLOGWARN("Corrupted asset pack %s", file.c_str());
+                _entries.clear();
+                return false;
+            }
+
+            _entries.emplace(std::string(reinterpret_cast<const char*>(ptr), nameLength), entry);
+            ptr += nameLength;
+        }
+
+        return true;
+    }
+
+    bool AssetPack::find(const std::string& name, const uint8_t*& data, size_t& size) const
+    {
+        std::unordered_map<std::string, Entry>::const_iterator it = _entries.find(name);
+        if (it == _entries.end())
+            return false;
+
+        data = _mappedFile.getData() + it->second._offset;
+        size = static_cast<size_t>(it->second._size);
+        return true;
+    }
+
+    bool AssetPack::mount(const std::string& file)
+    {
+        std::unique_ptr<AssetPack> pack(new AssetPack());
+        if (!pack->open(file))
+            return false;
+
+        std::unique_lock<std::shared_mutex> lock(s_mountedMutex);
+        s_mountedPacks.push_back(std::move(pack));
+        return true;
+    }
+
+    void AssetPack::unmountAll()
+    {
+        std::unique_lock<std::shared_mutex> lock(s_mountedMutex);
+        s_mountedPacks.clear();
+    }
+
+    bool AssetPack::findMounted(const std::string& file, const uint8_t*& data, size_t& size)
+    {
+        std::shared_lock<std::shared_mutex> lock(s_mountedMutex);
+        if (s_mountedPacks.empty())
+            return false;
+
+        const std::string name = getRelativeName(file);
+        for (const std::unique_ptr<AssetPack>& pack : s_mountedPacks)
+        {
+            if (pack->find(name, data, size) || pack->find(file, data, size))
+                return true;
+        }
+
+        return false;
+    }
+
+    void AssetPack::startRecording()
+    {
+        std::lock_guard<std::mutex> lock(s_recordingMutex);
+        s_recordedFiles.clear();
+        s_recordedSet.clear();
+        s_isRecording = true;
+    }
+
+    std::vector<std::string> AssetPack::stopRecording()
+    {
+        std::lock_guard<std::mutex> lock(s_recordingMutex);
+        s_isRecording = false;
+        s_recordedSet.clear();
+        return std::move(s_recordedFiles);
+    }
+
+    void AssetPack::recordAccess(const std::string& fullPath)
+    {
+        if (!s_isRecording)
+            return;
+
+        std::lock_guard<std::mutex> lock(s_recordingMutex);
+        if (s_isRecording && s_recordedSet.insert(fullPath).second)
+            s_recordedFiles.push_back(fullPath);
+    }
+
+    bool AssetPack::Builder::addFile(const std::string& file)
+    {
+        const std::string fullPath = cocos2d::FileUtils::getInstance()->fullPathForFilename(file);
+        if (fullPath.empty())
+        {
+            CCLOGWARN("Failed to find %s for the asset pack", file.c_str());
+            return false;
+        }
+
+        std::string name = getRelativeName(fullPath);
+        if (_added.insert(name).second)
+            _files.push_back(std::move(name));
+
+        return true;
+    }
+
+    bool AssetPack::Builder::addScene(const std::string& file)
+    {
+        const std::string fullPath = cocos2d::FileUtils::getInstance()->fullPathForFilename(file);
+        if (_added.count(getRelativeName(fullPath)) > 0)
+            return true;
+
+        cocos2d::ValueMap description;
+        if (fullPath.empty() || !PrefabCache::decodeFile(fullPath, description) || !addFile(fullPath))
+        {
+            CCLOGWARN("Failed to read scene %s for the asset pack", file.c_str());
+            return false;
+        }
+
+        collectNodeReferences(description);
+        return true;
+    }
+
+    // Files are added in the order a load reads them: for each node in document order its
+    // prefab, the files named by its values, then its children
+    void AssetPack::Builder::collectNodeReferences(const cocos2d::ValueMap& node)
+    {
+        for (const char* key : {"file", "properties", "components", "animations"})
+        {
+            cocos2d::ValueMap::const_iterator it = node.find(key);
+            if (it != node.end())
+                collectReferences(it->second);
+        }
+
+        cocos2d::ValueMap::const_iterator childrenIt = node.find("children");
+        if (childrenIt != node.end() && childrenIt->second.getType() == cocos2d::Value::Type::VECTOR)
+        {
+            for (const cocos2d::Value& child : childrenIt->second.asValueVector())
+            {
+                if (child.getType() == cocos2d::Value::Type::MAP)
+                    collectNodeReferences(child.asValueMap());
+            }
+        }
+    }
+
+    // Textures, models, scripts or prefabs are referenced by path from property values.
+    // Files read by the referenced files themselves (e.g. materials of a model) are not found.
+    void AssetPack::Builder::collectReferences(const cocos2d::Value& value)
+    {
+        switch (value.getType())
+        {
+        case cocos2d::Value::Type::STRING:
+        {
+            const std::string& str = value.asString();
+            cocos2d::FileUtils* fileUtils = cocos2d::FileUtils::getInstance();
+            if (str.empty() || str.find('\n') != std::string::npos || !fileUtils->isFileExist(str) || fileUtils->isDirectoryExist(str))
+                break;
+
+            // A scene file which fails to decode is an ordinary file
+            if (!isSceneFile(str) || !addScene(str))
+                addFile(str);
+            break;
+        }
+        case cocos2d::Value::Type::VECTOR:
+            for (const cocos2d::Value& element : value.asValueVector())
+                collectReferences(element);
+            break;
+        case cocos2d::Value::Type::MAP:
+        {
+            // Keys of a ValueMap have no order, the same scene always packs the same way
+            const cocos2d::ValueMap& valueMap = value.asValueMap();
+            std::vector<const std::string*> keys;
+            keys.reserve(valueMap.size());
+            for (const auto& [key, element] : valueMap)
+                keys.push_back(&key);
+
+            std::sort(keys.begin(), keys.end(), [](const std::string* a, const std::string* b)
+            {
+                return *a < *b;
+            });
+
+            for (const std::string* key : keys)
+                collectReferences(valueMap.at(*key));
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    bool AssetPack::Builder::write(const std::string& fullPath) const
+    {
+        cocos2d::FileUtils* fileUtils = cocos2d::FileUtils::getInstance();
+
+        std::unordered_map<std::string, size_t> accessPositions;
+        for (const std::string& accessed : _accessOrder)
+        {
+            accessPositions.emplace(getRelativeName(accessed), accessPositions.size());
+        }
+
+        struct Item
+        {
+            const std::string* _name;
+            std::string _fullPath;
+            size_t _position;
+            uint64_t _offset;
+            uint64_t _size;
+        };
+
+        std::vector<Item> items;
+        items.reserve(_files.size());
+        for (size_t i = 0; i < _files.size(); i++)
+        {
+            std::unordered_map<std::string, size_t>::const_iterator it = accessPositions.find(_files[i]);
+            const size_t position = it != accessPositions.end() ? it->second : accessPositions.size() + i;
+            items.push_back({&_files[i], fileUtils->fullPathForFilename(_files[i]), position, 0, 0});
+        }
+
+        std::sort(items.begin(), items.end(), [](const Item& a, const Item& b)
+        {
+            return a._position < b._position;
+        });
+
+        uint64_t offset = s_headerSize;
+        for (Item& item : items)
+        {
+            const long size = item._fullPath.empty() ? -1 : fileUtils->getFileSize(item._fullPath);
+            if (size < 0)
+            {
+                CCLOGWARN("Failed to read %s for the asset pack", item._name->c_str());
+                return false;
+            }
+
+            item._offset = align(offset);
+            item._size = static_cast<uint64_t>(size);
+            offset = item._offset + item._size;
+        }
+
+        std::string index;
+        for (const Item& item : items)
+        {
+            appendU64(index, item._offset);
+            appendU64(index, item._size);
+            appendU32(index, static_cast<uint32_t>(item._name->size()));
+            index += *item._name;
+        }
+
+        std::string header(s_magic, sizeof(s_magic));
+        appendU32(header, s_version);
+        appendU32(header, static_cast<uint32_t>(items.size()));
+        appendU32(header, 0);
+        appendU64(header, offset);
+        appendU64(header, index.size());
+
+        Internal::AtomicFile atomicFile;
+        if (!atomicFile.open(fullPath) || !atomicFile.write(header.data(), header.size()))
+            return false;
+
+        static const char padding[64] = {};
+        uint64_t written = header.size();
+        for (const Item& item : items)
+        {
+            if (!atomicFile.write(padding, static_cast<size_t>(item._offset - written)))
+                return false;
+
+            cocos2d::Data data = fileUtils->getDataFromFile(item._fullPath);
+            if (static_cast<uint64_t>(data.getSize()) != item._size)
+            {
+                CCLOGWARN("%s changed while building the asset pack", item._name->c_str());
+                return false;
+            }
+
+            if (!atomicFile.write(data.getBytes(), static_cast<size_t>(item._size)))
+                return false;
+
+            written = item._offset + item._size;
+        }
+
+        return atomicFile.write(index.data(), index.size()) && atomicFile.commit();
+    }
+}
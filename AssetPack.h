@@ -0,0 +1,84 @@
+#ifndef __CCIMEDITOR_ASSETPACK_H__
+#define __CCIMEDITOR_ASSETPACK_H__
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstdint>
+#include "cocos2d.h"
+#include "MappedFile.h"
+
+namespace CCImEditor
+{
+    // Read-only archive of a scene and the files it references, read through one mapping.
+    //
+    // Layout, all integers are little endian:
+    //   header   "CCPK", version, entry count, reserved, index offset (64 bits), index size (64 bits)
+    //   data     the content of each entry, starting on a multiple of getAlignment()
+    //   index    for each entry its offset and size (64 bits each), name length and name
+    //
+    // Names are the paths used to reference the files, relative to the search paths.
+    // Mounted packs are looked up by MappedFile and AssetPackFileUtils before the file system.
+    class AssetPack
+    {
+    public:
+        static size_t getAlignment() { return 16; };
+
+        bool open(const std::string& file);
+
+        // Points data to the content of the entry, which lives as long as the pack
+        bool find(const std::string& name, const uint8_t*& data, size_t& size) const;
+        size_t getEntryCount() const { return _entries.size(); };
+
+        static bool mount(const std::string& file);
+        static void unmountAll();
+
+        // Looks a file up in the mounted packs, by name or by full path under a search path
+        static bool findMounted(const std::string& file, const uint8_t*& data, size_t& size);
+
+        // Full paths of the files read between start and stop, in the order of their first read
+        static void startRecording();
+        static std::vector<std::string> stopRecording();
+        static void recordAccess(const std::string& fullPath);
+
+        class Builder
+        {
+        public:
+            bool addFile(const std::string& file);
+
+            // Adds the scene, the prefabs it instantiates and every file named by one of its
+            // values, in the order of the nodes naming them, which is the order a load reads them
+            bool addScene(const std::string& file);
+
+            // Entries read in a recorded load (e.g. of the game with AssetPackFileUtils installed)
+            // are written in that order instead. The others follow in the order they were added.
+            void setAccessOrder(const std::vector<std::string>& fullPaths) { _accessOrder = fullPaths; };
+
+            bool write(const std::string& fullPath) const;
+
+            const std::vector<std::string>& getFiles() const { return _files; };
+
+        private:
+            void collectNodeReferences(const cocos2d::ValueMap& node);
+            void collectReferences(const cocos2d::Value& value);
+
+            std::vector<std::string> _files;
+            std::unordered_set<std::string> _added;
+            std::vector<std::string> _accessOrder;
+        };
+
+    private:
+        struct Entry
+        {
+            uint64_t _offset;
+            uint64_t _size;
+        };
+
+        Internal::MappedFile _mappedFile;
+        std::unordered_map<std::string, Entry> _entries;
+    };
+}
+
+#endif
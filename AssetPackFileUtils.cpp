@@ -0,0 +1,56 @@
+#include "AssetPackFileUtils.h"
+#include "AssetPack.h"
+
+#include <cstring>
+
+namespace CCImEditor
+{
+    bool AssetPackFileUtils::install()
+    {
+        AssetPackFileUtils* fileUtils = new (std::nothrow) AssetPackFileUtils();
+        if (!fileUtils || !fileUtils->init())
+        {
+            delete fileUtils;
+            return false;
+        }
+
+        cocos2d::FileUtils::setDelegate(fileUtils);
+        return true;
+    }
+
+    cocos2d::FileUtils::Status AssetPackFileUtils::getContents(const std::string& filename, cocos2d::ResizableBuffer* buffer) const
+    {
+        const std::string fullPath = fullPathForFilename(filename);
+        AssetPack::recordAccess(fullPath);
+
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        if (!fullPath.empty() && AssetPack::findMounted(fullPath, data, size))
+        {
+            buffer->resize(size);
+            if (size > 0)
+                memcpy(buffer->buffer(), data, size);
+
+            return cocos2d::FileUtils::Status::OK;
+        }
+
+        return Internal::PlatformFileUtils::getContents(filename, buffer);
+    }
+
+    long AssetPackFileUtils::getFileSize(const std::string& filepath)
+    {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        if (AssetPack::findMounted(fullPathForFilename(filepath), data, size))
+            return static_cast<long>(size);
+
+        return Internal::PlatformFileUtils::getFileSize(filepath);
+    }
+
+    bool AssetPackFileUtils::isFileExistInternal(const std::string& filePath) const
+    {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        return AssetPack::findMounted(filePath, data, size) || Internal::PlatformFileUtils::isFileExistInternal(filePath);
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef __CCIMEDITOR_ASSETPACKFILEUTILS_H__
+#define __CCIMEDITOR_ASSETPACKFILEUTILS_H__
+
+#include "cocos2d.h"
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+#include "platform/win32/CCFileUtils-win32.h"
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
+#include "platform/linux/CCFileUtils-linux.h"
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
+#include "platform/android/CCFileUtils-android.h"
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_MAC || CC_TARGET_PLATFORM == CC_PLATFORM_IOS
+#include "platform/apple/CCFileUtils-apple.h"
+#endif
+
+namespace CCImEditor
+{
+    namespace Internal
+    {
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+        typedef cocos2d::FileUtilsWin32 PlatformFileUtils;
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
+        typedef cocos2d::FileUtilsLinux PlatformFileUtils;
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
+        typedef cocos2d::FileUtilsAndroid PlatformFileUtils;
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_MAC || CC_TARGET_PLATFORM == CC_PLATFORM_IOS
+        typedef cocos2d::FileUtilsApple PlatformFileUtils;
+#endif
+    }
+
+    // FileUtils serving the files of the mounted asset packs (see AssetPack::mount) before
+    // the file system, and recording the files read while AssetPack records. Textures,
+    // models and scripts read through FileUtils are then copied out of the pack mapping
+    // instead of being opened one by one.
+    //
+    //  AssetPackFileUtils::install();
+    //  AssetPack::mount(packFile);
+    class AssetPackFileUtils : public Internal::PlatformFileUtils
+    {
+    public:
+        // Replaces the FileUtils instance, call it before anything is loaded
+        static bool install();
+
+        cocos2d::FileUtils::Status getContents(const std::string& filename, cocos2d::ResizableBuffer* buffer) const override;
+        long getFileSize(const std::string& filepath) override;
+
+    protected:
+        bool isFileExistInternal(const std::string& filePath) const override;
+    };
+}
+
+#endif
@@ -0,0 +1,90 @@
+#include "AtomicFile.h"
+#include "cocos2d.h"
+#include <atomic>
+
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+#include <windows.h>
+#include <io.h>
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace CCImEditor
+{
+    namespace Internal
+    {
+        AtomicFile::~AtomicFile()
+        {
+            discard();
+        }
+
+        bool AtomicFile::open(const std::string& fullPath)
+        {
+            discard();
+
+            // Unique per writer, several threads or processes may write the same target
+            static std::atomic<unsigned int> s_counter(0);
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+            const int processId = _getpid();
+#else
+            const int processId = static_cast<int>(getpid());
+#endif
+            _path = fullPath;
+            _tempPath = cocos2d::StringUtils::format("%s.%d.%u.tmp", fullPath.c_str(), processId, s_counter++);
+            _failed = false;
+            _file = fopen(_tempPath.c_str(), "wb");
+            return _file != nullptr;
+        }
+
+        bool AtomicFile::write(const void* data, size_t size)
+        {
+            if (!_file || _failed)
+                return false;
+
+            if (size > 0 && fwrite(data, 1, size, _file) != size)
+                _failed = true;
+
+            return !_failed;
+        }
+
+        bool AtomicFile::commit()
+        {
+            if (!_file)
+                return false;
+
+            bool ok = !_failed && fflush(_file) == 0;
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+            ok = ok && _commit(_fileno(_file)) == 0;
+#else
+            ok = ok && fsync(fileno(_file)) == 0;
+#endif
+            ok = fclose(_file) == 0 && ok;
+            _file = nullptr;
+
+            if (ok)
+            {
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+                ok = MoveFileExA(_tempPath.c_str(), _path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+                ok = rename(_tempPath.c_str(), _path.c_str()) == 0;
+#endif
+            }
+
+            if (!ok)
+                remove(_tempPath.c_str());
+
+            return ok;
+        }
+
+        void AtomicFile::discard()
+        {
+            if (!_file)
+                return;
+
+            fclose(_file);
+            _file = nullptr;
+            remove(_tempPath.c_str());
+        }
+    }
+}
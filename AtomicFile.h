@@ -0,0 +1,44 @@
+#ifndef __CCIMEDITOR_ATOMICFILE_H__
+#define __CCIMEDITOR_ATOMICFILE_H__
+
+#include <string>
+#include <cstdio>
+
+namespace CCImEditor
+{
+    namespace Internal
+    {
+        // Writes a file through a temporary file next to it, which replaces the target only
+        // once everything is written and flushed to disk. Readers never see a partial file,
+        // and writers of the same target at once each have their own temporary file.
+        // Does not use FileUtils, so it can be used from worker threads with a full path.
+        class AtomicFile
+        {
+        public:
+            AtomicFile() {};
+            ~AtomicFile();
+
+            bool open(const std::string& fullPath);
+            bool write(const void* data, size_t size);
+
+            // Flushes, syncs and renames the temporary file over the target
+            bool commit();
+
+            // Closes and removes the temporary file, called on destruction if not committed
+            void discard();
+
+            bool isOpen() const { return _file != nullptr; };
+
+        private:
+            AtomicFile(const AtomicFile&) = delete;
+            void operator=(const AtomicFile&) = delete;
+
+            std::string _path;
+            std::string _tempPath;
+            FILE* _file = nullptr;
+            bool _failed = false;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,581 @@
+#include "BinaryScene.h"
+#include "SceneFragment.h"
+
+namespace CCImEditor
+{
+    namespace
+    {
+        const uint8_t s_magic[4] = {'C', 'C', 'B', 'N'};
+        const uint32_t s_version = 1;
+        const uint32_t s_headerSize = 16;
+        const uint32_t s_containerHeaderSize = 9; // tag, count, payload size
+
+        float readFloat(const uint8_t* ptr)
+        {
+            uint32_t bits = Internal::readU32(ptr);
+            float v;
+            memcpy(&v, &bits, sizeof(v));
+            return v;
+        }
+
+        double readDouble(const uint8_t* ptr)
+        {
+            uint64_t bits = static_cast<uint64_t>(Internal::readU32(ptr)) | (static_cast<uint64_t>(Internal::readU32(ptr + 4)) << 32);
+            double v;
+            memcpy(&v, &bits, sizeof(v));
+            return v;
+        }
+
+        class Writer
+        {
+        public:
+            explicit Writer(std::string& out)
+            : _out(out)
+            {
+            }
+
+            void writeHeader()
+            {
+                _out.append(reinterpret_cast<const char*>(s_magic), sizeof(s_magic));
+                writeU32(s_version);
+                writeU32(0); // string table offset, patched in writeStrings
+                writeU32(s_headerSize);
+            }
+
+            void writeStrings()
+            {
+                patchU32(8, static_cast<uint32_t>(_out.size()));
+
+                writeU32(static_cast<uint32_t>(_strings.size()));
+                uint32_t offset = 0;
+                for (const std::string* str : _strings)
+                {
+                    writeU32(offset);
+                    offset += static_cast<uint32_t>(str->size()) + 1;
+                }
+
+                for (const std::string* str : _strings)
+                {
+                    _out.append(str->c_str(), str->size() + 1);
+                }
+            }
+
+            void writeValue(const cocos2d::Value& value)
+            {
+                switch (value.getType())
+                {
+                case cocos2d::Value::Type::BYTE:
+                    writeTag(BinaryScene::Tag::BYTE);
+                    _out.push_back(static_cast<char>(value.asByte()));
+                    break;
+                case cocos2d::Value::Type::INTEGER:
+                    writeTag(BinaryScene::Tag::INTEGER);
+                    writeU32(static_cast<uint32_t>(value.asInt()));
+                    break;
+                case cocos2d::Value::Type::UNSIGNED:
+                    writeTag(BinaryScene::Tag::UNSIGNED);
+                    writeU32(value.asUnsignedInt());
+                    break;
+                case cocos2d::Value::Type::FLOAT:
+                    writeTag(BinaryScene::Tag::FLOAT);
+                    writeFloat(value.asFloat());
+                    break;
+                case cocos2d::Value::Type::DOUBLE:
+                    writeTag(BinaryScene::Tag::DOUBLE);
+                    writeDouble(value.asDouble());
+                    break;
+                case cocos2d::Value::Type::BOOLEAN:
+                    writeTag(value.asBool() ? BinaryScene::Tag::TRUE_VALUE : BinaryScene::Tag::FALSE_VALUE);
+                    break;
+                case cocos2d::Value::Type::STRING:
+                    writeTag(BinaryScene::Tag::STRING);
+                    writeU32(intern(value.asString()));
+                    break;
+                case cocos2d::Value::Type::VECTOR:
+                    writeVector(value.asValueVector());
+                    break;
+                case cocos2d::Value::Type::MAP:
+                    writeMap(value.asValueMap());
+                    break;
+                default:
+                    if (value.getType() != cocos2d::Value::Type::NONE)
+                        CCLOGWARN("Unsupported value type: %d in binary scene, write as null", static_cast<int>(value.getType()));
+                    writeTag(BinaryScene::Tag::NONE);
+                    break;
+                }
+            }
+
+            void writeMap(const cocos2d::ValueMap& map)
+            {
+                writeMap(map, nullptr);
+            }
+
+            // Written as the map of the node with its "children"
+            void writeFragment(const SceneFragment& fragment)
+            {
+                static const cocos2d::ValueMap empty;
+                writeMap(fragment._node ? *fragment._node : empty, fragment._hasChildren ? &fragment : nullptr);
+            }
+
+        private:
+            void writeMap(const cocos2d::ValueMap& map, const SceneFragment* children)
+            {
+                // Sort keys so the same scene always produces the same bytes.
+                // The children of a fragment are a placeholder entry among them.
+                const cocos2d::ValueMap::value_type childrenEntry("children", cocos2d::Value());
+                std::vector<const cocos2d::ValueMap::value_type*> entries;
+                entries.reserve(map.size() + 1);
+                for (const cocos2d::ValueMap::value_type& entry : map)
+                    entries.push_back(&entry);
+
+                if (children)
+                    entries.push_back(&childrenEntry);
+
+                std::sort(entries.begin(), entries.end(), [](const cocos2d::ValueMap::value_type* a, const cocos2d::ValueMap::value_type* b)
+                {
+                    return a->first < b->first;
+                });
+
+                const size_t start = beginContainer(BinaryScene::Tag::MAP, static_cast<uint32_t>(entries.size()));
+                for (const cocos2d::ValueMap::value_type* entry : entries)
+                {
+                    writeU32(intern(entry->first));
+                    if (entry == &childrenEntry)
+                        writeChildren(children->_children);
+                    else
+                        writeValue(entry->second);
+                }
+                endContainer(start);
+            }
+
+            void writeChildren(const std::vector<std::shared_ptr<const SceneFragment>>& children)
+            {
+                const uint32_t count = static_cast<uint32_t>(children.size());
+                const size_t start = beginContainer(BinaryScene::Tag::VECTOR, count);
+
+                const size_t offsets = _out.size();
+                _out.append(count * 4, '\0');
+
+                const size_t elements = _out.size();
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    patchU32(offsets + i * 4, static_cast<uint32_t>(_out.size() - elements));
+                    writeFragment(*children[i]);
+                }
+                endContainer(start);
+            }
+
+            void writeVector(const cocos2d::ValueVector& vector)
+            {
+                if (writeTypedVector(vector))
+                    return;
+
+                const uint32_t count = static_cast<uint32_t>(vector.size());
+                const size_t start = beginContainer(BinaryScene::Tag::VECTOR, count);
+
+                const size_t offsets = _out.size();
+                _out.append(count * 4, '\0');
+
+                const size_t elements = _out.size();
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    patchU32(offsets + i * 4, static_cast<uint32_t>(_out.size() - elements));
+                    writeValue(vector[i]);
+                }
+                endContainer(start);
+            }
+
+            // Vec2, Vec3, Color3B and Color4B are serialized as short vectors of floats or bytes,
+            // store them as packed payloads instead of one tagged value per component.
+            bool writeTypedVector(const cocos2d::ValueVector& vector)
+            {
+                const size_t size = vector.size();
+                if (size < 2 || size > 4)
+                    return false;
+
+                bool allFloat = true;
+                bool allByte = true;
+                for (const cocos2d::Value& v : vector)
+                {
+                    const cocos2d::Value::Type type = v.getType();
+                    allFloat = allFloat && (type == cocos2d::Value::Type::FLOAT || type == cocos2d::Value::Type::DOUBLE);
+                    allByte = allByte && type == cocos2d::Value::Type::BYTE;
+                }
+
+                if (allFloat && size <= 3)
+                {
+                    writeTag(size == 2 ? BinaryScene::Tag::VEC2 : BinaryScene::Tag::VEC3);
+                    for (const cocos2d::Value& v : vector)
+                        writeFloat(v.asFloat());
+                    return true;
+                }
+
+                if (allByte && size >= 3)
+                {
+                    writeTag(size == 3 ? BinaryScene::Tag::COLOR3B : BinaryScene::Tag::COLOR4B);
+                    for (const cocos2d::Value& v : vector)
+                        _out.push_back(static_cast<char>(v.asByte()));
+                    return true;
+                }
+
+                return false;
+            }
+
+            size_t beginContainer(BinaryScene::Tag tag, uint32_t count)
+            {
+                writeTag(tag);
+                writeU32(count);
+                const size_t start = _out.size();
+                writeU32(0); // payload size, patched in endContainer
+                return start;
+            }
+
+            void endContainer(size_t start)
+            {
+                patchU32(start, static_cast<uint32_t>(_out.size() - start - 4));
+            }
+
+            uint32_t intern(const std::string& str)
+            {
+                auto it = _stringIndices.find(str);
+                if (it != _stringIndices.end())
+                    return it->second;
+
+                const uint32_t index = static_cast<uint32_t>(_strings.size());
+                it = _stringIndices.emplace(str, index).first;
+                _strings.push_back(&it->first);
+                return index;
+            }
+
+            void writeTag(BinaryScene::Tag tag)
+            {
+                _out.push_back(static_cast<char>(tag));
+            }
+
+            void writeU32(uint32_t v)
+            {
+                const char bytes[4] = {static_cast<char>(v & 0xFF), static_cast<char>((v >> 8) & 0xFF), static_cast<char>((v >> 16) & 0xFF), static_cast<char>((v >> 24) & 0xFF)};
+                _out.append(bytes, 4);
+            }
+
+            void writeFloat(float v)
+            {
+                uint32_t bits;
+                memcpy(&bits, &v, sizeof(v));
+                writeU32(bits);
+            }
+
+            void writeDouble(double v)
+            {
+                uint64_t bits;
+                memcpy(&bits, &v, sizeof(v));
+                writeU32(static_cast<uint32_t>(bits & 0xFFFFFFFF));
+                writeU32(static_cast<uint32_t>(bits >> 32));
+            }
+
+            void patchU32(size_t pos, uint32_t v)
+            {
+                _out[pos] = static_cast<char>(v & 0xFF);
+                _out[pos + 1] = static_cast<char>((v >> 8) & 0xFF);
+                _out[pos + 2] = static_cast<char>((v >> 16) & 0xFF);
+                _out[pos + 3] = static_cast<char>((v >> 24) & 0xFF);
+            }
+
+            std::string& _out;
+            std::unordered_map<std::string, uint32_t> _stringIndices;
+            std::vector<const std::string*> _strings;
+        };
+    }
+
+    bool BinaryScene::isBinaryScene(const uint8_t* data, size_t size)
+    {
+        return data && size >= s_headerSize && memcmp(data, s_magic, sizeof(s_magic)) == 0;
+    }
+
+    bool BinaryScene::encode(const cocos2d::ValueMap& root, std::string& out)
+    {
+        out.clear();
+
+        Writer writer(out);
+        writer.writeHeader();
+        writer.writeMap(root);
+        writer.writeStrings();
+        return true;
+    }
+
+    bool BinaryScene::encode(const SceneFragment& root, std::string& out)
+    {
+        out.clear();
+
+        Writer writer(out);
+        writer.writeHeader();
+        writer.writeFragment(root);
+        writer.writeStrings();
+        return true;
+    }
+
+    bool BinaryScene::Reader::init(const uint8_t* data, size_t size)
+    {
+        _data = nullptr;
+        _size = 0;
+
+        if (!isBinaryScene(data, size))
+            return false;
+
+        const uint32_t version = Internal::readU32(data + 4);
+        if (version != s_version)
+        {
+            CCLOGWARN("Unsupported binary scene version: %u", version);
+            return false;
+        }
+
+        const uint32_t stringTableOffset = Internal::readU32(data + 8);
+        if (stringTableOffset > size - 4)
+            return false;
+
+        const uint32_t stringCount = Internal::readU32(data + stringTableOffset);
+        const uint64_t stringsOffset = stringTableOffset + 4 + static_cast<uint64_t>(stringCount) * 4;
+        if (stringsOffset > size)
+            return false;
+
+        // The last string must be terminated so that none of them can run past the end
+        if (stringCount > 0 && data[size - 1] != '\0')
+            return false;
+
+        _data = data;
+        _size = size;
+        _stringCount = stringCount;
+        _stringOffsets = data + stringTableOffset + 4;
+        _strings = reinterpret_cast<const char*>(data + stringsOffset);
+        _rootOffset = Internal::readU32(data + 12);
+
+        if (!getRoot().isMap())
+        {
+            _data = nullptr;
+            _size = 0;
+            return false;
+        }
+
+        return true;
+    }
+
+    BinaryScene::ValueRef BinaryScene::Reader::getRoot() const
+    {
+        if (!_data || _rootOffset >= _size)
+            return ValueRef();
+
+        return ValueRef(this, _data + _rootOffset);
+    }
+
+    const char* BinaryScene::Reader::getString(uint32_t index) const
+    {
+        if (index >= _stringCount)
+            return nullptr;
+
+        const char* str = _strings + Internal::readU32(_stringOffsets + index * 4);
+        if (!contains(reinterpret_cast<const uint8_t*>(str), 1))
+            return nullptr;
+
+        return str;
+    }
+
+    BinaryScene::Tag BinaryScene::ValueRef::getTag() const
+    {
+        if (!_reader)
+            return Tag::NONE;
+
+        return static_cast<Tag>(*_ptr);
+    }
+
+    uint32_t BinaryScene::ValueRef::getByteSize() const
+    {
+        if (!_reader)
+            return 0;
+
+        uint64_t size = 0;
+        switch (getTag())
+        {
+        case Tag::NONE:
+        case Tag::FALSE_VALUE:
+        case Tag::TRUE_VALUE:
+            size = 1;
+            break;
+        case Tag::BYTE:
+            size = 2;
+            break;
+        case Tag::INTEGER:
+        case Tag::UNSIGNED:
+        case Tag::FLOAT:
+        case Tag::STRING:
+        case Tag::COLOR4B:
+            size = 5;
+            break;
+        case Tag::COLOR3B:
+            size = 4;
+            break;
+        case Tag::DOUBLE:
+        case Tag::VEC2:
+            size = 9;
+            break;
+        case Tag::VEC3:
+            size = 13;
+            break;
+        case Tag::VECTOR:
+        case Tag::MAP:
+            if (!_reader->contains(_ptr, s_containerHeaderSize))
+                return 0;
+            size = s_containerHeaderSize + static_cast<uint64_t>(Internal::readU32(_ptr + 5));
+            break;
+        default:
+            return 0;
+        }
+
+        if (!_reader->contains(_ptr, static_cast<size_t>(size)))
+            return 0;
+
+        return static_cast<uint32_t>(size);
+    }
+
+    uint32_t BinaryScene::ValueRef::getCount() const
+    {
+        const uint32_t byteSize = isMap() || isVector() ? getByteSize() : 0;
+        if (byteSize == 0)
+            return 0;
+
+        // A corrupted count must not reach past the container: a vector has an offset per
+        // element, a map at least a key and a tag per entry
+        const uint64_t count = Internal::readU32(_ptr + 1);
+        const uint64_t payloadSize = byteSize - s_containerHeaderSize;
+        if (count * (isVector() ? sizeof(uint32_t) : sizeof(uint32_t) + 1) > payloadSize)
+            return 0;
+
+        return static_cast<uint32_t>(count);
+    }
+
+    BinaryScene::ValueRef BinaryScene::ValueRef::at(uint32_t index) const
+    {
+        const uint32_t count = isVector() ? getCount() : 0;
+        if (index >= count)
+            return ValueRef();
+
+        const uint8_t* offsets = _ptr + s_containerHeaderSize;
+        const uint8_t* elements = offsets + static_cast<size_t>(count) * sizeof(uint32_t);
+        const uint8_t* end = _ptr + getByteSize();
+        const uint32_t offset = Internal::readU32(offsets + static_cast<size_t>(index) * sizeof(uint32_t));
+        if (offset >= static_cast<size_t>(end - elements))
+            return ValueRef();
+
+        // The whole element has to lie within the vector as well
+        ValueRef element(_reader, elements + offset);
+        const uint32_t size = element.getByteSize();
+        if (size == 0 || size > static_cast<size_t>(end - (elements + offset)))
+            return ValueRef();
+
+        return element;
+    }
+
+    BinaryScene::ValueRef BinaryScene::ValueRef::find(const char* key) const
+    {
+        ValueRef result;
+        forEach([&result, key](const char* k, const ValueRef& value)
+        {
+            if (!result.isValid() && strcmp(k, key) == 0)
+                result = value;
+        });
+        return result;
+    }
+
+    const char* BinaryScene::ValueRef::asCString() const
+    {
+        if (!isString() || getByteSize() == 0)
+            return nullptr;
+
+        return _reader->getString(Internal::readU32(_ptr + 1));
+    }
+
+    std::string BinaryScene::ValueRef::asString() const
+    {
+        const char* str = asCString();
+        return str ? str : "";
+    }
+
+    int BinaryScene::ValueRef::asInt() const
+    {
+        if (getByteSize() == 0)
+            return 0;
+
+        switch (getTag())
+        {
+        case Tag::TRUE_VALUE: return 1;
+        case Tag::BYTE: return _ptr[1];
+        case Tag::INTEGER:
+        case Tag::UNSIGNED: return static_cast<int>(Internal::readU32(_ptr + 1));
+        case Tag::FLOAT: return static_cast<int>(readFloat(_ptr + 1));
+        case Tag::DOUBLE: return static_cast<int>(readDouble(_ptr + 1));
+        default: return 0;
+        }
+    }
+
+    cocos2d::Value BinaryScene::ValueRef::toValue() const
+    {
+        if (getByteSize() == 0)
+            return cocos2d::Value();
+
+        const uint8_t* payload = _ptr + 1;
+        switch (getTag())
+        {
+        case Tag::FALSE_VALUE: return cocos2d::Value(false);
+        case Tag::TRUE_VALUE: return cocos2d::Value(true);
+        case Tag::BYTE: return cocos2d::Value(static_cast<unsigned char>(payload[0]));
+        case Tag::INTEGER: return cocos2d::Value(static_cast<int>(Internal::readU32(payload)));
+        case Tag::UNSIGNED: return cocos2d::Value(static_cast<unsigned int>(Internal::readU32(payload)));
+        case Tag::FLOAT: return cocos2d::Value(readFloat(payload));
+        case Tag::DOUBLE: return cocos2d::Value(readDouble(payload));
+        case Tag::STRING: return cocos2d::Value(asString());
+        case Tag::VEC2:
+        case Tag::VEC3:
+            {
+                const int count = getTag() == Tag::VEC2 ? 2 : 3;
+                cocos2d::ValueVector v;
+                v.reserve(count);
+                for (int i = 0; i < count; i++)
+                    v.push_back(cocos2d::Value(readFloat(payload + i * 4)));
+                return cocos2d::Value(std::move(v));
+            }
+        case Tag::COLOR3B:
+        case Tag::COLOR4B:
+            {
+                const int count = getTag() == Tag::COLOR3B ? 3 : 4;
+                cocos2d::ValueVector v;
+                v.reserve(count);
+                for (int i = 0; i < count; i++)
+                    v.push_back(cocos2d::Value(static_cast<unsigned char>(payload[i])));
+                return cocos2d::Value(std::move(v));
+            }
+        case Tag::VECTOR:
+            {
+                const uint32_t count = getCount();
+                cocos2d::ValueVector v;
+                v.reserve(count);
+                for (uint32_t i = 0; i < count; i++)
+                    v.push_back(at(i).toValue());
+                return cocos2d::Value(std::move(v));
+            }
+        case Tag::MAP:
+            return cocos2d::Value(toValueMap());
+        default:
+            return cocos2d::Value();
+        }
+    }
+
+    cocos2d::ValueMap BinaryScene::ValueRef::toValueMap() const
+    {
+        cocos2d::ValueMap map;
+        map.reserve(getCount());
+        forEach([&map](const char* key, const ValueRef& value)
+        {
+            map.emplace(key, value.toValue());
+        });
+        return map;
+    }
+}
@@ -0,0 +1,153 @@
+#ifndef __CCIMEDITOR_BINARYSCENE_H__
+#define __CCIMEDITOR_BINARYSCENE_H__
+
+#include <string>
+#include <cstdint>
+#include "cocos2d.h"
+
+namespace CCImEditor
+{
+    struct SceneFragment;
+
+    // Compact binary form (.ccbin) of the scene description written by the editor.
+    //
+    // Layout, all integers are little endian and values are not aligned:
+    //   header   "CCBN", version, string table offset, root offset
+    //   values   a tag byte followed by its payload, see BinaryScene::Tag.
+    //            Maps and vectors store their payload size so they can be skipped,
+    //            vectors also store an offset for each element.
+    //   strings  count, offset of each string, then the NUL terminated strings.
+    //            Keys, type names and string values are interned here.
+    class BinaryScene
+    {
+    public:
+        enum class Tag : uint8_t
+        {
+            NONE,
+            FALSE_VALUE,
+            TRUE_VALUE,
+            BYTE,
+            INTEGER,
+            UNSIGNED,
+            FLOAT,
+            DOUBLE,
+            STRING,
+            VEC2,
+            VEC3,
+            COLOR3B,
+            COLOR4B,
+            VECTOR,
+            MAP,
+        };
+
+        static const char* getFileExtension() { return ".ccbin"; };
+        static bool isBinaryScene(const uint8_t* data, size_t size);
+        static bool encode(const cocos2d::ValueMap& root, std::string& out);
+        static bool encode(const SceneFragment& root, std::string& out);
+
+        class Reader;
+
+        // A value inside the mapped data, valid as long as its reader and data are.
+        class ValueRef
+        {
+        public:
+            ValueRef() {};
+
+            bool isValid() const { return _reader != nullptr; };
+            Tag getTag() const;
+            bool isMap() const { return getTag() == Tag::MAP; };
+            bool isVector() const { return getTag() == Tag::VECTOR; };
+            bool isString() const { return getTag() == Tag::STRING; };
+
+            // Size in bytes including the tag, used to skip over the value
+            uint32_t getByteSize() const;
+
+            // Number of elements of a map or vector
+            uint32_t getCount() const;
+
+            // Random access into a vector, does not touch the preceding elements
+            ValueRef at(uint32_t index) const;
+
+            // Linear lookup into a map, only the keys of this map are visited
+            ValueRef find(const char* key) const;
+
+            // Calls func(const char* key, const ValueRef& value) for each map entry
+            template <typename Func>
+            void forEach(Func&& func) const;
+
+            const char* asCString() const;
+            std::string asString() const;
+            int asInt() const;
+
+            // Materializes this value and all of its descendants
+            cocos2d::Value toValue() const;
+            cocos2d::ValueMap toValueMap() const;
+
+        private:
+            friend class Reader;
+            ValueRef(const Reader* reader, const uint8_t* ptr)
+            : _reader(reader)
+            , _ptr(ptr)
+            {
+            }
+
+            const Reader* _reader = nullptr;
+            const uint8_t* _ptr = nullptr;
+        };
+
+        // Reads a binary scene in place, nothing is decoded until it is accessed.
+        // The data has to outlive the reader, usually it is a MappedFile.
+        class Reader
+        {
+        public:
+            bool init(const uint8_t* data, size_t size);
+
+            ValueRef getRoot() const;
+            uint32_t getStringCount() const { return _stringCount; };
+            const char* getString(uint32_t index) const;
+
+        private:
+            friend class ValueRef;
+            bool contains(const uint8_t* ptr, size_t size) const { return ptr >= _data && ptr + size <= _data + _size; };
+
+            const uint8_t* _data = nullptr;
+            size_t _size = 0;
+            const uint8_t* _stringOffsets = nullptr;
+            const char* _strings = nullptr;
+            uint32_t _stringCount = 0;
+            uint32_t _rootOffset = 0;
+        };
+    };
+
+    namespace Internal
+    {
+        inline uint32_t readU32(const uint8_t* ptr)
+        {
+            return static_cast<uint32_t>(ptr[0]) | (static_cast<uint32_t>(ptr[1]) << 8) | (static_cast<uint32_t>(ptr[2]) << 16) | (static_cast<uint32_t>(ptr[3]) << 24);
+        }
+    }
+
+    template <typename Func>
+    void BinaryScene::ValueRef::forEach(Func&& func) const
+    {
+        if (!isMap())
+            return;
+
+        const uint32_t count = getCount();
+        const uint8_t* end = _ptr + getByteSize();
+        const uint8_t* ptr = _ptr + 9;
+        for (uint32_t i = 0; i < count && ptr + 5 <= end; i++)
+        {
+            const char* key = _reader->getString(Internal::readU32(ptr));
+            ValueRef value(_reader, ptr + 4);
+            const uint32_t size = value.getByteSize();
+            if (!key || size == 0 || ptr + 4 + size > end)
+                return;
+
+            func(key, value);
+            ptr += 4 + size;
+        }
+    }
+}
+
+#endif
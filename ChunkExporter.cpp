@@ -0,0 +1,157 @@
+#include "ChunkExporter.h"
+#include "NodeImDrawer.h"
+#include "SceneWriter.h"
+
+#include <cmath>
+#include <map>
+
+namespace CCImEditor
+{
+    namespace
+    {
+        cocos2d::Value toValue(const cocos2d::Vec3& vec)
+        {
+            cocos2d::ValueVector v;
+            v.push_back(cocos2d::Value(vec.x));
+            v.push_back(cocos2d::Value(vec.y));
+            v.push_back(cocos2d::Value(vec.z));
+            return cocos2d::Value(std::move(v));
+        }
+
+        std::string getName(const cocos2d::ValueMap& description)
+        {
+            cocos2d::ValueMap::const_iterator propertiesIt = description.find("properties");
+            if (propertiesIt != description.end() && propertiesIt->second.getType() == cocos2d::Value::Type::MAP)
+            {
+                cocos2d::ValueMap::const_iterator nameIt = propertiesIt->second.asValueMap().find("Name");
+                if (nameIt != propertiesIt->second.asValueMap().end() && nameIt->second.getType() == cocos2d::Value::Type::STRING)
+                    return nameIt->second.asString();
+            }
+
+            return std::string();
+        }
+    }
+
+    bool ChunkExporter::exportFile(const cocos2d::ValueMap& root, const std::vector<Item>& items, float chunkSize, bool is3D, bool compact, const std::string& fullPath, std::vector<std::string>& report)
+    {
+        if (chunkSize <= 0.0f)
+        {
+            CCLOGWARN("Invalid chunk size %f", chunkSize);
+            return false;
+        }
+
+        struct Chunk
+        {
+            cocos2d::ValueVector _children;
+            cocos2d::AABB _bounds;
+        };
+
+        // Sorted so that exporting the same scene twice gives the same manifest
+        std::map<std::pair<int, int>, Chunk> chunks;
+        for (const Item& item : items)
+        {
+            const cocos2d::Vec3 center = item._bounds.getCenter();
+            const int x = static_cast<int>(std::floor(center.x / chunkSize));
+            const int y = static_cast<int>(std::floor((is3D ? center.z : center.y) / chunkSize));
+
+            Chunk& chunk = chunks[std::make_pair(x, y)];
+            chunk._children.push_back(cocos2d::Value(item._description));
+            chunk._bounds.merge(item._bounds);
+
+            const cocos2d::Vec3 size = item._bounds._max - item._bounds._min;
+            if (size.x > chunkSize || (is3D ? size.z : size.y) > chunkSize)
+                report.push_back(cocos2d::StringUtils::format("%s is larger than a chunk, it extends the bounds of chunk %d, %d", getName(item._description).c_str(), x, y));
+        }
+
+        const size_t slash = fullPath.find_last_of("/\\");
+        const size_t nameStart = slash != std::string::npos ? slash + 1 : 0;
+        size_t dot = fullPath.find_last_of('.');
+        if (dot == std::string::npos || dot < nameStart)
+            dot = fullPath.size();
+
+        const std::string directory = fullPath.substr(0, nameStart);
+        const std::string baseName = fullPath.substr(nameStart, dot - nameStart);
+        const std::string extension = fullPath.substr(dot);
+
+        cocos2d::ValueMap::const_iterator typeIt = root.find("type");
+        if (typeIt == root.end())
+            return false;
+
+        cocos2d::ValueVector chunksVal;
+        for (auto& [cell, chunk] : chunks)
+        {
+            const std::string chunkName = cocos2d::StringUtils::format("chunk_%d_%d", cell.first, cell.second);
+            const std::string file = baseName + "." + chunkName + extension;
+            const size_t nodeCount = chunk._children.size();
+
+            // The root of a chunk has no transform, its children keep the one relative to the root
+            cocos2d::ValueMap properties;
+            properties.emplace("Name", chunkName);
+
+            cocos2d::ValueMap chunkRoot;
+            chunkRoot.emplace("type", typeIt->second);
+            chunkRoot.emplace("properties", cocos2d::Value(std::move(properties)));
+            chunkRoot.emplace("children", cocos2d::Value(std::move(chunk._children)));
+            if (!SceneWriter::writeFile(directory + file, chunkRoot, compact))
+            {
+                CCLOGWARN("Failed to write chunk %s", file.c_str());
+                return false;
+            }
+
+            cocos2d::ValueMap chunkVal;
+            chunkVal.emplace("file", file);
+            chunkVal.emplace("min", toValue(chunk._bounds._min));
+            chunkVal.emplace("max", toValue(chunk._bounds._max));
+            chunksVal.push_back(cocos2d::Value(std::move(chunkVal)));
+
+            report.push_back(cocos2d::StringUtils::format("%s: %zu nodes", file.c_str(), nodeCount));
+        }
+
+        cocos2d::ValueMap manifest = root;
+        manifest.erase("children");
+        manifest["chunkSize"] = chunkSize;
+        manifest["chunks"] = cocos2d::Value(std::move(chunksVal));
+        return SceneWriter::writeFile(fullPath, manifest, compact);
+    }
+
+    cocos2d::AABB ChunkExporter::getBounds(cocos2d::Node* node, cocos2d::Node* root)
+    {
+        cocos2d::AABB bounds;
+        const cocos2d::Mat4 worldToRoot = root->getWorldToNodeTransform();
+
+        cocos2d::Sprite3D* sprite3D = dynamic_cast<cocos2d::Sprite3D*>(node);
+        cocos2d::AABB aabb = sprite3D ? sprite3D->getAABB() : cocos2d::AABB();
+        if (!aabb.isEmpty())
+        {
+            aabb.transform(worldToRoot);
+            bounds.merge(aabb);
+        }
+        else
+        {
+            const cocos2d::Mat4 nodeToRoot = worldToRoot * node->getNodeToWorldTransform();
+            const cocos2d::Size& size = node->getContentSize();
+            cocos2d::Vec3 corners[4] = {
+                cocos2d::Vec3(0.0f, 0.0f, 0.0f),
+                cocos2d::Vec3(size.width, 0.0f, 0.0f),
+                cocos2d::Vec3(0.0f, size.height, 0.0f),
+                cocos2d::Vec3(size.width, size.height, 0.0f),
+            };
+
+            for (cocos2d::Vec3& corner : corners)
+            {
+                nodeToRoot.transformPoint(&corner);
+            }
+
+            bounds.updateMinMax(corners, 4);
+        }
+
+        // Children added by the editor itself are not part of the scene
+        for (cocos2d::Node* child : node->getChildren())
+        {
+            if (child->getComponent<NodeImDrawer>())
+                bounds.merge(getBounds(child, root));
+        }
+
+        return bounds;
+    }
+}
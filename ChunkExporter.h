@@ -0,0 +1,39 @@
+#ifndef __CCIMEDITOR_CHUNKEXPORTER_H__
+#define __CCIMEDITOR_CHUNKEXPORTER_H__
+
+#include <string>
+#include <vector>
+#include "cocos2d.h"
+
+namespace CCImEditor
+{
+    // Splits a scene into files of the nodes on one square of a grid, for ChunkStreamer to
+    // load the squares around the camera. Each child of the root goes with its whole subtree
+    // to the square under the center of its bounds. The manifest is the root without its
+    // children and with the list of chunk files and their bounds:
+    //
+    //   "chunkSize": 100,
+    //   "chunks": [{"file": "level.chunk_0_-1.ccbin", "min": [x, y, z], "max": [x, y, z]}, ...]
+    //
+    // Chunk files are written next to the manifest, with its format. Bounds are in the space
+    // of the root, so the level can be moved as a whole.
+    class ChunkExporter
+    {
+    public:
+        struct Item
+        {
+            cocos2d::ValueMap _description;
+            cocos2d::AABB _bounds;
+        };
+
+        // root is the description of the root without children. The grid is on the X and Y
+        // axes in 2D and on the X and Z axes in 3D.
+        static bool exportFile(const cocos2d::ValueMap& root, const std::vector<Item>& items, float chunkSize, bool is3D, bool compact, const std::string& fullPath, std::vector<std::string>& report);
+
+        // Bounds of node and its children in the space of root, from the models of 3D sprites
+        // and the content size of the other nodes
+        static cocos2d::AABB getBounds(cocos2d::Node* node, cocos2d::Node* root);
+    };
+}
+
+#endif
@@ -0,0 +1,60 @@
+#include "Command.h"
+#include "Editor.h"
+#include "NodeImDrawer.h"
+#include "commands/AddNode.h"
+#include "commands/RemoveNode.h"
+#include "commands/CustomCommand.h"
+
+namespace CCImEditor
+{
+    Command* Command::deserialize(const cocos2d::ValueMap& source)
+    {
+        cocos2d::ValueMap::const_iterator typeIt = source.find("type");
+        if (typeIt == source.end() || typeIt->second.getType() != cocos2d::Value::Type::STRING)
+            return nullptr;
+
+        const std::string type = typeIt->second.asString();
+        if (type == "AddNode")
+            return AddNode::deserialize(source);
+        else if (type == "RemoveNode")
+            return RemoveNode::deserialize(source);
+        else if (type == "CustomCommand")
+            return CustomCommand::deserialize(source);
+
+        CCLOGWARN("Unknown command type: %s", type.c_str());
+        return nullptr;
+    }
+
+    std::string Command::getNodeId(cocos2d::Node* node)
+    {
+        NodeImDrawer* drawer = node ? node->getComponent<NodeImDrawer>() : nullptr;
+        if (!drawer)
+            return std::string();
+
+        std::string id = drawer->getId();
+        for (cocos2d::Node* parent = node->getParent(); parent; parent = parent->getParent())
+        {
+            NodeImDrawer* parentDrawer = parent->getComponent<NodeImDrawer>();
+            if (parentDrawer && !parentDrawer->getFilename().empty())
+                id = parentDrawer->getId() + "/" + id;
+        }
+
+        return id;
+    }
+
+    cocos2d::Node* Command::findNode(const std::string& id)
+    {
+        cocos2d::Node* editingNode = Editor::getInstance()->getEditingNode();
+        if (id.empty() || !editingNode)
+            return nullptr;
+
+        cocos2d::Node* found = nullptr;
+        Internal::performRecursively(editingNode, [&id, &found](cocos2d::Node* node)
+        {
+            if (!found && getNodeId(node) == id)
+                found = node;
+        });
+
+        return found;
+    }
+}
@@ -10,6 +10,43 @@ namespace CCImEditor
     public:
         virtual void undo() = 0;
         virtual void execute() = 0;
+
+        // Rough memory kept alive by the command, for the budget of CommandHistory
+        virtual size_t getMemorySize() const { return sizeof(Command); };
+
+        // Called on the last command of the history with the one queued after it, both
+        // already applied. Returns true if this command now covers next too: undo restores
+        // the state before both and execute gives the state after both.
+        virtual bool merge(Command* next) { return false; };
+
+        // Compact form of the command, for CommandHistory to keep it on disk once it is old.
+        // Nodes are referred to by getNodeId. Returns false if it has none.
+        virtual bool serialize(cocos2d::ValueMap& target) const { return false; };
+
+        // Command read back from its serialized form, applied as it was when serialized.
+        // It finds its nodes in the editing node once it is undone or executed.
+        static Command* deserialize(const cocos2d::ValueMap& source);
+
+        // Identifies the node in the editing node for the serialized form: its NodeImDrawer id,
+        // after the ids of the file-referenced nodes it is in, as the nodes of every instance
+        // of a file repeat the ids in the file. Empty if the node has no drawer.
+        static std::string getNodeId(cocos2d::Node* node);
+
+    protected:
+        // Rough memory of node and its children, with their drawers and property groups
+        static size_t getNodeMemorySize(cocos2d::Node* node)
+        {
+            size_t size = 2048;
+            for (cocos2d::Node* child : node->getChildren())
+            {
+                size += getNodeMemorySize(child);
+            }
+
+            return size;
+        }
+
+        // Node of the editing node with the id from getNodeId, nullptr if there is none
+        static cocos2d::Node* findNode(const std::string& id);
     };
 }
 
@@ -1,79 +1,256 @@
 #include "CommandHistory.h"
+#include "EditorEvents.h"
+#include "BinaryScene.h"
+
+#include <algorithm>
+
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace CCImEditor
 {
-    CommandHistory::CommandHistory()
-    : _maxSize(100)
+    namespace
+    {
+        // Edits further apart are separate steps to undo
+        const std::chrono::milliseconds s_mergeInterval(1000);
+
+        const size_t s_defaultMemoryBudget = 64 * 1024 * 1024;
+    }
+
+    CommandHistory::CommandHistory(EventBus& eventBus)
+    : _eventBus(eventBus)
+    , _memoryBudget(s_defaultMemoryBudget)
     {
         reset();
     }
 
+    CommandHistory::~CommandHistory()
+    {
+        setSpillFile(std::string());
+    }
+
+    void CommandHistory::executeCommand(Command* command)
+    {
+        command->execute();
+        _eventBus.publish(EditorEvents::CommandExecuted{command});
+    }
+
+    void CommandHistory::undoCommand(Command* command)
+    {
+        command->undo();
+        _eventBus.publish(EditorEvents::CommandUndone{command});
+    }
+
     void CommandHistory::queue(Command* command, bool execute)
     {
         CC_ASSERT(command);
 
+        cocos2d::RefPtr<Command> cmd = command;
         if (execute)
         {
-            cocos2d::RefPtr<Command> cmd = command;
-            _pendingCallbacks.push_back(CC_CALLBACK_0(Command::execute, cmd));
+            _pendingCallbacks.push_back([this, cmd]() { executeCommand(cmd); });
+        }
+        else
+        {
+            _pendingCallbacks.push_back([this, cmd]() { _eventBus.publish(EditorEvents::CommandExecuted{cmd}); });
         }
 
+        // Commands undone can not be redone anymore
+        for (CommandList::iterator it = _iterator; it != _commands.end(); ++it)
+        {
+            _memorySize -= it->_memorySize;
+        }
         _commands.erase(_iterator, _commands.end());
-        _commands.push_back(command);
-        if (_commands.size() > _maxSize)
+
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (!execute && _canMerge && !_commands.empty() && now - _lastQueueTime <= s_mergeInterval && _commands.back()._command->merge(command))
         {
-            _commands.pop_front();
+            Entry& last = _commands.back();
+            _memorySize -= last._memorySize;
+            last._memorySize = last._command->getMemorySize();
+            _memorySize += last._memorySize;
+        }
+        else
+        {
+            _commands.push_back({command, command->getMemorySize(), _nextSerial++});
+            _memorySize += _commands.back()._memorySize;
         }
 
+        // A command still to be executed is not merged into, its execute would change first
+        _canMerge = !execute;
+        _lastQueueTime = now;
         _iterator = _commands.end();
+
+        dropOldCommands();
+    }
+
+    void CommandHistory::dropOldCommands()
+    {
+        // Commands which can be redone are kept, and the last one done
+        while (_memorySize > _memoryBudget && _iterator != _commands.begin() && std::next(_commands.begin()) != _iterator)
+        {
+            const Entry& entry = _commands.front();
+            if (!_spillFile || !spill(entry._command, entry._serial))
+            {
+                // The state before the command can not be reached anymore, the one after it
+                // is now the beginning of the history
+                _spilledCommands.clear();
+                _startSerial = entry._serial;
+            }
+
+            _memorySize -= entry._memorySize;
+            _commands.pop_front();
+        }
+    }
+
+    bool CommandHistory::spill(Command* command, uint64_t serial)
+    {
+        cocos2d::ValueMap description;
+        std::string data;
+        if (!command->serialize(description) || !BinaryScene::encode(description, data))
+            return false;
+
+        if (fseek(_spillFile, 0, SEEK_END) != 0 || fwrite(data.data(), 1, data.size(), _spillFile) != data.size())
+        {
+            CCLOGWARN("Failed to write the undo history to %s", _spillPath.c_str());
+            return false;
+        }
+
+        _spilledCommands.push_back({_spillFileSize, static_cast<uint32_t>(data.size()), serial});
+        _spillFileSize += data.size();
+        return true;
+    }
+
+    bool CommandHistory::reload()
+    {
+        const SpilledCommand spilled = _spilledCommands.back();
+        std::string data(spilled._size, '\0');
+        BinaryScene::Reader reader;
+        cocos2d::RefPtr<Command> command;
+        // The file grows with the history, long is 32 bits on Windows
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+        const bool isSeeked = _spillFile && _fseeki64(_spillFile, static_cast<__int64>(spilled._offset), SEEK_SET) == 0;
+#else
+        const bool isSeeked = _spillFile && fseeko(_spillFile, static_cast<off_t>(spilled._offset), SEEK_SET) == 0;
+#endif
+        if (isSeeked &&
+            fread(&data[0], 1, data.size(), _spillFile) == data.size() &&
+            reader.init(reinterpret_cast<const uint8_t*>(data.data()), data.size()) && reader.getRoot().isMap())
+        {
+            command = Command::deserialize(reader.getRoot().toValueMap());
+        }
+
+        if (!command)
+        {
+            CCLOGWARN("Failed to read the undo history from %s", _spillPath.c_str());
+            _spilledCommands.clear();
+            _startSerial = spilled._serial;
+            return false;
+        }
+
+        // Records form a stack, the command is written again if it is dropped again
+        _spilledCommands.pop_back();
+        _spillFileSize = spilled._offset;
+        fflush(_spillFile);
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+        _chsize_s(_fileno(_spillFile), static_cast<__int64>(_spillFileSize));
+#else
+        ftruncate(fileno(_spillFile), static_cast<off_t>(_spillFileSize));
+#endif
+
+        _commands.push_front({command, command->getMemorySize(), spilled._serial});
+        _memorySize += _commands.front()._memorySize;
+        return true;
+    }
+
+    void CommandHistory::setSpillFile(const std::string& fullPath)
+    {
+        if (!_spilledCommands.empty())
+        {
+            _startSerial = _spilledCommands.back()._serial;
+            _spilledCommands.clear();
+        }
+
+        if (_spillFile)
+        {
+            fclose(_spillFile);
+            _spillFile = nullptr;
+            remove(_spillPath.c_str());
+        }
+
+        _spillPath = fullPath;
+        openSpillFile();
+    }
+
+    void CommandHistory::openSpillFile()
+    {
+        if (_spillFile)
+            fclose(_spillFile);
+
+        // Written and read back with seeks in between
+        _spillFile = _spillPath.empty() ? nullptr : fopen(_spillPath.c_str(), "w+b");
+        _spillFileSize = 0;
+        if (!_spillFile && !_spillPath.empty())
+            CCLOGWARN("Failed to open %s for the undo history", _spillPath.c_str());
+    }
+
+    void CommandHistory::setMemoryBudget(size_t memoryBudget)
+    {
+        _memoryBudget = memoryBudget;
+        dropOldCommands();
     }
 
     void CommandHistory::update(float dt)
     {
-        for (std::function<void()>& callback: _pendingCallbacks)
+        // Listeners of the events may queue more commands, they run on the next update
+        std::vector<std::function<void()>> callbacks;
+        callbacks.swap(_pendingCallbacks);
+        for (std::function<void()>& callback: callbacks)
         {
             callback();
         }
-        _pendingCallbacks.clear();
     }
 
     void CommandHistory::undo(int step)
     {
         CC_ASSERT(canUndo(step));
+        _canMerge = false;
         while(step-- > 0)
         {
+            // Commands read back find their nodes once their undo runs
+            if (_iterator == _commands.begin() && !reload())
+                break;
+
             _iterator --;
-            _pendingCallbacks.push_back(CC_CALLBACK_0(Command::undo, *_iterator));
+            cocos2d::RefPtr<Command> cmd = _iterator->_command;
+            _pendingCallbacks.push_back([this, cmd]() { undoCommand(cmd); });
         }
     }
 
     void CommandHistory::redo(int step)
     {
         CC_ASSERT(canRedo(step));
+        _canMerge = false;
         while(step-- > 0)
         {
-            _pendingCallbacks.push_back(CC_CALLBACK_0(Command::execute, *_iterator));
+            cocos2d::RefPtr<Command> cmd = _iterator->_command;
+            _pendingCallbacks.push_back([this, cmd]() { executeCommand(cmd); });
             _iterator ++;
         }
     }
 
     bool CommandHistory::canUndo(int step) const
     {
-        CommandList::iterator iterator = _iterator;
-        while(step-- > 0)
-        {
-            if (iterator == _commands.begin())
-                return false;
-
-            iterator--;
-        }
-
-        return true;
+        const size_t done = std::distance(_commands.begin(), CommandList::const_iterator(_iterator)) + _spilledCommands.size();
+        return step <= 0 || done >= static_cast<size_t>(step);
     }
     
     bool CommandHistory::canRedo(int step) const
     {
-        CommandList::iterator iterator = _iterator;
+        CommandList::const_iterator iterator = _iterator;
         while(step-- > 0)
         {
             if (iterator == _commands.end())
@@ -90,19 +267,50 @@ namespace CCImEditor
         _commands.clear();
         _pendingCallbacks.clear();
         _iterator = _commands.end();
-        _savePoint = _commands.end();
+        _startSerial = _nextSerial++;
+        _savePoint = _startSerial;
+        _hasSavePoint = true;
+        _memorySize = 0;
+        _canMerge = false;
+
+        _spilledCommands.clear();
+        if (_spillFile)
+            openSpillFile();
     }
 
     void CommandHistory::setSavePoint()
     {
-        _savePoint = _iterator;
+        _savePoint = getLastDone();
+        _hasSavePoint = true;
     }
 
-    bool CommandHistory::atSavePoint() const
+    uint64_t CommandHistory::getLastDoneSerial() const
+    {
+        if (_iterator != _commands.begin())
+            return std::prev(CommandList::const_iterator(_iterator))->_serial;
+
+        return _spilledCommands.empty() ? _startSerial : _spilledCommands.back()._serial;
+    }
+
+    uint64_t CommandHistory::getLastDone()
+    {
+        _canMerge = false;
+        return getLastDoneSerial();
+    }
+
+    void CommandHistory::setSavePoint(uint64_t lastDone)
     {
-        if (!_commands.empty() && _savePoint == _commands.end())
-            return _iterator == _commands.begin();
+        _savePoint = lastDone;
+        _hasSavePoint = true;
+    }
 
-        return _iterator == _savePoint;
+    void CommandHistory::clearSavePoint()
+    {
+        _hasSavePoint = false;
+    }
+
+    bool CommandHistory::atSavePoint() const
+    {
+        return _hasSavePoint && getLastDoneSerial() == _savePoint;
     }
 }
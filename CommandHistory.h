@@ -3,37 +3,113 @@
 
 #include <vector>
 #include <list>
+#include <chrono>
+#include <cstdio>
+#include <string>
 #include "cocos2d.h"
 #include "Command.h"
+#include "EventBus.h"
 
 namespace CCImEditor
 {
     class CommandHistory
     {
     public:
-        CommandHistory();
+        // Commands executed, redone or undone are published on eventBus
+        CommandHistory(EventBus& eventBus);
+        ~CommandHistory();
 
         void update(float dt);
 
+        // A command already applied when it is queued (execute false) is merged into the last
+        // one queued the same way shortly before, if that one accepts it, see Command::merge
         void queue(Command* command, bool execute = true);
 
         bool canUndo(int step = 1) const;
         bool canRedo(int step = 1) const;
         bool atSavePoint() const;
         void setSavePoint();
+
+        // Identifies the current position, which can later become the save point, e.g. once a
+        // background save of the state at that position has completed. Nothing is merged
+        // into the last command done afterwards, so the position keeps the same state.
+        uint64_t getLastDone();
+        void setSavePoint(uint64_t lastDone);
+
+        // No position matches the saved file, e.g. once the history was reset for a merged scene
+        void clearSavePoint();
         void undo(int step = 1);
         void redo(int step = 1);
 
         void reset();
 
+        // The oldest commands done are dropped once the history uses more memory than the
+        // budget, as reported by Command::getMemorySize. The last one done is always kept.
+        void setMemoryBudget(size_t memoryBudget);
+        size_t getMemorySize() const { return _memorySize; };
+        size_t getSize() const { return _commands.size(); };
+
+        // Commands dropped for the memory budget are appended to the file in serialized form
+        // instead, and read back (and cut off the file) when undoing that far. The history can
+        // not be undone past a command which can not be serialized. The file starts over with
+        // the history and is removed with it. Empty drops the commands.
+        void setSpillFile(const std::string& fullPath);
+        size_t getSpilledSize() const { return _spilledCommands.size(); };
+
     private:
+        void executeCommand(Command* command);
+        void undoCommand(Command* command);
+        void dropOldCommands();
+
+        // Position of the last command done, with those spilled to the file
+        uint64_t getLastDoneSerial() const;
+
+        bool spill(Command* command, uint64_t serial);
+
+        // Reads the newest command spilled back to the front of the list. On failure the
+        // spilled commands are forgotten, the history begins after the newest of them.
+        bool reload();
+        void openSpillFile();
+
+        EventBus& _eventBus;
         std::vector<std::function<void()>> _pendingCallbacks;
 
-        typedef std::list<cocos2d::RefPtr<Command>> CommandList;
+        struct Entry
+        {
+            cocos2d::RefPtr<Command> _command;
+            size_t _memorySize;
+            uint64_t _serial;
+        };
+
+        typedef std::list<Entry> CommandList;
         CommandList _commands;
         CommandList::iterator _iterator;
-        CommandList::iterator _savePoint;
-        const size_t _maxSize;
+
+        // Commands get increasing serials as they are queued, identifying the position after
+        // them. A serial no longer in the history never matches the current position again.
+        uint64_t _nextSerial = 1;
+        uint64_t _startSerial = 0; // position at the beginning of the history
+        uint64_t _savePoint = 0;
+        bool _hasSavePoint = true;
+
+        // Oldest first, before the commands in memory
+        struct SpilledCommand
+        {
+            uint64_t _offset;
+            uint32_t _size;
+            uint64_t _serial;
+        };
+        std::vector<SpilledCommand> _spilledCommands;
+        std::string _spillPath;
+        FILE* _spillFile = nullptr;
+        uint64_t _spillFileSize = 0;
+
+        size_t _memorySize = 0;
+        size_t _memoryBudget;
+
+        // Whether the next command can be merged into the last one
+        bool _canMerge = false;
+        std::chrono::steady_clock::time_point _lastQueueTime;
     };
 }
 
@@ -6,38 +6,37 @@
 #include <string>
 #include <unordered_map>
 #include "NodeImDrawer.h"
+#include "RegisteredType.h"
 
 namespace CCImEditor
 {
     class ComponentFactory
     {
     public:
-        struct ComponentType
+        struct ComponentType : RegisteredType
         {
             friend class ComponentFactory;
             
-            ComponentType(const std::string& name, const std::string& displayName, const std::function<ImPropertyGroup*()>& constructor)
-            : _name(name)
-            , _displayName(displayName)
-            , _constructor(constructor)
+            ComponentType(const std::string& name, const std::string& displayName)
+            : RegisteredType(name, displayName, 0)
             {
             }
 
-            const std::string& getName() const { return _name; };
-            const std::string& getDisplayName() const { return _displayName; };
-
             ImPropertyGroup* create() const { return _constructor(); };
 
         private:
-            std::string _name;
-            std::string _displayName;
             std::function<ImPropertyGroup*()> _constructor;
         };
     
         template <typename ComponentPropertyGroupType, typename OwnerType>
         void registerComponent(const char* name, const char* displayName)
         {
-            std::function<ImPropertyGroup*()> constructor = [name, displayName]() -> ImPropertyGroup* {
+            auto result = ComponentFactory::getInstance()->_componentTypes.emplace(name, ComponentType(name, displayName));
+            if (!result.second)
+                return;
+
+            const ComponentType* componentType = &result.first->second;
+            result.first->second._constructor = [componentType]() -> ImPropertyGroup* {
                 auto owner = OwnerType::create();
                 if (!owner)
                     return nullptr;
@@ -46,13 +45,7 @@ namespace CCImEditor
                 if (!componentPropertyGroup)
                     return nullptr;
 
-                const char* shortName = displayName;
-                while(const char* tmp = strstr(shortName, "/"))
-                {
-                    shortName = tmp + 1;
-                }
-                componentPropertyGroup->_shortName = shortName;
-                componentPropertyGroup->_typeName = name;
+                componentPropertyGroup->_type = componentType;
 
                 if (!componentPropertyGroup->init())
                 {
@@ -63,7 +56,6 @@ namespace CCImEditor
                 componentPropertyGroup->autorelease();
                 return componentPropertyGroup;
             };
-            ComponentFactory::getInstance()->_componentTypes.emplace(name, ComponentType(name, displayName, constructor));
         }
 
         typedef std::unordered_map<std::string, ComponentType> ComponentTypeMap;
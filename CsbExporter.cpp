@@ -0,0 +1,545 @@
+#include "CsbExporter.h"
+#include "AtomicFile.h"
+#include "NodeFactory.h"
+
+#include "flatbuffers/flatbuffers.h"
+#include "editor-support/cocostudio/CSParseBinary_generated.h"
+#include "editor-support/cocostudio/CSParse3DBinary_generated.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace CCImEditor
+{
+    namespace
+    {
+        // Bit of the camera masks reserved to the editor camera
+        const unsigned int s_editorCameraMask = 1 << 15;
+
+        const cocos2d::ValueMap& getMap(const cocos2d::ValueMap& valueMap, const char* key)
+        {
+            static const cocos2d::ValueMap empty;
+            cocos2d::ValueMap::const_iterator it = valueMap.find(key);
+            return it != valueMap.end() && it->second.getType() == cocos2d::Value::Type::MAP ? it->second.asValueMap() : empty;
+        }
+
+        std::string getString(const cocos2d::ValueMap& valueMap, const char* key)
+        {
+            cocos2d::ValueMap::const_iterator it = valueMap.find(key);
+            return it != valueMap.end() && it->second.getType() == cocos2d::Value::Type::STRING ? it->second.asString() : std::string();
+        }
+
+        // Properties of one node, the values of its description over the default values of
+        // its type. Saved scenes leave the default values out. Reading a value marks it as
+        // exported, the values left which differ from the default ones are reported.
+        class NodeProperties
+        {
+        public:
+            NodeProperties(const std::string& type, const cocos2d::ValueMap& properties)
+            : _properties(properties)
+            {
+                const NodeFactory::NodeTypeMap& nodeTypes = NodeFactory::getInstance()->getNodeTypes();
+                NodeFactory::NodeTypeMap::const_iterator it = nodeTypes.find(type);
+                if (it != nodeTypes.end())
+                    _defaultProperties = &it->second.getDefaultProperties();
+            }
+
+            const cocos2d::Value& get(const std::string& key)
+            {
+                _exported.insert(key);
+                cocos2d::ValueMap::const_iterator it = _properties.find(key);
+                if (it != _properties.end())
+                    return it->second;
+
+                if (_defaultProperties)
+                {
+                    it = _defaultProperties->find(key);
+                    if (it != _defaultProperties->end())
+                        return it->second;
+                }
+
+                return cocos2d::Value::Null;
+            }
+
+            bool getBool(const std::string& key, bool defaultValue)
+            {
+                const cocos2d::Value& value = get(key);
+                return value.isNull() ? defaultValue : value.asBool();
+            }
+
+            int getInt(const std::string& key, int defaultValue)
+            {
+                const cocos2d::Value& value = get(key);
+                return value.isNull() ? defaultValue : value.asInt();
+            }
+
+            float getFloat(const std::string& key, float defaultValue)
+            {
+                const cocos2d::Value& value = get(key);
+                return value.isNull() ? defaultValue : value.asFloat();
+            }
+
+            std::string getString(const std::string& key)
+            {
+                const cocos2d::Value& value = get(key);
+                return value.getType() == cocos2d::Value::Type::STRING ? value.asString() : std::string();
+            }
+
+            cocos2d::Vec2 getVec2(const std::string& key, const cocos2d::Vec2& defaultValue)
+            {
+                const cocos2d::Value& value = get(key);
+                if (value.getType() != cocos2d::Value::Type::VECTOR || value.asValueVector().size() < 2)
+                    return defaultValue;
+
+                const cocos2d::ValueVector& v = value.asValueVector();
+                return cocos2d::Vec2(v[0].asFloat(), v[1].asFloat());
+            }
+
+            cocos2d::Vec3 getVec3(const std::string& key, const cocos2d::Vec3& defaultValue)
+            {
+                const cocos2d::Value& value = get(key);
+                if (value.getType() != cocos2d::Value::Type::VECTOR || value.asValueVector().size() < 3)
+                    return defaultValue;
+
+                const cocos2d::ValueVector& v = value.asValueVector();
+                return cocos2d::Vec3(v[0].asFloat(), v[1].asFloat(), v[2].asFloat());
+            }
+
+            // Color3B and Color4B values, the opacity of a Color3B is 255
+            cocos2d::Color4B getColor(const std::string& key)
+            {
+                const cocos2d::Value& value = get(key);
+                if (value.getType() != cocos2d::Value::Type::VECTOR || value.asValueVector().size() < 3)
+                    return cocos2d::Color4B::WHITE;
+
+                const cocos2d::ValueVector& v = value.asValueVector();
+                return cocos2d::Color4B(v[0].asByte(), v[1].asByte(), v[2].asByte(), v.size() > 3 ? v[3].asByte() : 255);
+            }
+
+            // 3D nodes have a 3D position, 2D nodes a 2D one
+            bool is3D() const
+            {
+                const cocos2d::Value* position = nullptr;
+                cocos2d::ValueMap::const_iterator it = _properties.find("Position");
+                if (it != _properties.end())
+                    position = &it->second;
+                else if (_defaultProperties && (it = _defaultProperties->find("Position")) != _defaultProperties->end())
+                    position = &it->second;
+
+                return position && position->getType() == cocos2d::Value::Type::VECTOR && position->asValueVector().size() == 3;
+            }
+
+            void report(const std::string& path, std::vector<std::string>& report) const
+            {
+                std::vector<std::string> keys;
+                for (const auto& [key, value] : _properties)
+                {
+                    if (_exported.count(key) > 0)
+                        continue;
+
+                    // Empty paths name no file, e.g. the materials of a model left as they are
+                    if (value.getType() == cocos2d::Value::Type::STRING && value.asString().empty())
+                        continue;
+
+                    if (_defaultProperties)
+                    {
+                        cocos2d::ValueMap::const_iterator it = _defaultProperties->find(key);
+                        if (it != _defaultProperties->end() && it->second == value)
+                            continue;
+                    }
+
+                    keys.push_back(key);
+                }
+
+                std::sort(keys.begin(), keys.end());
+                for (const std::string& key : keys)
+                {
+                    report.push_back(cocos2d::StringUtils::format("%s: property %s is not exported", path.c_str(), key.c_str()));
+                }
+            }
+
+        private:
+            const cocos2d::ValueMap& _properties;
+            const cocos2d::ValueMap* _defaultProperties = nullptr;
+            std::unordered_set<std::string> _exported;
+        };
+
+        class Exporter
+        {
+        public:
+            explicit Exporter(std::vector<std::string>& report)
+            : _report(report)
+            {
+            }
+
+            bool encode(const cocos2d::ValueMap& description, std::string& out)
+            {
+                flatbuffers::Offset<flatbuffers::NodeTree> nodeTree = exportNode(description, getName(description));
+                if (nodeTree.o == 0)
+                    return false;
+
+                // CSLoader reads the textures list without checking it, and checks the version
+                // against its own only when there is one
+                std::vector<flatbuffers::Offset<flatbuffers::String>> none;
+                flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>> textures = _builder.CreateVector(none);
+                flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>> texturePngs = _builder.CreateVector(none);
+
+                flatbuffers::CSParseBinaryBuilder csParseBinary(_builder);
+                csParseBinary.add_textures(textures);
+                csParseBinary.add_texturePngs(texturePngs);
+                csParseBinary.add_nodeTree(nodeTree);
+                _builder.Finish(csParseBinary.Finish());
+
+                out.assign(reinterpret_cast<const char*>(_builder.GetBufferPointer()), _builder.GetSize());
+                return true;
+            }
+
+        private:
+            static std::string getName(const cocos2d::ValueMap& description)
+            {
+                const std::string name = getString(getMap(description, "properties"), "Name");
+                return !name.empty() ? name : getString(description, "type");
+            }
+
+            flatbuffers::Offset<flatbuffers::NodeTree> exportNode(const cocos2d::ValueMap& description, const std::string& path)
+            {
+                const std::string type = getString(description, "type");
+                if (type.empty())
+                {
+                    CCLOGWARN("%s has no type", path.c_str());
+                    return 0;
+                }
+
+                // Nested tables must be finished before the table referencing them is started
+                std::vector<flatbuffers::Offset<flatbuffers::NodeTree>> children;
+                cocos2d::ValueMap::const_iterator childrenIt = description.find("children");
+                if (childrenIt != description.end() && childrenIt->second.getType() == cocos2d::Value::Type::VECTOR)
+                {
+                    for (const cocos2d::Value& child : childrenIt->second.asValueVector())
+                    {
+                        if (child.getType() != cocos2d::Value::Type::MAP)
+                            continue;
+
+                        flatbuffers::Offset<flatbuffers::NodeTree> childTree = exportNode(child.asValueMap(), path + "/" + getName(child.asValueMap()));
+                        if (childTree.o == 0)
+                            return 0;
+
+                        children.push_back(childTree);
+                    }
+                }
+
+                NodeProperties properties(type, getMap(description, "properties"));
+                std::string classname;
+                flatbuffers::Offset<flatbuffers::Table> options;
+
+                const std::string file = getString(description, "file");
+                if (!file.empty())
+                {
+                    // The values of the root of the prefab which are not widget options are lost
+                    const std::string exportedName = CsbExporter::getExportedName(file);
+                    classname = "ProjectNode";
+                    options = exportProjectNode(properties, exportedName);
+                    _report.push_back(cocos2d::StringUtils::format("%s: instance of %s, which must be exported to %s as well", path.c_str(), file.c_str(), exportedName.c_str()));
+                }
+                else if (type == "CCImEditor.Node2D")
+                {
+                    classname = "Node";
+                    options = exportWidget(properties, false).o;
+                }
+                else if (type == "CCImEditor.Sprite")
+                {
+                    classname = "Sprite";
+                    options = exportSprite(properties);
+                }
+                else if (type == "CCImEditor.Label")
+                {
+                    classname = "Text";
+                    options = exportText(properties);
+                    _report.push_back(cocos2d::StringUtils::format("%s: Label is loaded as a ui::Text", path.c_str()));
+                }
+                else if (type == "CCImEditor.Node3D")
+                {
+                    classname = "Node3D";
+                    options = exportNode3D(properties).o;
+                }
+                else if (type == "CCImEditor.Sprite3D")
+                {
+                    classname = "Sprite3D";
+                    options = exportSprite3D(properties);
+                }
+                else if (type == "CCImEditor.DirectionLight")
+                {
+                    classname = "Light3D";
+                    options = exportLight(properties, cocos2d::LightType::DIRECTIONAL);
+                }
+                else if (type == "CCImEditor.PointLight")
+                {
+                    classname = "Light3D";
+                    options = exportLight(properties, cocos2d::LightType::POINT);
+                }
+                else if (type == "CCImEditor.SpotLight")
+                {
+                    classname = "Light3D";
+                    options = exportLight(properties, cocos2d::LightType::SPOT);
+                }
+                else if (type == "CCImEditor.AmbientLight")
+                {
+                    classname = "Light3D";
+                    options = exportLight(properties, cocos2d::LightType::AMBIENT);
+                }
+                else if (properties.is3D())
+                {
+                    // Geometries, skyboxes and custom types keep their transform and children
+                    classname = "Node3D";
+                    options = exportNode3D(properties).o;
+                    _report.push_back(cocos2d::StringUtils::format("%s: %s has no CSB counterpart, exported as Node3D", path.c_str(), type.c_str()));
+                }
+                else
+                {
+                    classname = "Node";
+                    options = exportWidget(properties, false).o;
+                    _report.push_back(cocos2d::StringUtils::format("%s: %s has no CSB counterpart, exported as Node", path.c_str(), type.c_str()));
+                }
+
+                properties.report(path, _report);
+                reportAnimations(description, path, "");
+
+                for (const auto& [name, component] : getMap(description, "components"))
+                {
+                    if (component.getType() != cocos2d::Value::Type::MAP)
+                        continue;
+
+                    _report.push_back(cocos2d::StringUtils::format("%s: component %s (%s) is not exported", path.c_str(), name.c_str(), getString(component.asValueMap(), "type").c_str()));
+                    reportAnimations(component.asValueMap(), path, name);
+                }
+
+                // CSLoader reads all of them without checking, even the empty ones
+                flatbuffers::Offset<flatbuffers::String> classnameOffset = _builder.CreateString(classname);
+                flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<flatbuffers::NodeTree>>> childrenOffset = _builder.CreateVector(children);
+                flatbuffers::Offset<flatbuffers::Options> optionsOffset = flatbuffers::CreateOptions(_builder, flatbuffers::Offset<flatbuffers::WidgetOptions>(options.o));
+                flatbuffers::Offset<flatbuffers::String> customClassName = _builder.CreateString("");
+
+                flatbuffers::NodeTreeBuilder nodeTree(_builder);
+                nodeTree.add_classname(classnameOffset);
+                nodeTree.add_children(childrenOffset);
+                nodeTree.add_options(optionsOffset);
+                nodeTree.add_customClassName(customClassName);
+                return nodeTree.Finish();
+            }
+
+            // Node values shared by every class. 3D nodes leave the transform to Node3DOption,
+            // which is applied after them.
+            flatbuffers::Offset<flatbuffers::WidgetOptions> exportWidget(NodeProperties& properties, bool is3D, bool ignoreSize = false)
+            {
+                cocos2d::Vec2 position = cocos2d::Vec2::ZERO;
+                cocos2d::Vec2 scale = cocos2d::Vec2::ONE;
+                float rotation = 0.0f;
+                if (!is3D)
+                {
+                    position = properties.getVec2("Position", cocos2d::Vec2::ZERO);
+                    scale = properties.getVec2("Scale", cocos2d::Vec2::ONE);
+                    rotation = properties.getFloat("Rotation", 0.0f);
+                }
+
+                const cocos2d::Vec2 anchorPoint = properties.getVec2("AnchorPoint", cocos2d::Vec2::ZERO);
+                const cocos2d::Vec2 contentSize = properties.getVec2("ContentSize", cocos2d::Vec2::ZERO);
+                const cocos2d::Color4B color = properties.getColor("Color");
+
+                flatbuffers::Offset<flatbuffers::String> name = _builder.CreateString(properties.getString("Name"));
+                flatbuffers::Offset<flatbuffers::String> empty = _builder.CreateString("");
+
+                flatbuffers::RotationSkew rotationSkew(rotation, rotation);
+                flatbuffers::Position flatPosition(position.x, position.y);
+                flatbuffers::Scale flatScale(scale.x, scale.y);
+                flatbuffers::AnchorPoint flatAnchorPoint(anchorPoint.x, anchorPoint.y);
+                flatbuffers::Color flatColor(color.a, color.r, color.g, color.b);
+                flatbuffers::FlatSize flatSize(contentSize.x, contentSize.y);
+
+                flatbuffers::WidgetOptionsBuilder options(_builder);
+                options.add_name(name);
+                options.add_rotationSkew(&rotationSkew);
+                options.add_zOrder(properties.getInt("LocalZOrder", 0));
+                options.add_visible(properties.getBool("Visible", true));
+                options.add_alpha(color.a);
+                options.add_tag(properties.getInt("Tag", cocos2d::Node::INVALID_TAG));
+                options.add_position(&flatPosition);
+                options.add_scale(&flatScale);
+                options.add_anchorPoint(&flatAnchorPoint);
+                options.add_color(&flatColor);
+                options.add_size(&flatSize);
+                options.add_flipX(properties.getBool("FlippedX", false));
+                options.add_ignoreSize(ignoreSize);
+                options.add_frameEvent(empty);
+                options.add_customProperty(empty);
+                options.add_callBackType(empty);
+                options.add_callBackName(empty);
+                options.add_cascadeColorEnabled(properties.getBool("CascadeColorEnabled", false));
+                options.add_cascadeOpacityEnabled(properties.getBool("CascadeOpacityEnabled", false));
+                return options.Finish();
+            }
+
+            flatbuffers::Offset<flatbuffers::ResourceData> exportResource(const std::string& path)
+            {
+                flatbuffers::Offset<flatbuffers::String> pathOffset = _builder.CreateString(path);
+                flatbuffers::Offset<flatbuffers::String> plistFile = _builder.CreateString("");
+
+                // Resource type 0 is a plain file, 1 a sprite frame of a plist
+                flatbuffers::ResourceDataBuilder resourceData(_builder);
+                resourceData.add_path(pathOffset);
+                resourceData.add_plistFile(plistFile);
+                resourceData.add_resourceType(0);
+                return resourceData.Finish();
+            }
+
+            flatbuffers::Offset<flatbuffers::Table> exportProjectNode(NodeProperties& properties, const std::string& fileName)
+            {
+                flatbuffers::Offset<flatbuffers::WidgetOptions> nodeOptions = exportWidget(properties, properties.is3D());
+                flatbuffers::Offset<flatbuffers::String> fileNameOffset = _builder.CreateString(fileName);
+
+                flatbuffers::ProjectNodeOptionsBuilder options(_builder);
+                options.add_nodeOptions(nodeOptions);
+                options.add_fileName(fileNameOffset);
+                options.add_innerActionSpeed(1.0f);
+                return options.Finish().o;
+            }
+
+            flatbuffers::Offset<flatbuffers::Table> exportSprite(NodeProperties& properties)
+            {
+                flatbuffers::Offset<flatbuffers::WidgetOptions> nodeOptions = exportWidget(properties, false);
+                flatbuffers::Offset<flatbuffers::ResourceData> fileNameData = exportResource(properties.getString("Texture"));
+
+                const cocos2d::Value& blendFuncValue = properties.get("BlendFunc");
+                cocos2d::BlendFunc blendFunc = cocos2d::BlendFunc::ALPHA_PREMULTIPLIED;
+                if (blendFuncValue.getType() == cocos2d::Value::Type::VECTOR && blendFuncValue.asValueVector().size() == 2)
+                {
+                    blendFunc.src = blendFuncValue.asValueVector()[0].asUnsignedInt();
+                    blendFunc.dst = blendFuncValue.asValueVector()[1].asUnsignedInt();
+                }
+                flatbuffers::BlendFunc flatBlendFunc(blendFunc.src, blendFunc.dst);
+
+                flatbuffers::SpriteOptionsBuilder options(_builder);
+                options.add_nodeOptions(nodeOptions);
+                options.add_fileNameData(fileNameData);
+                options.add_blendFunc(&flatBlendFunc);
+                return options.Finish().o;
+            }
+
+            flatbuffers::Offset<flatbuffers::Table> exportText(NodeProperties& properties)
+            {
+                // ui::Text sizes itself to the string unless it has dimensions
+                const cocos2d::Vec2 dimensions = properties.getVec2("Dimensions", cocos2d::Vec2::ZERO);
+                const bool isCustomSize = dimensions.x > 0.0f || dimensions.y > 0.0f;
+
+                flatbuffers::Offset<flatbuffers::WidgetOptions> widgetOptions = exportWidget(properties, false, !isCustomSize);
+                flatbuffers::Offset<flatbuffers::ResourceData> fontResource = exportResource("");
+                flatbuffers::Offset<flatbuffers::String> fontName = _builder.CreateString(properties.getString("FontName"));
+                flatbuffers::Offset<flatbuffers::String> text = _builder.CreateString(properties.getString("String"));
+
+                flatbuffers::TextOptionsBuilder options(_builder);
+                options.add_widgetOptions(widgetOptions);
+                options.add_fontResource(fontResource);
+                options.add_fontName(fontName);
+                options.add_fontSize(static_cast<int>(properties.getFloat("FontSize", 12.0f) + 0.5f));
+                options.add_text(text);
+                options.add_areaWidth(static_cast<int>(dimensions.x));
+                options.add_areaHeight(static_cast<int>(dimensions.y));
+                options.add_hAlignment(properties.getInt("HAlign", 0));
+                options.add_vAlignment(properties.getInt("VAlign", 0));
+                options.add_isCustomSize(isCustomSize);
+                return options.Finish().o;
+            }
+
+            flatbuffers::Offset<flatbuffers::Node3DOption> exportNode3D(NodeProperties& properties)
+            {
+                flatbuffers::Offset<flatbuffers::WidgetOptions> nodeOptions = exportWidget(properties, true);
+
+                const cocos2d::Vec3 position = properties.getVec3("Position", cocos2d::Vec3::ZERO);
+                const cocos2d::Vec3 rotation = properties.getVec3("Rotation", cocos2d::Vec3::ZERO);
+                const cocos2d::Vec3 scale = properties.getVec3("Scale", cocos2d::Vec3::ONE);
+                flatbuffers::FVec3 flatPosition(position.x, position.y, position.z);
+                flatbuffers::FVec3 flatRotation(rotation.x, rotation.y, rotation.z);
+                flatbuffers::FVec3 flatScale(scale.x, scale.y, scale.z);
+
+                const unsigned int cameraMask = static_cast<unsigned int>(properties.getInt("CameraMask", 1)) & ~s_editorCameraMask;
+
+                flatbuffers::Node3DOptionBuilder options(_builder);
+                options.add_nodeOptions(nodeOptions);
+                options.add_position3D(&flatPosition);
+                options.add_rotation3D(&flatRotation);
+                options.add_scale3D(&flatScale);
+                options.add_cameramask(static_cast<int>(cameraMask));
+                return options.Finish();
+            }
+
+            flatbuffers::Offset<flatbuffers::Table> exportSprite3D(NodeProperties& properties)
+            {
+                flatbuffers::Offset<flatbuffers::Node3DOption> node3DOption = exportNode3D(properties);
+                flatbuffers::Offset<flatbuffers::ResourceData> fileData = exportResource(properties.getString("Model"));
+
+                flatbuffers::Sprite3DOptionsBuilder options(_builder);
+                options.add_node3DOption(node3DOption);
+                options.add_fileData(fileData);
+                options.add_lightFlag(properties.getInt("LightMask", -1));
+                return options.Finish().o;
+            }
+
+            // Angles are stored in radians by the editor and in degrees by CSB
+            flatbuffers::Offset<flatbuffers::Table> exportLight(NodeProperties& properties, cocos2d::LightType lightType)
+            {
+                flatbuffers::Offset<flatbuffers::Node3DOption> node3DOption = exportNode3D(properties);
+
+                flatbuffers::Light3DOptionBuilder options(_builder);
+                options.add_node3DOption(node3DOption);
+                options.add_enabled(properties.getBool("Enabled", true));
+                options.add_type(static_cast<int>(lightType));
+                options.add_flag(properties.getInt("LightFlag", 0));
+                options.add_intensity(properties.getFloat("Intensity", 1.0f));
+                if (lightType == cocos2d::LightType::POINT || lightType == cocos2d::LightType::SPOT)
+                    options.add_range(properties.getFloat("Range", 0.0f));
+                if (lightType == cocos2d::LightType::SPOT)
+                    options.add_outerAngle(CC_RADIANS_TO_DEGREES(properties.getFloat("OuterAngle", 0.0f)));
+                return options.Finish().o;
+            }
+
+            void reportAnimations(const cocos2d::ValueMap& description, const std::string& path, const std::string& component)
+            {
+                for (const auto& [name, animation] : getMap(description, "animations"))
+                {
+                    if (component.empty())
+                        _report.push_back(cocos2d::StringUtils::format("%s: animation %s is not exported", path.c_str(), name.c_str()));
+                    else
+                        _report.push_back(cocos2d::StringUtils::format("%s: animation %s of component %s is not exported", path.c_str(), name.c_str(), component.c_str()));
+                }
+            }
+
+            flatbuffers::FlatBufferBuilder _builder;
+            std::vector<std::string>& _report;
+        };
+    }
+
+    bool CsbExporter::encode(const cocos2d::ValueMap& description, std::string& out, std::vector<std::string>& report)
+    {
+        Exporter exporter(report);
+        return exporter.encode(description, out);
+    }
+
+    bool CsbExporter::exportFile(const cocos2d::ValueMap& description, const std::string& fullPath, std::vector<std::string>& report)
+    {
+        std::string content;
+        if (!encode(description, content, report))
+            return false;
+
+        Internal::AtomicFile atomicFile;
+        return atomicFile.open(fullPath) && atomicFile.write(content.data(), content.size()) && atomicFile.commit();
+    }
+
+    std::string CsbExporter::getExportedName(const std::string& file)
+    {
+        const size_t dot = file.find_last_of('.');
+        const size_t slash = file.find_last_of("/\\");
+        if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+            return file + getFileExtension();
+
+        return file.substr(0, dot) + getFileExtension();
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef __CCIMEDITOR_CSBEXPORTER_H__
+#define __CCIMEDITOR_CSBEXPORTER_H__
+
+#include <string>
+#include <vector>
+#include "cocos2d.h"
+
+namespace CCImEditor
+{
+    // Converts a scene description to the FlatBuffers (CSB) format read by cocostudio's
+    // CSLoader, so that shipping builds load scenes without this editor:
+    //
+    //   Node2D -> Node          Node3D -> Node3D        lights -> Light3D
+    //   Sprite -> Sprite        Sprite3D -> Sprite3D    prefab instances -> ProjectNode
+    //   Label -> Text (ui::Text)
+    //
+    // The schema has no place for everything the editor stores. Each value, component,
+    // animation or node type which is lost is described by a line of the report.
+    class CsbExporter
+    {
+    public:
+        // Must run on the main thread, default values are read from new nodes
+        static bool encode(const cocos2d::ValueMap& description, std::string& out, std::vector<std::string>& report);
+        static bool exportFile(const cocos2d::ValueMap& description, const std::string& fullPath, std::vector<std::string>& report);
+
+        // Prefab instances reference the exported prefab, found next to the prefab file
+        static std::string getFileExtension() { return ".csb"; };
+        static std::string getExportedName(const std::string& file);
+    };
+}
+
+#endif
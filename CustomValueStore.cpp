@@ -0,0 +1,115 @@
+#include "CustomValueStore.h"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace CCImEditor
+{
+    namespace Internal
+    {
+        CustomValueStore::~CustomValueStore()
+        {
+            clear();
+        }
+
+        CustomValueStore::CustomValueStore(const CustomValueStore& other)
+        {
+            *this = other;
+        }
+
+        CustomValueStore& CustomValueStore::operator=(const CustomValueStore& other)
+        {
+            if (this == &other)
+                return *this;
+
+            clear();
+            _slots.resize(other._slots.size());
+            for (size_t i = 0; i < _slots.size(); i++)
+            {
+                _slots[i]._key = retain(other._slots[i]._key);
+                _slots[i]._type = other._slots[i]._type;
+                _slots[i]._type->_copy(_slots[i]._data, other._slots[i]._data);
+            }
+
+            return *this;
+        }
+
+        void CustomValueStore::clear()
+        {
+            for (Slot& slot : _slots)
+            {
+                slot._type->_destroy(slot._data);
+                release(slot._key);
+            }
+
+            _slots.clear();
+        }
+
+        namespace
+        {
+            // Interned strings with their number of holders. Never destroyed, stores may be
+            // released by other statics at exit.
+            struct Pool
+            {
+                std::mutex _mutex;
+                std::unordered_map<std::string, size_t> _strings;
+            };
+
+            Pool& getPool()
+            {
+                static Pool* pool = new Pool();
+                return *pool;
+            }
+        }
+
+        const std::string* CustomValueStore::intern(const char* str)
+        {
+            Pool& pool = getPool();
+            std::lock_guard<std::mutex> lock(pool._mutex);
+            std::unordered_map<std::string, size_t>::iterator it = pool._strings.emplace(str, 0).first;
+            ++it->second;
+            return &it->first;
+        }
+
+        const std::string* CustomValueStore::retain(const std::string* str)
+        {
+            Pool& pool = getPool();
+            std::lock_guard<std::mutex> lock(pool._mutex);
+            ++pool._strings.find(*str)->second;
+            return str;
+        }
+
+        void CustomValueStore::release(const std::string* str)
+        {
+            Pool& pool = getPool();
+            std::lock_guard<std::mutex> lock(pool._mutex);
+            std::unordered_map<std::string, size_t>::iterator it = pool._strings.find(*str);
+            if (--it->second == 0)
+                pool._strings.erase(it);
+        }
+
+        size_t CustomValueStore::getInternedCount()
+        {
+            Pool& pool = getPool();
+            std::lock_guard<std::mutex> lock(pool._mutex);
+            return pool._strings.size();
+        }
+
+        CustomValueStore::Slot* CustomValueStore::find(const char* key)
+        {
+            return const_cast<Slot*>(static_cast<const CustomValueStore*>(this)->find(key));
+        }
+
+        // Groups hold a few values, a scan is cheaper than hashing the key
+        const CustomValueStore::Slot* CustomValueStore::find(const char* key) const
+        {
+            for (const Slot& slot : _slots)
+            {
+                if (strcmp(slot._key->c_str(), key) == 0)
+                    return &slot;
+            }
+
+            return nullptr;
+        }
+    }
+}
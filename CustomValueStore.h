@@ -0,0 +1,162 @@
+#ifndef __CCIMEDITOR_CUSTOMVALUESTORE_H__
+#define __CCIMEDITOR_CUSTOMVALUESTORE_H__
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include "cocos2d.h"
+
+namespace CCImEditor
+{
+    namespace Internal
+    {
+        // Types whose values can be moved by copying their bytes. The cocos math and color
+        // types are plain floats and bytes, but declare copy constructors or destructors.
+        template <class T> struct IsTriviallyRelocatable : std::is_trivially_copyable<T> {};
+        template <> struct IsTriviallyRelocatable<cocos2d::Vec2> : std::true_type {};
+        template <> struct IsTriviallyRelocatable<cocos2d::Vec3> : std::true_type {};
+        template <> struct IsTriviallyRelocatable<cocos2d::Vec4> : std::true_type {};
+        template <> struct IsTriviallyRelocatable<cocos2d::Quaternion> : std::true_type {};
+        template <> struct IsTriviallyRelocatable<cocos2d::Size> : std::true_type {};
+        template <> struct IsTriviallyRelocatable<cocos2d::Rect> : std::true_type {};
+        template <> struct IsTriviallyRelocatable<cocos2d::Color3B> : std::true_type {};
+        template <> struct IsTriviallyRelocatable<cocos2d::Color4B> : std::true_type {};
+        template <> struct IsTriviallyRelocatable<cocos2d::Color4F> : std::true_type {};
+
+        // Values of the properties a group keeps for its owner, i.e. those whose getter is a
+        // DefaultGetter (file paths and the like). A slot is 32 bytes: the interned key, the
+        // type of the value, and the value itself when it fits in 16 bytes (numbers, vectors,
+        // colors, enums). Strings are interned, so groups using the same path share it while
+        // they hold it, and other types are boxed. Lookups compare keys without touching the
+        // intern pool, so they are safe on worker threads.
+        class CustomValueStore
+        {
+        public:
+            CustomValueStore() {};
+            ~CustomValueStore();
+            CustomValueStore(const CustomValueStore& other);
+            CustomValueStore& operator=(const CustomValueStore& other);
+
+            // False if there is no value for key or it has another type
+            template <class T>
+            bool get(const char* key, T& v) const;
+
+            template <class T>
+            void set(const char* key, const T& v);
+
+            bool empty() const { return _slots.empty(); };
+            size_t size() const { return _slots.size(); };
+            void clear();
+
+            // Returns the same pointer for equal strings while any of them is held. Each intern
+            // or retain is balanced by a release, the last one frees the string.
+            static const std::string* intern(const char* str);
+            static const std::string* retain(const std::string* str);
+            static void release(const std::string* str);
+            static size_t getInternedCount();
+
+        private:
+            struct Type
+            {
+                void (*_copy)(void* dst, const void* src);
+                void (*_destroy)(void* data);
+            };
+
+            // Slots are moved as bytes when the vector grows, so inline values must allow it
+            template <class T>
+            struct IsInline : std::bool_constant<
+                sizeof(T) <= 16 && alignof(T) <= 8 && IsTriviallyRelocatable<T>::value
+            > {};
+
+            template <class T>
+            static const Type* getType();
+
+            struct Slot
+            {
+                const std::string* _key;
+                const Type* _type;
+                alignas(8) unsigned char _data[16];
+            };
+
+            Slot* find(const char* key);
+            const Slot* find(const char* key) const;
+
+            std::vector<Slot> _slots;
+        };
+
+        template <class T>
+        const CustomValueStore::Type* CustomValueStore::getType()
+        {
+            static const Type type = {
+                [](void* dst, const void* src)
+                {
+                    if constexpr (std::is_same<T, std::string>::value)
+                        *static_cast<const std::string**>(dst) = retain(*static_cast<const std::string* const*>(src));
+                    else if constexpr (IsInline<T>::value)
+                        new (dst) T(*static_cast<const T*>(src));
+                    else
+                        *static_cast<T**>(dst) = new T(**static_cast<const T* const*>(src));
+                },
+                [](void* data)
+                {
+                    if constexpr (std::is_same<T, std::string>::value)
+                        release(*static_cast<const std::string* const*>(data));
+                    else if constexpr (IsInline<T>::value)
+                        static_cast<T*>(data)->~T();
+                    else
+                        delete *static_cast<T**>(data);
+                }
+            };
+            return &type;
+        }
+
+        template <class T>
+        bool CustomValueStore::get(const char* key, T& v) const
+        {
+            const Slot* slot = find(key);
+            if (!slot || slot->_type != getType<T>())
+                return false;
+
+            if constexpr (std::is_same<T, std::string>::value)
+                v = **reinterpret_cast<const std::string* const*>(slot->_data);
+            else if constexpr (IsInline<T>::value)
+                v = *reinterpret_cast<const T*>(slot->_data);
+            else
+                v = **reinterpret_cast<const T* const*>(slot->_data);
+            return true;
+        }
+
+        template <class T>
+        void CustomValueStore::set(const char* key, const T& v)
+        {
+            // Interned first, the value may be the one the slot releases
+            const std::string* str = nullptr;
+            if constexpr (std::is_same<T, std::string>::value)
+                str = intern(v.c_str());
+
+            Slot* slot = find(key);
+            if (slot)
+            {
+                slot->_type->_destroy(slot->_data);
+            }
+            else
+            {
+                _slots.emplace_back();
+                slot = &_slots.back();
+                slot->_key = intern(key);
+            }
+
+            slot->_type = getType<T>();
+            if constexpr (std::is_same<T, std::string>::value)
+                *reinterpret_cast<const std::string**>(slot->_data) = str;
+            else if constexpr (IsInline<T>::value)
+                new (slot->_data) T(v);
+            else
+                *reinterpret_cast<T**>(slot->_data) = new T(v);
+        }
+    }
+}
+
+#endif
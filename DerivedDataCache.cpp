@@ -0,0 +1,219 @@
+#include "DerivedDataCache.h"
+#include "AtomicFile.h"
+#include "BinaryScene.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <sys/stat.h>
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+
+namespace CCImEditor
+{
+    namespace
+    {
+        // Part of every key, bump it when the encoding of the binary scenes changes
+        const uint64_t s_version = 1;
+
+        bool getFileStatus(const std::string& path, uint64_t& size, int64_t& modificationTime)
+        {
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+            struct _stat64 st;
+            if (_stat64(path.c_str(), &st) != 0)
+                return false;
+#else
+            struct stat st;
+            if (stat(path.c_str(), &st) != 0)
+                return false;
+#endif
+            size = static_cast<uint64_t>(st.st_size);
+            modificationTime = static_cast<int64_t>(st.st_mtime);
+            return true;
+        }
+
+        // The modification time of an entry is its last use, so the order survives restarts
+        void touch(const std::string& path)
+        {
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+            _utime(path.c_str(), nullptr);
+#else
+            utime(path.c_str(), nullptr);
+#endif
+        }
+    }
+
+    DerivedDataCache* DerivedDataCache::getInstance()
+    {
+        static DerivedDataCache instance;
+        return &instance;
+    }
+
+    void DerivedDataCache::setEnabled(bool enabled)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_isEnabled == enabled)
+            return;
+
+        _isEnabled = enabled;
+        _entries.clear();
+        _size = 0;
+        if (!enabled)
+            return;
+
+        cocos2d::FileUtils* fileUtils = cocos2d::FileUtils::getInstance();
+        _directory = fileUtils->getWritablePath() + "cc_imgui_editor/derived_data/";
+        fileUtils->createDirectory(_directory);
+
+        const std::string extension = BinaryScene::getFileExtension();
+        for (const std::string& path : fileUtils->listFiles(_directory))
+        {
+            const size_t slash = path.find_last_of('/');
+            const std::string name = path.substr(slash + 1);
+            if (name.size() <= extension.size() || name.compare(name.size() - extension.size(), extension.size(), extension) != 0)
+                continue;
+
+            Entry entry;
+            if (getFileStatus(path, entry._size, entry._lastUse))
+            {
+                _entries.emplace(name.substr(0, name.size() - extension.size()), entry);
+                _size += entry._size;
+            }
+        }
+
+        evict();
+    }
+
+    void DerivedDataCache::setSizeLimit(uint64_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _sizeLimit = bytes;
+        evict();
+    }
+
+    uint64_t DerivedDataCache::getSize()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _size;
+    }
+
+    std::string DerivedDataCache::getKey(const uint8_t* data, size_t size)
+    {
+        // FNV-1a, the size is kept next to the hash to make collisions even less likely
+        uint64_t hash = 14695981039346656037ULL ^ s_version;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= data[i];
+            hash *= 1099511628211ULL;
+        }
+
+        return cocos2d::StringUtils::format("%016llx-%llx", static_cast<unsigned long long>(hash), static_cast<unsigned long long>(size));
+    }
+
+    std::string DerivedDataCache::find(const std::string& key)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::unordered_map<std::string, Entry>::iterator it = _entries.find(key);
+        if (it == _entries.end())
+            return std::string();
+
+        const std::string path = getPath(key);
+        it->second._lastUse = static_cast<int64_t>(time(nullptr));
+        touch(path);
+        return path;
+    }
+
+    bool DerivedDataCache::load(const std::string& key, cocos2d::ValueMap& out)
+    {
+        const std::string path = find(key);
+        if (path.empty())
+            return false;
+
+        Internal::MappedFile mappedFile;
+        BinaryScene::Reader reader;
+        if (!mappedFile.open(path) || !reader.init(mappedFile.getData(), mappedFile.getSize()))
+        {
+            CCLOGWARN("Removing unreadable derived data %s", path.c_str());
+            mappedFile.close();
+            std::lock_guard<std::mutex> lock(_mutex);
+            remove(key);
+            return false;
+        }
+
+        out = reader.getRoot().toValueMap();
+        return true;
+    }
+
+    bool DerivedDataCache::store(const std::string& key, const cocos2d::ValueMap& description)
+    {
+        if (!_isEnabled)
+            return false;
+
+        std::string content;
+        if (!BinaryScene::encode(description, content))
+            return false;
+
+        // Writers of the same key write the same content through their own temporary files,
+        // the last rename wins
+        const std::string path = getPath(key);
+        Internal::AtomicFile atomicFile;
+        if (!atomicFile.open(path) || !atomicFile.write(content.data(), content.size()) || !atomicFile.commit())
+            return false;
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        Entry& entry = _entries[key];
+        _size = _size - entry._size + content.size();
+        entry._size = content.size();
+        entry._lastUse = static_cast<int64_t>(time(nullptr));
+        evict();
+        return true;
+    }
+
+    void DerivedDataCache::clear()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        while (!_entries.empty())
+        {
+            remove(_entries.begin()->first);
+        }
+    }
+
+    std::string DerivedDataCache::getPath(const std::string& key) const
+    {
+        return _directory + key + BinaryScene::getFileExtension();
+    }
+
+    void DerivedDataCache::evict()
+    {
+        if (_size <= _sizeLimit)
+            return;
+
+        std::vector<std::pair<int64_t, std::string>> entries;
+        entries.reserve(_entries.size());
+        for (const auto& [key, entry] : _entries)
+        {
+            entries.emplace_back(entry._lastUse, key);
+        }
+
+        std::sort(entries.begin(), entries.end());
+        for (size_t i = 0; i < entries.size() && _size > _sizeLimit; i++)
+        {
+            remove(entries[i].second);
+        }
+    }
+
+    void DerivedDataCache::remove(const std::string& key)
+    {
+        std::unordered_map<std::string, Entry>::iterator it = _entries.find(key);
+        if (it == _entries.end())
+            return;
+
+        std::remove(getPath(key).c_str());
+        _size -= it->second._size;
+        _entries.erase(it);
+    }
+}
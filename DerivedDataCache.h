@@ -0,0 +1,72 @@
+#ifndef __CCIMEDITOR_DERIVEDDATACACHE_H__
+#define __CCIMEDITOR_DERIVEDDATACACHE_H__
+
+#include "cocos2d.h"
+
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <cstdint>
+
+namespace CCImEditor
+{
+    // Binary scenes (.ccbin) decoded from json and plist files, kept on disk between sessions
+    // under getWritablePath() + "cc_imgui_editor/derived_data". Entries are named after a hash
+    // of the content of their source, so an edited file simply gets a new entry and nothing
+    // has to be invalidated. Once the entries grow over the size limit, the least recently
+    // used ones are removed.
+    //
+    // The cache is disabled until setEnabled is called from the main thread, the other
+    // methods can be called from any thread.
+    class DerivedDataCache
+    {
+    public:
+        static DerivedDataCache* getInstance();
+
+        // Creates the directory and reads the existing entries when enabled
+        void setEnabled(bool enabled);
+        bool isEnabled() const { return _isEnabled; };
+
+        void setSizeLimit(uint64_t bytes);
+        uint64_t getSizeLimit() const { return _sizeLimit; };
+        uint64_t getSize();
+
+        // Key of the content of a source file
+        static std::string getKey(const uint8_t* data, size_t size);
+
+        // Full path of the binary scene stored for key, empty if there is none
+        std::string find(const std::string& key);
+
+        // Same as find, decoding the binary scene into out
+        bool load(const std::string& key, cocos2d::ValueMap& out);
+
+        bool store(const std::string& key, const cocos2d::ValueMap& description);
+
+        void clear();
+
+    private:
+        DerivedDataCache() {};
+        DerivedDataCache(const DerivedDataCache&) = delete;
+        void operator=(const DerivedDataCache&) = delete;
+
+        std::string getPath(const std::string& key) const;
+        void evict();
+        void remove(const std::string& key);
+
+        struct Entry
+        {
+            uint64_t _size = 0;
+            int64_t _lastUse = 0;
+        };
+
+        std::mutex _mutex;
+        std::atomic<bool> _isEnabled{false};
+        std::string _directory;
+        std::unordered_map<std::string, Entry> _entries;
+        uint64_t _size = 0;
+        uint64_t _sizeLimit = 256 * 1024 * 1024;
+    };
+}
+
+#endif
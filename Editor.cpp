@@ -1,10 +1,24 @@
 #include "Editor.h"
 #include "ComponentFactory.h"
 #include "NodeFactory.h"
+#include "NodeProxies.h"
 #include "WidgetFactory.h"
 #include "imgui.h"
 #include "imgui_internal.h"
 #include "ImGuiHelper.h"
+#include "BinaryScene.h"
+#include "MappedFile.h"
+#include "JsonReader.h"
+#include "PrefabCache.h"
+#include "ThreadPool.h"
+#include "SceneWriter.h"
+#include "SceneFragment.h"
+#include "SceneMerge.h"
+#include "DerivedDataCache.h"
+#include "AssetPack.h"
+#include "CsbExporter.h"
+#include "SceneCompiler.h"
+#include "ChunkExporter.h"
 #include "widgets/ImGuiDemo.h"
 #include "widgets/NodeProperties.h"
 #include "widgets/NodeTree.h"
@@ -36,23 +50,72 @@
 #include "platform/desktop/CCGLViewImpl-desktop.h"
 #endif
 
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <unordered_map>
+
 namespace CCImEditor
 {
     namespace
     {
         cocos2d::RefPtr<Editor> s_instance;
 
-        cocos2d::Node* getSelectedNode()
+        // Time spent creating nodes per frame while opening a file
+        const std::chrono::milliseconds s_openFileTimeBudget(8);
+
+        // Longer reports are cut in the alert popup, the console has all of them
+        const size_t s_maxAlertLines = 20;
+
+        const float s_defaultChunkSize = 1000.0f;
+
+        const int s_sessionVersion = 1;
+
+        // Next to last_session.ini
+        std::string getSessionFile()
         {
-            if (cocos2d::Ref* obj = Editor::getInstance()->getUserObject("CCImGuiWidgets.NodeTree.SelectedNode"))
-            {
-                CC_ASSERT(dynamic_cast<cocos2d::Node*>(obj));
-                return static_cast<cocos2d::Node*>(obj);
-            }
-            
-            return nullptr;
+            return cocos2d::FileUtils::getInstance()->getWritablePath() + "cc_imgui_editor/last_session" + BinaryScene::getFileExtension();
         }
 
+        // Modification time and size of a file as strings, values have no 64-bit integers
+        void getFileStatus(const std::string& fullPath, std::string& modificationTime, std::string& size)
+        {
+            int64_t modificationTimeValue, sizeValue;
+            PrefabCache::getFileStatus(fullPath, modificationTimeValue, sizeValue);
+            modificationTime = std::to_string(modificationTimeValue);
+            size = std::to_string(sizeValue);
+        }
+
+        cocos2d::Value toValue(const cocos2d::Vec3& vec)
+        {
+            cocos2d::ValueVector v;
+            v.push_back(cocos2d::Value(vec.x));
+            v.push_back(cocos2d::Value(vec.y));
+            v.push_back(cocos2d::Value(vec.z));
+            return cocos2d::Value(std::move(v));
+        }
+
+        bool fromValue(const cocos2d::Value& value, cocos2d::Vec3& vec)
+        {
+            if (value.getType() != cocos2d::Value::Type::VECTOR || value.asValueVector().size() != 3)
+                return false;
+
+            const cocos2d::ValueVector& v = value.asValueVector();
+            vec.set(v[0].asFloat(), v[1].asFloat(), v[2].asFloat());
+            return true;
+        }
+
+        // Recent files decoded in the background, and the memory their descriptions may use
+        const int s_defaultPrefetchCount = 3;
+        const int s_defaultPrefetchSizeMB = 64;
+
+        const int s_defaultUndoMemoryMB = 64;
+
+        // Smaller trees are serialized on the main thread alone
+        const size_t s_parallelSerializationMinNodes = 2048;
+
+        const std::string s_selectedNodePath = "CCImGuiWidgets.NodeTree.SelectedNode";
+
         void addNode(cocos2d::Node* parent, cocos2d::Node* child)
         {
             AddNode* command = AddNode::create(parent, child);
@@ -94,6 +157,16 @@ namespace CCImEditor
             Editor::getInstance()->getCommandHistory().queue(command);
         }
 
+        // Pasted or imported nodes are copies and must not share the ids of their source
+        void regenerateIds(cocos2d::Node* node)
+        {
+            Internal::performRecursively(node, [](cocos2d::Node* child)
+            {
+                if (NodeImDrawer* drawer = child->getComponent<NodeImDrawer>())
+                    drawer->setId(NodeImDrawer::generateId());
+            });
+        }
+
         bool canHaveChildren(cocos2d::Node* node)
         {
             if (node)
@@ -108,16 +181,10 @@ namespace CCImEditor
         }
 
 
-        bool serializeNode(cocos2d::Node* node, cocos2d::ValueMap& target)
+        void serializeNodeWithoutChildren(NodeImDrawer* drawer, cocos2d::ValueMap& target)
         {
-            if (!node)
-                return false;
-
-            NodeImDrawer* drawer = node->getComponent<NodeImDrawer>();
-            if (!drawer)
-                return false;
-
             target.emplace("type", drawer->getTypeName());
+            target.emplace("id", drawer->getId());
 
             if (!drawer->getFilename().empty())
             {
@@ -126,29 +193,18 @@ namespace CCImEditor
 
             cocos2d::ValueMap properties;
             drawer->serialize(properties);
+
+            // Prefab instances are created from the prefab and not from a new node,
+            // all of their values are kept to override those of the prefab
+            if (drawer->getFilename().empty())
+                drawer->getNodeType()->removeDefaultProperties(properties);
+
             target.emplace("properties", cocos2d::Value(std::move(properties)));
 
             cocos2d::ValueMap animations;
             drawer->getNodePropertyGroup()->serializeAnimations(animations);
             target.emplace("animations", cocos2d::Value(std::move(animations)));
 
-            // For node loaded from file, don't serialize recursively
-            if (drawer->getFilename().empty())
-            {
-                cocos2d::ValueVector childrenVal;
-                cocos2d::Vector<cocos2d::Node*>& children = node->getChildren();
-                for (cocos2d::Node* child: children)
-                {
-                    cocos2d::ValueMap childVal;
-                    if (serializeNode(child, childVal))
-                    {
-                        childrenVal.push_back(cocos2d::Value(std::move(childVal)));
-                    }
-                }
-
-                target.emplace("children", cocos2d::Value(std::move(childrenVal)));
-            }
-
             cocos2d::ValueMap componentsVal;
             const std::map<std::string, cocos2d::RefPtr<ImPropertyGroup>>& components = drawer->getComponentPropertyGroups();
             for (const auto& [name, component]: components)
@@ -167,30 +223,242 @@ namespace CCImEditor
                 componentsVal.emplace(name, std::move(componentVal));
             }
             target.emplace("components", cocos2d::Value(std::move(componentsVal)));
+        }
+
+        const std::shared_ptr<const cocos2d::ValueMap>& getSerializedCache(NodeImDrawer* drawer)
+        {
+            if (drawer->isDirty())
+            {
+                std::shared_ptr<cocos2d::ValueMap> fragment = std::make_shared<cocos2d::ValueMap>();
+                serializeNodeWithoutChildren(drawer, *fragment);
+                drawer->setSerializedCache(std::move(fragment));
+            }
+
+            return drawer->getSerializedCache();
+        }
+
+        // Only dirty nodes are serialized again, and only the subtrees holding them get new
+        // fragments. The others are shared with the previous serialization, not copied.
+        // Runs on worker threads once prepareSerialization is done, see serializeNode.
+        std::shared_ptr<const SceneFragment> serializeSubtree(cocos2d::Node* node)
+        {
+            NodeImDrawer* drawer = node ? node->getComponent<NodeImDrawer>() : nullptr;
+            if (!drawer)
+                return nullptr;
+
+            if (drawer->getSubtreeCache())
+                return drawer->getSubtreeCache();
+
+            std::shared_ptr<SceneFragment> fragment = std::make_shared<SceneFragment>();
+            fragment->_node = getSerializedCache(drawer);
+
+            // For node loaded from file, don't serialize recursively
+            fragment->_hasChildren = drawer->getFilename().empty();
+            if (fragment->_hasChildren)
+            {
+                for (cocos2d::Node* child : node->getChildren())
+                {
+                    if (std::shared_ptr<const SceneFragment> childFragment = serializeSubtree(child))
+                        fragment->_children.push_back(std::move(childFragment));
+                }
+            }
+
+            drawer->setSubtreeCache(fragment);
+            return fragment;
+        }
+
+        bool hasThreadSafeGetters(NodeImDrawer* drawer)
+        {
+            if (!drawer->getNodePropertyGroup()->hasThreadSafeGetters())
+                return false;
+
+            for (const auto& [name, component] : drawer->getComponentPropertyGroups())
+            {
+                if (!component->hasThreadSafeGetters())
+                    return false;
+            }
+
             return true;
         }
 
-        bool deserializeNode(cocos2d::Node** node, const cocos2d::ValueMap& source)
+        // Main thread snapshot before the fan out: dirty nodes with getters which are not
+        // thread-safe are serialized, and the default values the others are compared with
+        // are created. Returns the number of nodes serializeSubtree visits, subtreeSizes
+        // gets it for the nodes with children. Subtrees with a cache hold no dirty node and
+        // are not visited.
+        size_t prepareSerialization(cocos2d::Node* node, std::unordered_map<cocos2d::Node*, size_t>& subtreeSizes)
         {
-            cocos2d::ValueMap::const_iterator typeIt = source.find("type");
-            if (typeIt == source.end() || typeIt->second.getType() != cocos2d::Value::Type::STRING)
+            NodeImDrawer* drawer = node->getComponent<NodeImDrawer>();
+            if (!drawer)
+                return 0;
+
+            if (drawer->getSubtreeCache())
+                return 1;
+
+            // Children are sorted by their local z order when drawn. Sort them now, the
+            // fragment cached for this node would keep the old order otherwise.
+            node->sortAllChildren();
+
+            if (drawer->isDirty())
+            {
+                if (!hasThreadSafeGetters(drawer))
+                {
+                    getSerializedCache(drawer);
+                }
+                else if (drawer->getFilename().empty())
+                {
+                    drawer->getNodeType()->getDefaultProperties();
+                }
+            }
+
+            if (!drawer->getFilename().empty() || node->getChildrenCount() == 0)
+                return 1;
+
+            size_t count = 1;
+            for (cocos2d::Node* child : node->getChildren())
+            {
+                count += prepareSerialization(child, subtreeSizes);
+            }
+
+            subtreeSizes[node] = count;
+            return count;
+        }
+
+        // Splits the serialization of a tree into batches of subtrees of about the same size.
+        // Nodes with larger subtrees are serialized by split itself, with the children vector
+        // sized up front so that the batches write to slots which do not move.
+        class ParallelSerialization
+        {
+        public:
+            ParallelSerialization(size_t batchSize, const std::unordered_map<cocos2d::Node*, size_t>& subtreeSizes)
+            : _batchSize(batchSize)
+            , _subtreeSizes(subtreeSizes)
+            , _batches(1)
+            {
+            }
+
+            void split(cocos2d::Node* node, std::shared_ptr<const SceneFragment>& target)
+            {
+                std::unordered_map<cocos2d::Node*, size_t>::const_iterator sizeIt = _subtreeSizes.find(node);
+                const size_t subtreeSize = sizeIt != _subtreeSizes.end() ? sizeIt->second : 1;
+                if (subtreeSize <= _batchSize)
+                {
+                    _batches.back().push_back({node, &target});
+                    _batchNodes += subtreeSize;
+                    if (_batchNodes >= _batchSize)
+                    {
+                        _batches.emplace_back();
+                        _batchNodes = 0;
+                    }
+                    return;
+                }
+
+                // Filled by the batches before anything reads it, in run
+                NodeImDrawer* drawer = node->getComponent<NodeImDrawer>();
+                std::shared_ptr<SceneFragment> fragment = std::make_shared<SceneFragment>();
+                fragment->_node = getSerializedCache(drawer);
+                fragment->_hasChildren = true;
+
+                std::vector<cocos2d::Node*> children;
+                for (cocos2d::Node* child : node->getChildren())
+                {
+                    if (child->getComponent<NodeImDrawer>())
+                        children.push_back(child);
+                }
+
+                fragment->_children.resize(children.size());
+                for (size_t i = 0; i < children.size(); i++)
+                {
+                    split(children[i], fragment->_children[i]);
+                }
+
+                drawer->setSubtreeCache(fragment);
+                target = std::move(fragment);
+            }
+
+            // The last batch runs on the calling thread
+            void run()
+            {
+                std::vector<std::future<void>> results;
+                for (size_t i = 0; i + 1 < _batches.size(); i++)
+                {
+                    results.push_back(Internal::ThreadPool::getInstance()->enqueue([batch = &_batches[i]]()
+                    {
+                        serializeBatch(*batch);
+                    }));
+                }
+
+                serializeBatch(_batches.back());
+                for (std::future<void>& result : results)
+                {
+                    result.get();
+                }
+            }
+
+        private:
+            typedef std::vector<std::pair<cocos2d::Node*, std::shared_ptr<const SceneFragment>*>> Batch;
+
+            static void serializeBatch(const Batch& batch)
+            {
+                for (const auto& [node, target] : batch)
+                {
+                    *target = serializeSubtree(node);
+                }
+            }
+
+            size_t _batchSize;
+            const std::unordered_map<cocos2d::Node*, size_t>& _subtreeSizes;
+            std::vector<Batch> _batches;
+            size_t _batchNodes = 0;
+        };
+
+        // Sibling subtrees of large trees are serialized on the worker threads while the
+        // main thread waits, so that the scene graph does not change meanwhile
+        std::shared_ptr<const SceneFragment> serializeNode(cocos2d::Node* node)
+        {
+            if (!node || !node->getComponent<NodeImDrawer>())
+                return nullptr;
+
+            std::unordered_map<cocos2d::Node*, size_t> subtreeSizes;
+            const size_t nodeCount = prepareSerialization(node, subtreeSizes);
+            const size_t threadCount = Internal::ThreadPool::getInstance()->getThreadCount();
+            if (nodeCount < s_parallelSerializationMinNodes || threadCount == 0)
+                return serializeSubtree(node);
+
+            // A few batches per thread even out subtrees which take longer
+            std::shared_ptr<const SceneFragment> root;
+            ParallelSerialization serialization(std::max<size_t>(nodeCount / ((threadCount + 1) * 4), 1), subtreeSizes);
+            serialization.split(node, root);
+            serialization.run();
+            return root;
+        }
+
+        // A copy of the fragments, for the callers which edit or walk the description
+        bool serializeNode(cocos2d::Node* node, cocos2d::ValueMap& target)
+        {
+            std::shared_ptr<const SceneFragment> fragment = serializeNode(node);
+            if (!fragment)
                 return false;
 
-            std::string file;
-            cocos2d::ValueMap::const_iterator fileIt = source.find("file");
-            if (fileIt != source.end() && fileIt->second.getType() == cocos2d::Value::Type::STRING)
-                file = fileIt->second.asString();
+            fragment->toValueMap(target);
+            return true;
+        }
+
+        bool deserializeNode(cocos2d::Node** node, const cocos2d::ValueMap& source);
 
+        cocos2d::Node* createNode(const std::string& type, const std::string& file)
+        {
+            cocos2d::Node* node = nullptr;
             if (!file.empty())
             {
-                *node = Editor::loadFile(file);
-                if (*node)
+                std::shared_ptr<const cocos2d::ValueMap> description = PrefabCache::getInstance()->getDescription(file);
+                if (description && deserializeNode(&node, *description))
                 {
-                    NodeImDrawer* drawer = (*node)->getComponent<NodeImDrawer>();
-                    if (drawer->getTypeName() != typeIt->second.asString())
+                    NodeImDrawer* drawer = node->getComponent<NodeImDrawer>();
+                    if (drawer->getTypeName() != type)
                     {
                         CCLOGWARN("Types do not match when loading %s, discard", file.c_str());
-                        *node = nullptr;
+                        node = nullptr;
                     }
                     else
                     {
@@ -203,16 +471,66 @@ namespace CCImEditor
                 }
             }
 
-            if (!*node)
-                *node = NodeFactory::getInstance()->createNode(typeIt->second.asString());
+            if (!node)
+                node = NodeFactory::getInstance()->createNode(type);
+
+            return node;
+        }
+
+        void deserializeComponent(cocos2d::Node* node, const std::string& name, const cocos2d::ValueMap& componentValMap)
+        {
+            cocos2d::ValueMap::const_iterator typeIt = componentValMap.find("type");
+            if (typeIt == componentValMap.end() || typeIt->second.getType() != cocos2d::Value::Type::STRING)
+                return;
+
+            ImPropertyGroup* component = ComponentFactory::getInstance()->createComponent(typeIt->second.asString());
+            if (!component)
+                return;
 
+            cocos2d::ValueMap::const_iterator propertiesIt = componentValMap.find("properties");
+            if (propertiesIt != componentValMap.end() && propertiesIt->second.getType() == cocos2d::Value::Type::MAP)
+            {
+                component->deserialize(propertiesIt->second.asValueMap());
+            }
+
+            cocos2d::ValueMap::const_iterator animationsIt = componentValMap.find("animations");
+            if (animationsIt != componentValMap.end() && animationsIt->second.getType() == cocos2d::Value::Type::MAP)
+            {
+                component->deserializeAnimations(animationsIt->second.asValueMap());
+            }
+
+            cocos2d::Component* owner = static_cast<cocos2d::Component*>(component->getOwner());
+            owner->setName(name);
+            node->addComponent(owner);
+
+            NodeImDrawer* drawer = node->getComponent<NodeImDrawer>();
+            drawer->setComponentPropertyGroup(name, component);
+        }
+
+        // Creates the node described by source, its children are left to the caller
+        bool deserializeNodeWithoutChildren(cocos2d::Node** node, const cocos2d::ValueMap& source)
+        {
+            cocos2d::ValueMap::const_iterator typeIt = source.find("type");
+            if (typeIt == source.end() || typeIt->second.getType() != cocos2d::Value::Type::STRING)
+                return false;
+
+            std::string file;
+            cocos2d::ValueMap::const_iterator fileIt = source.find("file");
+            if (fileIt != source.end() && fileIt->second.getType() == cocos2d::Value::Type::STRING)
+                file = fileIt->second.asString();
+
+            *node = createNode(typeIt->second.asString(), file);
             if (!*node)
                 return false;
 
+            NodeImDrawer* drawer = (*node)->getComponent<NodeImDrawer>();
+            cocos2d::ValueMap::const_iterator idIt = source.find("id");
+            if (idIt != source.end() && idIt->second.getType() == cocos2d::Value::Type::STRING)
+                drawer->setId(idIt->second.asString());
+
             cocos2d::ValueMap::const_iterator propertiesIt = source.find("properties");
             if (propertiesIt != source.end() && propertiesIt->second.getType() == cocos2d::Value::Type::MAP)
             {
-                NodeImDrawer* drawer = (*node)->getComponent<NodeImDrawer>();
                 drawer->deserialize(propertiesIt->second.asValueMap());
             }
 
@@ -222,156 +540,723 @@ namespace CCImEditor
                 const cocos2d::ValueMap& componentsVal = componentsIt->second.asValueMap();
                 for (const auto& [name, componentVal]: componentsVal)
                 {
-                    if (componentVal.getType() != cocos2d::Value::Type::MAP)
-                        continue;
+                    if (componentVal.getType() == cocos2d::Value::Type::MAP)
+                        deserializeComponent(*node, name, componentVal.asValueMap());
+                }
+            }
+
+            cocos2d::ValueMap::const_iterator animationsIt = source.find("animations");
+            if (animationsIt != source.end() && animationsIt->second.getType() == cocos2d::Value::Type::MAP)
+            {
+                drawer->getNodePropertyGroup()->deserializeAnimations(animationsIt->second.asValueMap());
+            }
+
+            return true;
+        }
+
+        const cocos2d::ValueVector* getChildrenDescription(const cocos2d::ValueMap& source)
+        {
+            cocos2d::ValueMap::const_iterator childrenIt = source.find("children");
+            if (childrenIt != source.end() && childrenIt->second.getType() == cocos2d::Value::Type::VECTOR)
+                return &childrenIt->second.asValueVector();
+
+            return nullptr;
+        }
+
+        // Called from worker threads
+        size_t countNodes(const cocos2d::ValueMap& source)
+        {
+            size_t count = 1;
+            if (const cocos2d::ValueVector* children = getChildrenDescription(source))
+            {
+                for (const cocos2d::Value& childVal: *children)
+                {
+                    if (childVal.getType() == cocos2d::Value::Type::MAP)
+                        count += countNodes(childVal.asValueMap());
+                }
+            }
+
+            return count;
+        }
+
+        bool deserializeNode(cocos2d::Node** node, const cocos2d::ValueMap& source)
+        {
+            if (!deserializeNodeWithoutChildren(node, source))
+                return false;
+
+            cocos2d::ValueMap::const_iterator childrenIt = source.find("children");
+            if (childrenIt != source.end() && childrenIt->second.getType() == cocos2d::Value::Type::VECTOR)
+            {
+                const cocos2d::ValueVector& childrenVal = childrenIt->second.asValueVector();
+                for (const cocos2d::Value& childVal: childrenVal)
+                {
+                    if (childVal.getType() == cocos2d::Value::Type::MAP)
+                    {
+                        cocos2d::Node* child = nullptr;
+                        if (deserializeNode(&child, childVal.asValueMap()))
+                        {
+                            (*node)->addChild(child);
+                        }
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        // Same as above but reads the mapped binary scene in place. Only the properties,
+        // components and animations of one node are materialized at a time.
+        bool deserializeNodeWithoutChildren(cocos2d::Node** node, const BinaryScene::ValueRef& source)
+        {
+            const char* type = source.find("type").asCString();
+            if (!type)
+                return false;
+
+            *node = createNode(type, source.find("file").asString());
+            if (!*node)
+                return false;
+
+            NodeImDrawer* drawer = (*node)->getComponent<NodeImDrawer>();
+            BinaryScene::ValueRef idRef = source.find("id");
+            if (idRef.isString())
+                drawer->setId(idRef.asString());
+
+            BinaryScene::ValueRef propertiesRef = source.find("properties");
+            if (propertiesRef.isMap())
+            {
+                drawer->deserialize(propertiesRef.toValueMap());
+            }
+
+            BinaryScene::ValueRef componentsRef = source.find("components");
+            componentsRef.forEach([node](const char* name, const BinaryScene::ValueRef& componentRef)
+            {
+                if (componentRef.isMap())
+                    deserializeComponent(*node, name, componentRef.toValueMap());
+            });
+
+            BinaryScene::ValueRef animationsRef = source.find("animations");
+            if (animationsRef.isMap())
+            {
+                drawer->getNodePropertyGroup()->deserializeAnimations(animationsRef.toValueMap());
+            }
+
+            return true;
+        }
+
+        // Called from worker threads
+        size_t countNodes(const BinaryScene::ValueRef& source)
+        {
+            size_t count = 1;
+            BinaryScene::ValueRef childrenRef = source.find("children");
+            const uint32_t childCount = childrenRef.isVector() ? childrenRef.getCount() : 0;
+            for (uint32_t i = 0; i < childCount; i++)
+            {
+                BinaryScene::ValueRef childRef = childrenRef.at(i);
+                if (childRef.isMap())
+                    count += countNodes(childRef);
+            }
+
+            return count;
+        }
+
+        bool deserializeNode(cocos2d::Node** node, const BinaryScene::ValueRef& source)
+        {
+            if (!deserializeNodeWithoutChildren(node, source))
+                return false;
+
+            BinaryScene::ValueRef childrenRef = source.find("children");
+            const uint32_t childCount = childrenRef.isVector() ? childrenRef.getCount() : 0;
+            for (uint32_t i = 0; i < childCount; i++)
+            {
+                BinaryScene::ValueRef childRef = childrenRef.at(i);
+                if (childRef.isMap())
+                {
+                    cocos2d::Node* child = nullptr;
+                    if (deserializeNode(&child, childRef))
+                    {
+                        (*node)->addChild(child);
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        // Pre-scans of the scene for PrefabCache::preload, they only look at "file" and "children"
+        void collectPrefabFiles(const BinaryScene::ValueRef& source, std::vector<std::string>& files)
+        {
+            BinaryScene::ValueRef fileRef = source.find("file");
+            if (fileRef.isString())
+                files.push_back(fileRef.asString());
+
+            BinaryScene::ValueRef childrenRef = source.find("children");
+            const uint32_t childCount = childrenRef.isVector() ? childrenRef.getCount() : 0;
+            for (uint32_t i = 0; i < childCount; i++)
+            {
+                BinaryScene::ValueRef childRef = childrenRef.at(i);
+                if (childRef.isMap())
+                    collectPrefabFiles(childRef, files);
+            }
+        }
+
+        bool collectPrefabFiles(Internal::JsonReader& reader, std::vector<std::string>& files)
+        {
+            if (!reader.beginObject())
+                return false;
+
+            std::string_view key;
+            while (reader.nextMember(key))
+            {
+                bool ok = false;
+                if (key == "file" && reader.peek() == Internal::JsonReader::Token::STRING)
+                {
+                    files.emplace_back();
+                    ok = reader.readString(files.back());
+                }
+                else if (key == "children" && reader.peek() == Internal::JsonReader::Token::ARRAY)
+                {
+                    ok = reader.beginArray();
+                    while (ok && reader.nextElement())
+                    {
+                        if (reader.peek() == Internal::JsonReader::Token::OBJECT)
+                            ok = collectPrefabFiles(reader, files);
+                        else
+                            ok = reader.skipValue();
+                    }
+
+                    ok = ok && !reader.hasError();
+                }
+                else
+                {
+                    ok = reader.skipValue();
+                }
+
+                if (!ok)
+                    return false;
+            }
+
+            return !reader.hasError();
+        }
+
+        // Called from worker threads
+        bool countNodes(Internal::JsonReader& reader, size_t& count)
+        {
+            if (!reader.beginObject())
+                return false;
+
+            count++;
+            std::string_view key;
+            while (reader.nextMember(key))
+            {
+                bool ok = false;
+                if (key == "children" && reader.peek() == Internal::JsonReader::Token::ARRAY)
+                {
+                    ok = reader.beginArray();
+                    while (ok && reader.nextElement())
+                    {
+                        if (reader.peek() == Internal::JsonReader::Token::OBJECT)
+                            ok = countNodes(reader, count);
+                        else
+                            ok = reader.skipValue();
+                    }
+
+                    ok = ok && !reader.hasError();
+                }
+                else
+                {
+                    ok = reader.skipValue();
+                }
+
+                if (!ok)
+                    return false;
+            }
+
+            return !reader.hasError();
+        }
+
+        cocos2d::Node* loadBinaryScene(const std::string& file)
+        {
+            Internal::MappedFile mappedFile;
+            BinaryScene::Reader reader;
+            if (!mappedFile.open(file) || !reader.init(mappedFile.getData(), mappedFile.getSize()))
+            {
+                CCLOGWARN("Failed to read binary scene %s", file.c_str());
+                return nullptr;
+            }
+
+            std::vector<std::string> prefabFiles;
+            collectPrefabFiles(reader.getRoot(), prefabFiles);
+            PrefabCache::getInstance()->preload(prefabFiles);
+
+            cocos2d::Node* node = nullptr;
+            if (deserializeNode(&node, reader.getRoot()))
+                return node;
+
+            return nullptr;
+        }
+
+        bool readStringMember(Internal::JsonReader& reader, std::string& out)
+        {
+            if (reader.peek() == Internal::JsonReader::Token::STRING)
+                return reader.readString(out);
+
+            return reader.skipValue();
+        }
+
+        // Skips an object member, remembering where it starts to come back to it once the
+        // group it goes into exists
+        bool skipObjectMember(Internal::JsonReader& reader, size_t& offset)
+        {
+            if (reader.peek() == Internal::JsonReader::Token::OBJECT)
+                offset = reader.getOffset();
+
+            return reader.skipValue();
+        }
+
+        bool deserializeAnimations(ImPropertyGroup* group, const Internal::JsonReader& reader, size_t offset)
+        {
+            if (offset == SIZE_MAX)
+                return true;
+
+            Internal::JsonReader animationsReader = reader.readerAt(offset);
+            cocos2d::Value animations;
+            if (!animationsReader.readValue(animations))
+                return false;
+
+            if (animations.getType() == cocos2d::Value::Type::MAP)
+                group->deserializeAnimations(animations.asValueMap());
+            else
+                CCLOGWARN("Unexpected value type: %d for animations of %s", animations.getType(), group->getTypeName().c_str());
+            return true;
+        }
+
+        bool deserializeComponent(cocos2d::Node* node, const std::string& name, Internal::JsonReader& reader)
+        {
+            if (!reader.beginObject())
+                return false;
+
+            std::string type;
+            size_t propertiesOffset = SIZE_MAX;
+            size_t animationsOffset = SIZE_MAX;
+
+            std::string_view key;
+            while (reader.nextMember(key))
+            {
+                bool ok = false;
+                if (key == "type")
+                    ok = readStringMember(reader, type);
+                else if (key == "properties")
+                    ok = skipObjectMember(reader, propertiesOffset);
+                else if (key == "animations")
+                    ok = skipObjectMember(reader, animationsOffset);
+                else
+                    ok = reader.skipValue();
+
+                if (!ok)
+                    return false;
+            }
+
+            if (reader.hasError())
+                return false;
+
+            ImPropertyGroup* component = ComponentFactory::getInstance()->createComponent(type);
+            if (!component)
+                return true;
+
+            if (propertiesOffset != SIZE_MAX)
+            {
+                Internal::JsonReader propertiesReader = reader.readerAt(propertiesOffset);
+                if (!component->deserialize(propertiesReader))
+                    return false;
+            }
+
+            if (!deserializeAnimations(component, reader, animationsOffset))
+                return false;
+
+            cocos2d::Component* owner = static_cast<cocos2d::Component*>(component->getOwner());
+            owner->setName(name);
+            node->addComponent(owner);
+
+            NodeImDrawer* drawer = node->getComponent<NodeImDrawer>();
+            drawer->setComponentPropertyGroup(name, component);
+            return true;
+        }
+
+        // Streams one node out of a json document. The properties, components and animations
+        // of a node are skipped until the node exists, then read again from where they start,
+        // one property value at a time (animations as a whole), so the document itself is never
+        // materialized. Each child object is handed to childFunc(Internal::JsonReader&), which
+        // consumes it and returns false on a read error.
+        template <typename ChildFunc>
+        bool deserializeNodeWithoutChildren(cocos2d::Node** node, Internal::JsonReader& reader, ChildFunc&& childFunc)
+        {
+            if (!reader.beginObject())
+                return false;
+
+            std::string type;
+            std::string id;
+            std::string file;
+            size_t propertiesOffset = SIZE_MAX;
+            size_t componentsOffset = SIZE_MAX;
+            size_t animationsOffset = SIZE_MAX;
+
+            std::string_view key;
+            while (reader.nextMember(key))
+            {
+                bool ok = false;
+                if (key == "type")
+                {
+                    ok = readStringMember(reader, type);
+                }
+                else if (key == "id")
+                {
+                    ok = readStringMember(reader, id);
+                }
+                else if (key == "file")
+                {
+                    ok = readStringMember(reader, file);
+                }
+                else if (key == "properties")
+                {
+                    ok = skipObjectMember(reader, propertiesOffset);
+                }
+                else if (key == "components")
+                {
+                    ok = skipObjectMember(reader, componentsOffset);
+                }
+                else if (key == "animations")
+                {
+                    ok = skipObjectMember(reader, animationsOffset);
+                }
+                else if (key == "children" && reader.peek() == Internal::JsonReader::Token::ARRAY)
+                {
+                    ok = reader.beginArray();
+                    while (ok && reader.nextElement())
+                    {
+                        if (reader.peek() == Internal::JsonReader::Token::OBJECT)
+                            ok = childFunc(reader);
+                        else
+                            ok = reader.skipValue();
+                    }
+
+                    ok = ok && !reader.hasError();
+                }
+                else
+                {
+                    ok = reader.skipValue();
+                }
+
+                if (!ok)
+                    return false;
+            }
+
+            if (reader.hasError() || type.empty())
+                return false;
+
+            *node = createNode(type, file);
+            if (!*node)
+                return false;
+
+            NodeImDrawer* drawer = (*node)->getComponent<NodeImDrawer>();
+            if (!id.empty())
+                drawer->setId(id);
+
+            if (propertiesOffset != SIZE_MAX)
+            {
+                Internal::JsonReader propertiesReader = reader.readerAt(propertiesOffset);
+                if (!drawer->getNodePropertyGroup()->deserialize(propertiesReader))
+                    return false;
+            }
+
+            if (componentsOffset != SIZE_MAX)
+            {
+                Internal::JsonReader componentsReader = reader.readerAt(componentsOffset);
+                if (!componentsReader.beginObject())
+                    return false;
+
+                std::string_view key;
+                while (componentsReader.nextMember(key))
+                {
+                    bool ok = false;
+                    if (componentsReader.peek() == Internal::JsonReader::Token::OBJECT)
+                        ok = deserializeComponent(*node, std::string(key), componentsReader);
+                    else
+                        ok = componentsReader.skipValue();
+
+                    if (!ok)
+                        return false;
+                }
+
+                if (componentsReader.hasError())
+                    return false;
+            }
+
+            return deserializeAnimations(drawer->getNodePropertyGroup(), reader, animationsOffset);
+        }
+
+        // Children are created as soon as they are read and added once their parent exists
+        bool deserializeNode(cocos2d::Node** node, Internal::JsonReader& reader)
+        {
+            cocos2d::Vector<cocos2d::Node*> children;
+            bool created = deserializeNodeWithoutChildren(node, reader, [&children](Internal::JsonReader& childReader)
+            {
+                cocos2d::Node* child = nullptr;
+                if (deserializeNode(&child, childReader))
+                {
+                    children.pushBack(child);
+                }
+                return true;
+            });
+
+            if (!created)
+                return false;
+
+            for (cocos2d::Node* child: children)
+            {
+                (*node)->addChild(child);
+            }
 
-                    const cocos2d::ValueMap& componentValMap = componentVal.asValueMap();
+            return true;
+        }
 
-                    cocos2d::ValueMap::const_iterator typeIt = componentValMap.find("type");
-                    if (typeIt == componentValMap.end() || typeIt->second.getType() != cocos2d::Value::Type::STRING)
-                        continue;
+        // One node of a scene file being opened, which member is set depends on its format
+        struct NodeRef
+        {
+            BinaryScene::ValueRef _binary;
+            size_t _jsonOffset = 0;
+            const cocos2d::ValueMap* _description = nullptr;
+        };
 
-                    ImPropertyGroup* component = ComponentFactory::getInstance()->createComponent(typeIt->second.asString());
-                    if (!component)
-                        continue;
+        // A scene file instantiated a few nodes at a time. Binary and json files stay mapped and
+        // are read in place, only formats read by FileUtils (plist) are decoded as a whole.
+        // Written by the worker thread which opens it until its future is ready.
+        struct SceneFile
+        {
+            Internal::MappedFile _mappedFile;
+            BinaryScene::Reader _reader;
+            cocos2d::ValueMap _description;
+            NodeRef _root;
+            size_t _nodeCount = 0;
+            std::vector<std::string> _prefabFiles;
+
+            Internal::JsonReader getJsonReader(size_t offset) const
+            {
+                return Internal::JsonReader(reinterpret_cast<const char*>(_mappedFile.getData()), _mappedFile.getSize()).readerAt(offset);
+            }
 
-                    cocos2d::ValueMap::const_iterator propertiesIt = componentValMap.find("properties");
-                    if (propertiesIt != componentValMap.end() && propertiesIt->second.getType() == cocos2d::Value::Type::MAP)
-                    {
-                        component->deserialize(propertiesIt->second.asValueMap());
-                    }
+            size_t getMemory() const
+            {
+                return _mappedFile.getSize() + PrefabCache::estimateSize(_description);
+            }
+        };
 
-                    cocos2d::ValueMap::const_iterator animationsIt = componentValMap.find("animations");
-                    if (animationsIt != componentValMap.end() && animationsIt->second.getType() == cocos2d::Value::Type::MAP)
-                    {
-                        component->deserializeAnimations(animationsIt->second.asValueMap());
-                    }
+        // Called from worker threads
+        bool openSceneFile(SceneFile& sceneFile, const std::string& fullPath)
+        {
+            if (!sceneFile._mappedFile.open(fullPath))
+                return false;
 
-                    cocos2d::Component* owner = static_cast<cocos2d::Component*>(component->getOwner());
-                    owner->setName(name);
-                    (*node)->addComponent(owner);
+            const std::string extension = cocos2d::FileUtils::getInstance()->getFileExtension(fullPath);
+            if (extension == BinaryScene::getFileExtension())
+            {
+                if (!sceneFile._reader.init(sceneFile._mappedFile.getData(), sceneFile._mappedFile.getSize()))
+                    return false;
 
-                    NodeImDrawer* drawer = (*node)->getComponent<NodeImDrawer>();
-                    drawer->setComponentPropertyGroup(name, component);
-                }
+                sceneFile._root._binary = sceneFile._reader.getRoot();
+                return true;
             }
 
-            cocos2d::ValueMap::const_iterator animationsIt = source.find("animations");
-            if (animationsIt != source.end() && animationsIt->second.getType() == cocos2d::Value::Type::MAP)
+            // A binary scene decoded from the same content is mapped instead
+            DerivedDataCache* derivedDataCache = DerivedDataCache::getInstance();
+            std::string missedKey;
+            if (derivedDataCache->isEnabled())
             {
-                NodeImDrawer* drawer = (*node)->getComponent<NodeImDrawer>();
-                drawer->getNodePropertyGroup()->deserializeAnimations(animationsIt->second.asValueMap());
+                const std::string key = DerivedDataCache::getKey(sceneFile._mappedFile.getData(), sceneFile._mappedFile.getSize());
+                const std::string cachedFile = derivedDataCache->find(key);
+                if (cachedFile.empty())
+                {
+                    missedKey = key;
+                }
+                else if (sceneFile._mappedFile.open(cachedFile) && sceneFile._reader.init(sceneFile._mappedFile.getData(), sceneFile._mappedFile.getSize()))
+                {
+                    sceneFile._root._binary = sceneFile._reader.getRoot();
+                    return true;
+                }
+                else if (!sceneFile._mappedFile.open(fullPath))
+                {
+                    return false;
+                }
             }
 
-            cocos2d::ValueMap::const_iterator childrenIt = source.find("children");
-            if (childrenIt != source.end() && childrenIt->second.getType() == cocos2d::Value::Type::VECTOR)
+            if (extension == ".json")
             {
-                const cocos2d::ValueVector& childrenVal = childrenIt->second.asValueVector();
-                for (const cocos2d::Value& childVal: childrenVal)
+                // Fills the cache for the next open without holding up this one
+                if (!missedKey.empty())
                 {
-                    if (childVal.getType() == cocos2d::Value::Type::MAP)
+                    Internal::ThreadPool::getInstance()->enqueue([fullPath]()
                     {
-                        cocos2d::Node* child = nullptr;
-                        if (deserializeNode(&child, childVal.asValueMap()))
-                        {
-                            (*node)->addChild(child);
-                        }
-                    }
+                        cocos2d::ValueMap description;
+                        return PrefabCache::decodeFile(fullPath, description);
+                    });
                 }
+
+                sceneFile._root._jsonOffset = 0;
+                return true;
             }
 
+            const char* data = reinterpret_cast<const char*>(sceneFile._mappedFile.getData());
+            sceneFile._description = cocos2d::FileUtils::getInstance()->getValueMapFromData(data, static_cast<int>(sceneFile._mappedFile.getSize()));
+            sceneFile._mappedFile.close();
+            if (sceneFile._description.empty())
+                return false;
+
+            if (!missedKey.empty())
+                derivedDataCache->store(missedKey, sceneFile._description);
+
+            sceneFile._root._description = &sceneFile._description;
             return true;
         }
 
-        class DirectionLightProxy
+        // Called from worker threads, reads what the progress and the prefab preload need
+        // before the first node is created. The whole json document is validated here.
+        bool scanSceneFile(SceneFile& sceneFile)
         {
-        public:
-            static cocos2d::DirectionLight* create()
+            const NodeRef& root = sceneFile._root;
+            if (root._description)
             {
-                return cocos2d::DirectionLight::create(cocos2d::Vec3::UNIT_Z, cocos2d::Color3B::WHITE);
+                sceneFile._nodeCount = countNodes(*root._description);
+                PrefabCache::collectFiles(*root._description, sceneFile._prefabFiles);
+                return true;
             }
-        };
 
-        class PointLightProxy
-        {
-        public:
-            static cocos2d::PointLight* create()
+            if (root._binary.isValid())
             {
-                return cocos2d::PointLight::create(cocos2d::Vec3::ZERO, cocos2d::Color3B::WHITE, 1.0f);
+                if (!root._binary.isMap())
+                    return false;
+
+                sceneFile._nodeCount = countNodes(root._binary);
+                collectPrefabFiles(root._binary, sceneFile._prefabFiles);
+                return true;
             }
-        };
 
-        class AmbientLightProxy
+            Internal::JsonReader reader = sceneFile.getJsonReader(root._jsonOffset);
+            if (!countNodes(reader, sceneFile._nodeCount) || !reader.isFinished())
+                return false;
+
+            Internal::JsonReader scanner = sceneFile.getJsonReader(root._jsonOffset);
+            return collectPrefabFiles(scanner, sceneFile._prefabFiles);
+        }
+
+        // Creates the node at ref, its children are appended to children for the caller
+        bool deserializeNodeWithoutChildren(cocos2d::Node** node, const SceneFile& sceneFile, const NodeRef& ref, std::vector<NodeRef>& children)
         {
-        public:
-            static cocos2d::AmbientLight* create()
+            if (ref._description)
             {
-                return cocos2d::AmbientLight::create(cocos2d::Color3B::WHITE);
+                if (!deserializeNodeWithoutChildren(node, *ref._description))
+                    return false;
+
+                if (const cocos2d::ValueVector* childrenVal = getChildrenDescription(*ref._description))
+                {
+                    for (const cocos2d::Value& childVal: *childrenVal)
+                    {
+                        if (childVal.getType() == cocos2d::Value::Type::MAP)
+                            children.push_back({BinaryScene::ValueRef(), 0, &childVal.asValueMap()});
+                    }
+                }
+                return true;
             }
-        };
 
-        class SpotLightProxy
-        {
-        public:
-            static cocos2d::SpotLight* create()
+            if (ref._binary.isValid())
             {
-                return cocos2d::SpotLight::create(cocos2d::Vec3::UNIT_Z, cocos2d::Vec3::ZERO, cocos2d::Color3B::WHITE, 0.0f, CC_DEGREES_TO_RADIANS(30), 5000.0f);
+                if (!deserializeNodeWithoutChildren(node, ref._binary))
+                    return false;
+
+                BinaryScene::ValueRef childrenRef = ref._binary.find("children");
+                const uint32_t childCount = childrenRef.isVector() ? childrenRef.getCount() : 0;
+                for (uint32_t i = 0; i < childCount; i++)
+                {
+                    BinaryScene::ValueRef childRef = childrenRef.at(i);
+                    if (childRef.isMap())
+                        children.push_back({childRef, 0, nullptr});
+                }
+                return true;
             }
-        };
 
-        class QuadProxy
-        {
-        public:
-            static cocos2d::Sprite3D* create()
+            Internal::JsonReader reader = sceneFile.getJsonReader(ref._jsonOffset);
+            return deserializeNodeWithoutChildren(node, reader, [&children](Internal::JsonReader& childReader)
             {
-                cocos2d::Sprite3D* sprite3D = cocos2d::Sprite3D::create();
-                if (!sprite3D)
-                    return nullptr;
+                children.push_back({BinaryScene::ValueRef(), childReader.getOffset(), nullptr});
+                return childReader.skipValue();
+            });
+        }
 
-                std::vector<float> vertices = {-0.5f, 0.5f, 0.0f, 0.5f, 0.5f, 0.0f, -0.5f, -0.5f, 0.0f, 0.5f, -0.5f, 0.0f};
-                std::vector<float> normals = {0.0, 0.0, 1.0, 0.0, 0.0, 1.0, 0.0, 0.0, 1.0, 0.0, 0.0, 1.0};
-                std::vector<float> uvs = {0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f};
-                std::vector<unsigned short> indices = {0, 2, 1, 2, 3, 1};
-                cocos2d::Mesh* mesh = cocos2d::Mesh::create(vertices, normals, uvs, indices);
-                if (!mesh)
-                    return nullptr;
+        size_t countNodes(const SceneFile& sceneFile, const NodeRef& ref)
+        {
+            if (ref._description)
+                return countNodes(*ref._description);
 
-                sprite3D->addMesh(mesh);
-                sprite3D->genMaterial();
-                return sprite3D;
-            }
-        };
+            if (ref._binary.isValid())
+                return countNodes(ref._binary);
 
-        class CubeProxy
-        {
-        public:
-            static cocos2d::Sprite3D* create()
-            {
-                cocos2d::Sprite3D* sprite3D = cocos2d::Sprite3D::create();
-                if (!sprite3D)
-                    return nullptr;
+            size_t count = 0;
+            Internal::JsonReader reader = sceneFile.getJsonReader(ref._jsonOffset);
+            countNodes(reader, count);
+            return std::max<size_t>(count, 1);
+        }
+    } // namespace
 
-                std::vector<float> vertices = {0.5f, 0.5f, 0.5f, 0.5f, 0.5f, -0.5f, 0.5f, -0.5f, 0.5f, 0.5f, -0.5f, -0.5f, -0.5f, 0.5f, -0.5f, -0.5f, 0.5f, 0.5f, -0.5f, -0.5f, -0.5f, -0.5f, -0.5f, 0.5f, -0.5f, 0.5f, -0.5f, 0.5f, 0.5f, -0.5f, -0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, -0.5f, -0.5f, 0.5f, 0.5f, -0.5f, 0.5f, -0.5f, -0.5f, -0.5f, 0.5f, -0.5f, -0.5f, -0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, -0.5f, -0.5f, 0.5f, 0.5f, -0.5f, 0.5f, 0.5f, 0.5f, -0.5f, -0.5f, 0.5f, -0.5f, 0.5f, -0.5f, -0.5f, -0.5f, -0.5f, -0.5f};
-                std::vector<float> normals = {1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, -1.0f};
-                std::vector<float> uvs = {0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f};
-                std::vector<unsigned short> indices = {0, 2, 1, 2, 3, 1, 4, 6, 5, 6, 7, 5, 8, 10, 9, 10, 11, 9, 12, 14, 13, 14, 15, 13, 16, 18, 17, 18, 19, 17, 20, 22, 21, 22, 23, 21};
-                cocos2d::Mesh* mesh = cocos2d::Mesh::create(vertices, normals, uvs, indices);
-                if (!mesh)
-                    return nullptr;
+    struct Editor::SavingFile
+    {
+        std::string _file;
+        std::string _fullPath;
+        std::shared_ptr<const SceneFragment> _snapshot; // shares the subtree caches of the nodes
+        uint64_t _lastDone = 0; // position of the snapshot in the command history
+        std::future<bool> _result;
+    };
+
+    struct Editor::OpeningFile
+    {
+        std::string _file;
+        std::shared_ptr<SceneFile> _sceneFile; // kept open until the last node is created
+        std::shared_ptr<cocos2d::ValueMap> _session; // the rest of the snapshot when restoring a session
+        std::future<bool> _opened; // valid while opening
+        std::unique_ptr<PrefabCache::Preload> _preload;
 
-                sprite3D->addMesh(mesh);
-                sprite3D->genMaterial();
-                return sprite3D;
-            }
+        struct PendingChildren
+        {
+            cocos2d::Node* _parent;
+            std::vector<NodeRef> _children;
+            size_t _index;
         };
-    } // namespace
+
+        cocos2d::RefPtr<cocos2d::Node> _root;
+        std::vector<PendingChildren> _pendingChildren;
+        size_t _totalNodes = 0;
+        size_t _createdNodes = 0;
+    };
+
+    struct Editor::PrefetchedFile
+    {
+        std::string _file;
+        std::string _fullPath;
+        int64_t _modificationTime;
+        int64_t _size;
+
+        std::shared_ptr<SceneFile> _sceneFile;
+        std::future<bool> _opened; // valid while opening
+        size_t _memory = 0;
+        std::unique_ptr<PrefabCache::Preload> _preload;
+    };
 
     Editor::Editor()
+    : _commandHistory(_eventBus)
     {
     }
     
     Editor::~Editor()
     {
+        // Do not lose a save which is still being written
+        updateSavingFile(true);
     }
 
     Editor* Editor::getInstance()
@@ -415,6 +1300,14 @@ namespace CCImEditor
         std::string settingFile = fileUtil->getWritablePath() + "cc_imgui_editor/settings.plist";
         _settings = fileUtil->getValueMapFromFile(settingFile);
 
+        const int derivedDataCacheSize = cocos2d::UserDefault::getInstance()->getIntegerForKey("cc_imgui_editor.derived_data_cache_mb", 256);
+        DerivedDataCache::getInstance()->setSizeLimit(static_cast<uint64_t>(std::max(derivedDataCacheSize, 0)) * 1024 * 1024);
+        DerivedDataCache::getInstance()->setEnabled(true);
+
+        const int undoMemory = cocos2d::UserDefault::getInstance()->getIntegerForKey("cc_imgui_editor.undo_memory_mb", s_defaultUndoMemoryMB);
+        _commandHistory.setMemoryBudget(static_cast<size_t>(std::max(undoMemory, 1)) * 1024 * 1024);
+        _commandHistory.setSpillFile(fileUtil->getSuitableFOpen(fileUtil->getWritablePath() + "cc_imgui_editor/undo_history" + BinaryScene::getFileExtension()));
+
         setName("Editor");
         return true;
     }
@@ -435,10 +1328,14 @@ namespace CCImEditor
         {
             import(importRuleSet._path, importRuleSet._rules, importRuleSet._recursive);
         }
+
+        restoreSession();
+        startPrefetch();
     }
 
     void Editor::onExit()
     {
+        saveSession();
         Node::onExit();
 
         cocos2d::ImGuiManager* imGuiManager = cocos2d::Director::getInstance()->getImGuiManager();
@@ -463,6 +1360,7 @@ namespace CCImEditor
         }
 
         bool modal = drawFileDialog();
+        modal = drawOpeningFile() || modal;
         if(!modal && !_alertText.empty())
         {
             const char* windowName = "Alert";
@@ -487,6 +1385,9 @@ namespace CCImEditor
         Node::update(dt);
 
         _commandHistory.update(dt);
+        updateOpeningFile();
+        updatePrefetch();
+        updateSavingFile(false);
 
         _widgets.erase(std::remove(_widgets.begin(), _widgets.end(), nullptr), _widgets.end());
         for(Widget* widget : _widgets)
@@ -511,12 +1412,16 @@ namespace CCImEditor
 
     Widget* Editor::getWidget(const std::string& typeName) const
     {
+        const RegisteredType* type = WidgetFactory::getInstance()->getWidgetType(typeName);
+        if (!type)
+            return nullptr;
+
         for(Widget* widget : _widgets)
         {
             if (!widget)
                 continue;
 
-            if (widget->getTypeName() == typeName)
+            if (widget->getType() == type)
                 return widget;
         }
 
@@ -563,6 +1468,20 @@ namespace CCImEditor
     {
         _currentFile = file;
 
+        // The editing node is newer than a prefetched description of the file
+        _prefetchedFiles.erase(std::remove_if(_prefetchedFiles.begin(), _prefetchedFiles.end(),
+            [this, &file](const std::unique_ptr<PrefetchedFile>& prefetchedFile)
+            {
+                if (prefetchedFile->_file != file)
+                    return false;
+
+                if (!prefetchedFile->_opened.valid())
+                    _prefetchedSize -= prefetchedFile->_memory;
+                return true;
+            }),
+            _prefetchedFiles.end()
+        );
+
         cocos2d::Value& recentFilesValue = _settings["recent_files"];
         if (recentFilesValue.getType() != cocos2d::Value::Type::VECTOR)
             recentFilesValue = cocos2d::ValueVector();
@@ -589,35 +1508,230 @@ namespace CCImEditor
         if (file.empty())
             return;
 
-        cocos2d::ValueMap root;
-        if (serializeNode(getEditingNode(), root))
+        // Only the snapshot is taken here, encoding and writing happen in startSaving
+        std::unique_ptr<SavingFile> savingFile(new SavingFile());
+        savingFile->_snapshot = serializeNode(getEditingNode());
+        if (!savingFile->_snapshot)
         {
-            std::string extension = cocos2d::FileUtils::getInstance()->getFileExtension(file);
-            std::string content;
-            if (extension == ".json")
-            {
-                cocos2d::JSON::Option option{1024 * 128, true};
-                content = cocos2d::JSON::encode(cocos2d::Value(std::move(root)), option);
-            }
-            else
-            {
-                content = cocos2d::PList::encode(cocos2d::Value(std::move(root)));
-            }
+            alert("Failed to serialize editing node to file:\n %s", file.c_str());
+            return;
+        }
+
+        savingFile->_file = file;
+        savingFile->_fullPath = cocos2d::FileUtils::getInstance()->getSuitableFOpen(file);
+        savingFile->_lastDone = getCommandHistory().getLastDone();
+
+        // Saves are written in order, a newer snapshot replaces one still waiting
+        if (_savingFile)
+            _nextSavingFile = std::move(savingFile);
+        else
+            startSaving(std::move(savingFile));
+    }
+
+    void Editor::startSaving(std::unique_ptr<SavingFile> savingFile)
+    {
+        const bool compact = cocos2d::UserDefault::getInstance()->getBoolForKey("cc_imgui_editor.compact_output", false);
+        _savingFile = std::move(savingFile);
+        _savingFile->_result = Internal::ThreadPool::getInstance()->enqueue([compact, fullPath = _savingFile->_fullPath, root = std::move(_savingFile->_snapshot)]()
+        {
+            return SceneWriter::writeFile(fullPath, *root, compact);
+        });
+    }
+
+    void Editor::updateSavingFile(bool wait)
+    {
+        while (_savingFile)
+        {
+            if (!wait && _savingFile->_result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                return;
 
-            if (cocos2d::FileUtils::getInstance()->writeStringToFile(content, file))
+            const std::string& file = _savingFile->_file;
+            PrefabCache::getInstance()->invalidate(file);
+            if (_savingFile->_result.get())
             {
                 setCurrentFile(file);
-                getCommandHistory().setSavePoint();
+                getCommandHistory().setSavePoint(_savingFile->_lastDone);
+                _eventBus.publish(EditorEvents::FileSaved{file});
             }
             else
             {
                 alert("Failed to write to file: %s", file.c_str());
             }
+
+            _savingFile.reset();
+            if (_nextSavingFile)
+                startSaving(std::move(_nextSavingFile));
         }
-        else
+    }
+
+    void Editor::compareWithFile(const std::string& file)
+    {
+        cocos2d::ValueMap fileDescription;
+        if (!PrefabCache::decodeFile(cocos2d::FileUtils::getInstance()->fullPathForFilename(file), fileDescription))
         {
-            alert("Failed to serialize editing node to file:\n %s", file.c_str());
+            alert("Failed to load file: %s", file.c_str());
+            return;
+        }
+
+        cocos2d::ValueMap snapshot;
+        if (!serializeNode(getEditingNode(), snapshot))
+            return;
+
+        std::vector<SceneMerge::Change> changes;
+        SceneMerge::diff(fileDescription, snapshot, changes);
+
+        std::vector<std::string> lines;
+        for (const SceneMerge::Change& change : changes)
+            lines.push_back(SceneMerge::toString(change));
+
+        alertReport(cocos2d::StringUtils::format("%zu changes from %s", changes.size(), file.c_str()), lines);
+    }
+
+    void Editor::mergeWithFile(const std::string& file)
+    {
+        cocos2d::FileUtils* fileUtils = cocos2d::FileUtils::getInstance();
+        cocos2d::ValueMap base;
+        cocos2d::ValueMap theirs;
+        if (!PrefabCache::decodeFile(fileUtils->fullPathForFilename(_currentFile), base) || !PrefabCache::decodeFile(fileUtils->fullPathForFilename(file), theirs))
+        {
+            alert("Failed to load %s or %s", _currentFile.c_str(), file.c_str());
+            return;
+        }
+
+        cocos2d::ValueMap ours;
+        if (!serializeNode(getEditingNode(), ours))
+            return;
+
+        cocos2d::ValueMap merged;
+        std::vector<SceneMerge::Conflict> conflicts;
+        SceneMerge::merge(base, ours, theirs, merged, conflicts);
+
+        cocos2d::Node* node = nullptr;
+        if (!deserializeNode(&node, merged))
+        {
+            alert("Failed to create merged scene");
+            return;
+        }
+
+        setEditingNode(node);
+        _commandHistory.clearSavePoint();
+
+        if (!conflicts.empty())
+        {
+            std::vector<std::string> lines;
+            for (const SceneMerge::Conflict& conflict : conflicts)
+                lines.push_back(SceneMerge::toString(conflict));
+
+            alertReport(cocos2d::StringUtils::format("%zu conflicts kept the editing version", conflicts.size()), lines);
+        }
+    }
+
+    void Editor::buildAssetPack(const std::string& file)
+    {
+        // Files are packed in the order the nodes of the scene name them, see addScene
+        AssetPack::Builder builder;
+        if (!builder.addScene(_currentFile) || !builder.write(cocos2d::FileUtils::getInstance()->getSuitableFOpen(file)))
+        {
+            alert("Failed to build asset pack: %s", file.c_str());
+            return;
+        }
+
+        alert("%zu files packed into %s", builder.getFiles().size(), file.c_str());
+    }
+
+    void Editor::exportCsb(const std::string& file)
+    {
+        cocos2d::ValueMap snapshot;
+        if (!serializeNode(getEditingNode(), snapshot))
+            return;
+
+        std::vector<std::string> report;
+        if (!CsbExporter::exportFile(snapshot, cocos2d::FileUtils::getInstance()->getSuitableFOpen(file), report))
+        {
+            alert("Failed to export: %s", file.c_str());
+            return;
+        }
+
+        alertReport(cocos2d::StringUtils::format("Exported %s, %zu notes", file.c_str(), report.size()), report);
+    }
+
+    void Editor::compileScene(const std::string& file)
+    {
+        cocos2d::ValueMap snapshot;
+        if (!serializeNode(getEditingNode(), snapshot))
+            return;
+
+        const std::string fullPath = cocos2d::FileUtils::getInstance()->getSuitableFOpen(file);
+        const size_t slash = fullPath.find_last_of("/\\");
+        const std::string directory = slash != std::string::npos ? fullPath.substr(0, slash + 1) : std::string();
+        const std::string name = SceneCompiler::getName(file);
+
+        std::vector<std::string> report;
+        if (!SceneCompiler::compileToDirectory(snapshot, _currentFile.empty() ? "an unsaved scene" : _currentFile, directory, name, report))
+        {
+            alert("Failed to compile: %s", file.c_str());
+            return;
+        }
+
+        alertReport(cocos2d::StringUtils::format("Compiled %s%s.cpp, %zu notes", directory.c_str(), name.c_str(), report.size()), report);
+    }
+
+    void Editor::exportChunks(const std::string& file)
+    {
+        cocos2d::Node* root = getEditingNode();
+        cocos2d::ValueMap snapshot;
+        if (!serializeNode(root, snapshot))
+            return;
+
+        // Children are serialized in the order of the nodes having a drawer
+        std::vector<ChunkExporter::Item> items;
+        cocos2d::ValueMap::iterator childrenIt = snapshot.find("children");
+        if (childrenIt != snapshot.end() && childrenIt->second.getType() == cocos2d::Value::Type::VECTOR)
+        {
+            cocos2d::ValueVector& childrenVal = childrenIt->second.asValueVector();
+            for (cocos2d::Node* child : root->getChildren())
+            {
+                if (!child->getComponent<NodeImDrawer>() || items.size() >= childrenVal.size())
+                    continue;
+
+                cocos2d::Value& childVal = childrenVal[items.size()];
+                items.push_back({std::move(childVal.asValueMap()), ChunkExporter::getBounds(child, root)});
+            }
+        }
+
+        snapshot.erase("children");
+
+        NodeImDrawer* drawer = root->getComponent<NodeImDrawer>();
+        const bool is3D = drawer->getTypeName() != "CCImEditor.Node2D";
+        const float chunkSize = cocos2d::UserDefault::getInstance()->getFloatForKey("cc_imgui_editor.chunk_size", s_defaultChunkSize);
+        const bool compact = cocos2d::UserDefault::getInstance()->getBoolForKey("cc_imgui_editor.compact_output", false);
+
+        std::vector<std::string> report;
+        if (!ChunkExporter::exportFile(snapshot, items, chunkSize, is3D, compact, cocos2d::FileUtils::getInstance()->getSuitableFOpen(file), report))
+        {
+            alert("Failed to export chunks: %s", file.c_str());
+            return;
+        }
+
+        alertReport(cocos2d::StringUtils::format("Exported %s, %zu notes", file.c_str(), report.size()), report);
+    }
+
+    void Editor::alertReport(const std::string& title, const std::vector<std::string>& lines)
+    {
+        CCLOG("%s", title.c_str());
+
+        std::string text = title;
+        for (size_t i = 0; i < lines.size(); i++)
+        {
+            CCLOG("  %s", lines[i].c_str());
+            if (i < s_maxAlertLines)
+                text += "\n" + lines[i];
         }
+
+        if (lines.size() > s_maxAlertLines)
+            text += cocos2d::StringUtils::format("\n... and %zu more, see console", lines.size() - s_maxAlertLines);
+
+        alert("%s", text.c_str());
     }
 
     void Editor::drawDockSpace()
@@ -706,11 +1820,7 @@ namespace CCImEditor
                 {
                     openLoadFileDialog([this](const std::string& file)
                     {
-                        if (cocos2d::Node* editingNode = Editor::loadFile(file))
-                        {
-                            setEditingNode(editingNode);
-                            setCurrentFile(file);
-                        }
+                        openFile(file);
                     });
                 }
 
@@ -725,11 +1835,7 @@ namespace CCImEditor
                             const std::string& filename = recentFile.asString();
                             if (ImGui::MenuItem(filename.c_str()))
                             {
-                                if (cocos2d::Node* editingNode = Editor::loadFile(filename))
-                                {
-                                    setEditingNode(editingNode);
-                                    setCurrentFile(filename);
-                                }
+                                openFile(filename);
                             }
                         }
                     }
@@ -750,6 +1856,23 @@ namespace CCImEditor
                     });
                 }
 
+                ImGui::Separator();
+                if (ImGui::MenuItem("Compare With..."))
+                {
+                    openLoadFileDialog([this](const std::string& file)
+                    {
+                        compareWithFile(file);
+                    });
+                }
+
+                if (ImGui::MenuItem("Merge With...", nullptr, false, !_currentFile.empty()))
+                {
+                    openLoadFileDialog([this](const std::string& file)
+                    {
+                        mergeWithFile(file);
+                    });
+                }
+
                 ImGui::Separator();
 
                 if (ImGui::MenuItem("Import File..."))
@@ -761,6 +1884,8 @@ namespace CCImEditor
                             if (NodeImDrawer* drawer = importedNode->getComponent<NodeImDrawer>())
                                 drawer->setFilename(file);
 
+                            regenerateIds(importedNode);
+
                             cocos2d::Node* parent = nullptr;
                             if (cocos2d::Node* node = getSelectedNode())
                             {
@@ -768,18 +1893,65 @@ namespace CCImEditor
                                     parent = node;
                             }
 
-                            if (!parent)
-                                parent = Editor::getInstance()->getEditingNode();
-                                
-                            if (parent)
-                                addNode(parent, importedNode);
-                        }
+                            if (!parent)
+                                parent = Editor::getInstance()->getEditingNode();
+                                
+                            if (parent)
+                                addNode(parent, importedNode);
+                        }
+                    });
+                }
+
+                if (ImGui::MenuItem("Build Asset Pack...", nullptr, false, !_currentFile.empty()))
+                {
+                    openSaveFileDialog([this](const std::string& file)
+                    {
+                        buildAssetPack(file);
+                    });
+                }
+
+                if (ImGui::MenuItem("Export CSB..."))
+                {
+                    openSaveFileDialog([this](const std::string& file)
+                    {
+                        exportCsb(file);
+                    });
+                }
+
+                if (ImGui::MenuItem("Compile Scene..."))
+                {
+                    openSaveFileDialog([this](const std::string& file)
+                    {
+                        compileScene(file);
+                    });
+                }
+
+                if (ImGui::MenuItem("Export Chunks..."))
+                {
+                    openSaveFileDialog([this](const std::string& file)
+                    {
+                        exportChunks(file);
                     });
                 }
 
                 if (ImGui::MenuItem("Refresh Assets"))
                 {
                     Internal::clearFileDialogCache();
+                    PrefabCache::getInstance()->invalidateAll();
+                }
+
+                if (ImGui::MenuItem("Clear Derived Data"))
+                {
+                    DerivedDataCache::getInstance()->clear();
+                }
+
+                if (_isDebugMode)
+                {
+                    PrefabCache* prefabCache = PrefabCache::getInstance();
+                    ImGui::TextDisabled("Prefab cache: %u hits, %u misses", prefabCache->getHits(), prefabCache->getMisses());
+                    ImGui::TextDisabled("Derived data: %.1f MB", DerivedDataCache::getInstance()->getSize() / (1024.0 * 1024.0));
+                    ImGui::TextDisabled("Undo history: %zu commands, %.1f MB, %zu on disk", _commandHistory.getSize(), _commandHistory.getMemorySize() / (1024.0 * 1024.0), _commandHistory.getSpilledSize());
+                    ImGui::TextDisabled("Interned strings: %zu", Internal::CustomValueStore::getInternedCount());
                 }
 
                 ImGui::Separator();
@@ -790,7 +1962,45 @@ namespace CCImEditor
                     {
                         cocos2d::UserDefault::getInstance()->setBoolForKey("cc_imgui_editor.debug", _isDebugMode);
                     }
+
+                    bool compactOutput = cocos2d::UserDefault::getInstance()->getBoolForKey("cc_imgui_editor.compact_output", false);
+                    if (ImGui::Checkbox("Compact Output", &compactOutput))
+                    {
+                        cocos2d::UserDefault::getInstance()->setBoolForKey("cc_imgui_editor.compact_output", compactOutput);
+                    }
                     
+                    float chunkSize = cocos2d::UserDefault::getInstance()->getFloatForKey("cc_imgui_editor.chunk_size", s_defaultChunkSize);
+                    if (ImGui::DragFloat("Chunk Size", &chunkSize, 10.0f, 1.0f, 100000.0f))
+                    {
+                        cocos2d::UserDefault::getInstance()->setFloatForKey("cc_imgui_editor.chunk_size", chunkSize);
+                    }
+
+                    bool restoreSession = cocos2d::UserDefault::getInstance()->getBoolForKey("cc_imgui_editor.restore_session", true);
+                    if (ImGui::Checkbox("Restore Last Session", &restoreSession))
+                    {
+                        cocos2d::UserDefault::getInstance()->setBoolForKey("cc_imgui_editor.restore_session", restoreSession);
+                    }
+
+                    // Applied at the next start
+                    int prefetchCount = cocos2d::UserDefault::getInstance()->getIntegerForKey("cc_imgui_editor.prefetch_recent_files", s_defaultPrefetchCount);
+                    if (ImGui::SliderInt("Prefetch Recent Files", &prefetchCount, 0, 10))
+                    {
+                        cocos2d::UserDefault::getInstance()->setIntegerForKey("cc_imgui_editor.prefetch_recent_files", prefetchCount);
+                    }
+
+                    int prefetchSizeMB = cocos2d::UserDefault::getInstance()->getIntegerForKey("cc_imgui_editor.prefetch_mb", s_defaultPrefetchSizeMB);
+                    if (ImGui::DragInt("Prefetch Limit (MB)", &prefetchSizeMB, 1.0f, 0, 4096))
+                    {
+                        cocos2d::UserDefault::getInstance()->setIntegerForKey("cc_imgui_editor.prefetch_mb", prefetchSizeMB);
+                    }
+
+                    int undoMemoryMB = cocos2d::UserDefault::getInstance()->getIntegerForKey("cc_imgui_editor.undo_memory_mb", s_defaultUndoMemoryMB);
+                    if (ImGui::DragInt("Undo Memory (MB)", &undoMemoryMB, 1.0f, 1, 4096))
+                    {
+                        cocos2d::UserDefault::getInstance()->setIntegerForKey("cc_imgui_editor.undo_memory_mb", undoMemoryMB);
+                        _commandHistory.setMemoryBudget(static_cast<size_t>(std::max(undoMemoryMB, 1)) * 1024 * 1024);
+                    }
+
                     if (ImGui::BeginMenu("Style"))
                     {
                         const int style = cocos2d::UserDefault::getInstance()->getIntegerForKey("cc_imgui_editor.style", 0);
@@ -984,6 +2194,26 @@ namespace CCImEditor
         _editingNode = node;
         _commandHistory.reset();
         cocos2d::Director::getInstance()->getRunningScene()->addChild(node);
+        _eventBus.publish(EditorEvents::EditingNodeChanged{node});
+    }
+
+    cocos2d::Node* Editor::getSelectedNode() const
+    {
+        std::unordered_map<std::string, cocos2d::WeakPtr<cocos2d::Ref>>::const_iterator it = _userObjects.find(s_selectedNodePath);
+        if (it == _userObjects.end() || !it->second)
+            return nullptr;
+
+        CC_ASSERT(dynamic_cast<cocos2d::Node*>(it->second.get()));
+        return static_cast<cocos2d::Node*>(it->second.get());
+    }
+
+    void Editor::setSelectedNode(cocos2d::Node* node)
+    {
+        if (getSelectedNode() == node)
+            return;
+
+        setUserObject(s_selectedNodePath, node);
+        _eventBus.publish(EditorEvents::SelectionChanged{node});
     }
 
     void Editor::save()
@@ -1053,6 +2283,7 @@ namespace CCImEditor
             cocos2d::Node* node = nullptr;
             if (parent && deserializeNode(&node, _clipboardValue))
             {
+                regenerateIds(node);
                 addNode(parent, node);
             }
         }, 0, "paste");
@@ -1121,29 +2352,95 @@ namespace CCImEditor
         return false;
     }
 
+    bool Editor::saveNode(cocos2d::Node* node, cocos2d::ValueMap& target)
+    {
+        return serializeNode(node, target);
+    }
+
+    cocos2d::Node* Editor::loadNode(const cocos2d::ValueMap& source)
+    {
+        cocos2d::Node* node = nullptr;
+        if (deserializeNode(&node, source))
+            return node;
+
+        return nullptr;
+    }
+
     cocos2d::Node* Editor::loadFile(const std::string& file)
     {
-        std::string extension = cocos2d::FileUtils::getInstance()->getFileExtension(file);
-        if (extension == ".json")
+        cocos2d::FileUtils* fileUtils = cocos2d::FileUtils::getInstance();
+        std::string extension = fileUtils->getFileExtension(file);
+        if (extension == BinaryScene::getFileExtension())
+            return loadBinaryScene(file);
+
+        Internal::MappedFile mappedFile;
+        if (!mappedFile.open(file))
+        {
+            CCLOGWARN("Failed to read %s", file.c_str());
+            return nullptr;
+        }
+
+        // A binary scene decoded from the same content is read in place instead
+        DerivedDataCache* derivedDataCache = DerivedDataCache::getInstance();
+        std::string missedKey;
+        if (derivedDataCache->isEnabled())
+        {
+            const std::string key = DerivedDataCache::getKey(mappedFile.getData(), mappedFile.getSize());
+            const std::string cachedFile = derivedDataCache->find(key);
+            if (cachedFile.empty())
+                missedKey = key;
+            else if (cocos2d::Node* node = loadBinaryScene(cachedFile))
+                return node;
+        }
+
+        const char* data = reinterpret_cast<const char*>(mappedFile.getData());
+        if (extension == ".json" && missedKey.empty())
         {
-            std::string content = cocos2d::FileUtils::getInstance()->getStringFromFile(file);
-            cocos2d::Value value;
-            if (cocos2d::JSON::decode(content, value) == cocos2d::JSON::ErrorCode::SUCCESS && 
-                value.getType() == cocos2d::Value::Type::MAP)
+            std::vector<std::string> prefabFiles;
+            Internal::JsonReader scanner(data, mappedFile.getSize());
+            if (collectPrefabFiles(scanner, prefabFiles))
+                PrefabCache::getInstance()->preload(prefabFiles);
+
+            Internal::JsonReader reader(data, mappedFile.getSize());
+            cocos2d::Node* node = nullptr;
+            if (deserializeNode(&node, reader) && reader.isFinished())
             {
-                cocos2d::Node* node = nullptr;
-                if (deserializeNode(&node, value.asValueMap()))
-                {
-                    return node;
-                }
+                return node;
             }
         }
         else
         {
-            const cocos2d::ValueMap& valueMap = cocos2d::FileUtils::getInstance()->getValueMapFromFile(file);
+            // Missing from the cache, the description decoded once here is also what is stored
+            std::shared_ptr<cocos2d::ValueMap> valueMap = std::make_shared<cocos2d::ValueMap>();
+            if (extension == ".json")
+            {
+                Internal::JsonReader reader(data, mappedFile.getSize());
+                cocos2d::Value value;
+                if (!reader.readValue(value) || !reader.isFinished() || value.getType() != cocos2d::Value::Type::MAP)
+                    return nullptr;
+
+                *valueMap = std::move(value.asValueMap());
+            }
+            else
+            {
+                *valueMap = fileUtils->getValueMapFromData(data, static_cast<int>(mappedFile.getSize()));
+            }
+
+            std::vector<std::string> prefabFiles;
+            PrefabCache::collectFiles(*valueMap, prefabFiles);
+            PrefabCache::getInstance()->preload(prefabFiles);
+
             cocos2d::Node* node = nullptr;
-            if (deserializeNode(&node, valueMap))
+            if (deserializeNode(&node, *valueMap))
             {
+                // Fills the cache for the next load without holding up this one
+                if (!missedKey.empty())
+                {
+                    Internal::ThreadPool::getInstance()->enqueue([missedKey, valueMap]()
+                    {
+                        DerivedDataCache::getInstance()->store(missedKey, *valueMap);
+                    });
+                }
                 return node;
             }
         }
@@ -1151,6 +2448,425 @@ namespace CCImEditor
         return nullptr;
     }
 
+    void Editor::openFile(const std::string& file)
+    {
+        const std::string fullPath = cocos2d::FileUtils::getInstance()->fullPathForFilename(file);
+        if (fullPath.empty())
+        {
+            alert("Failed to open file: %s", file.c_str());
+            return;
+        }
+
+        // Replaces any file being opened, its decoding job finishes in the background
+        _openingFile.reset(new OpeningFile());
+        _openingFile->_file = file;
+
+        std::vector<std::unique_ptr<PrefetchedFile>>::iterator prefetchedIt = std::find_if(_prefetchedFiles.begin(), _prefetchedFiles.end(),
+            [&fullPath](const std::unique_ptr<PrefetchedFile>& prefetchedFile)
+            {
+                return prefetchedFile->_fullPath == fullPath;
+            });
+
+        if (prefetchedIt != _prefetchedFiles.end())
+        {
+            std::unique_ptr<PrefetchedFile> prefetchedFile = std::move(*prefetchedIt);
+            _prefetchedFiles.erase(prefetchedIt);
+
+            // A file still opening is dropped and opened again below, as is a file which changed
+            if (!prefetchedFile->_opened.valid())
+            {
+                _prefetchedSize -= prefetchedFile->_memory;
+
+                int64_t modificationTime, size;
+                PrefabCache::getFileStatus(fullPath, modificationTime, size);
+                if (modificationTime == prefetchedFile->_modificationTime && size == prefetchedFile->_size)
+                {
+                    // Prefabs are checked again, the ones already loaded are hits
+                    _openingFile->_sceneFile = prefetchedFile->_sceneFile;
+                    _openingFile->_totalNodes = _openingFile->_sceneFile->_nodeCount;
+                    _openingFile->_preload.reset(new PrefabCache::Preload(_openingFile->_sceneFile->_prefabFiles));
+                    return;
+                }
+            }
+        }
+
+        std::shared_ptr<SceneFile> sceneFile = std::make_shared<SceneFile>();
+        _openingFile->_sceneFile = sceneFile;
+        _openingFile->_opened = Internal::ThreadPool::getInstance()->enqueue([fullPath, sceneFile]()
+        {
+            return openSceneFile(*sceneFile, fullPath) && scanSceneFile(*sceneFile);
+        });
+    }
+
+    void Editor::saveSession()
+    {
+        const std::string sessionFile = getSessionFile();
+        cocos2d::ValueMap root;
+        if (!_editingNode || !serializeNode(_editingNode, root))
+        {
+            cocos2d::FileUtils::getInstance()->removeFile(sessionFile);
+            return;
+        }
+
+        cocos2d::ValueMap session;
+        session.emplace("version", s_sessionVersion);
+        session.emplace("root", cocos2d::Value(std::move(root)));
+        session.emplace("file", _currentFile);
+        session.emplace("atSavePoint", _commandHistory.atSavePoint());
+
+        if (!_currentFile.empty())
+        {
+            std::string modificationTime, size;
+            getFileStatus(cocos2d::FileUtils::getInstance()->fullPathForFilename(_currentFile), modificationTime, size);
+            session.emplace("fileTime", modificationTime);
+            session.emplace("fileSize", size);
+        }
+
+        if (cocos2d::Node* node = getSelectedNode())
+        {
+            if (NodeImDrawer* drawer = node->getComponent<NodeImDrawer>())
+                session.emplace("selection", drawer->getId());
+        }
+
+        // The cameras of the viewports are children named after their window
+        cocos2d::ValueMap cameras;
+        for (cocos2d::Node* child : getChildren())
+        {
+            cocos2d::Camera* camera = dynamic_cast<cocos2d::Camera*>(child);
+            if (!camera || camera->getCameraFlag() != static_cast<cocos2d::CameraFlag>(1 << 15) || camera->getName().empty())
+                continue;
+
+            cocos2d::ValueMap cameraVal;
+            cameraVal.emplace("type", static_cast<int>(camera->getType()));
+            cameraVal.emplace("position", toValue(camera->getPosition3D()));
+            cameraVal.emplace("rotation", toValue(camera->getRotation3D()));
+            cameras.emplace(camera->getName(), cocos2d::Value(std::move(cameraVal)));
+        }
+        session.emplace("cameras", cocos2d::Value(std::move(cameras)));
+
+        if (!SceneWriter::writeFile(sessionFile, session, true))
+            CCLOGWARN("Failed to write session %s", sessionFile.c_str());
+    }
+
+    void Editor::restoreSession()
+    {
+        if (!cocos2d::UserDefault::getInstance()->getBoolForKey("cc_imgui_editor.restore_session", true))
+            return;
+
+        // Something was opened before the editor entered the scene
+        if (_editingNode || _nextEditingNode || _openingFile)
+            return;
+
+        // Only the header fields are read here, the tree is scanned on a worker thread
+        const std::string sessionFile = getSessionFile();
+        std::shared_ptr<SceneFile> sceneFile = std::make_shared<SceneFile>();
+        if (!cocos2d::FileUtils::getInstance()->isFileExist(sessionFile) || !sceneFile->_mappedFile.open(sessionFile) || !sceneFile->_reader.init(sceneFile->_mappedFile.getData(), sceneFile->_mappedFile.getSize()))
+            return;
+
+        const BinaryScene::ValueRef sessionRef = sceneFile->_reader.getRoot();
+        if (sessionRef.find("version").asInt() != s_sessionVersion || !sessionRef.find("root").isMap())
+            return;
+
+        const std::string file = sessionRef.find("file").asString();
+        if (!file.empty())
+        {
+            std::string modificationTime, size;
+            getFileStatus(cocos2d::FileUtils::getInstance()->fullPathForFilename(file), modificationTime, size);
+            if (modificationTime != sessionRef.find("fileTime").asString() || size != sessionRef.find("fileSize").asString())
+            {
+                CCLOG("%s changed since the last session, opening it instead", file.c_str());
+                openFile(file);
+                return;
+            }
+        }
+
+        // The nodes are created from the mapped session, only the small fields around them are decoded
+        std::shared_ptr<cocos2d::ValueMap> session = std::make_shared<cocos2d::ValueMap>();
+        sessionRef.forEach([&session](const char* key, const BinaryScene::ValueRef& value)
+        {
+            if (std::strcmp(key, "root") != 0)
+                session->emplace(key, value.toValue());
+        });
+        sceneFile->_root._binary = sessionRef.find("root");
+
+        _openingFile.reset(new OpeningFile());
+        _openingFile->_file = file;
+        _openingFile->_sceneFile = sceneFile;
+        _openingFile->_session = session;
+        _openingFile->_opened = Internal::ThreadPool::getInstance()->enqueue([sceneFile]()
+        {
+            return scanSceneFile(*sceneFile);
+        });
+    }
+
+    // Called once the editing node of the session is set
+    void Editor::applySession(const cocos2d::ValueMap& session)
+    {
+        // Unsaved changes are kept, the history before them is not
+        cocos2d::ValueMap::const_iterator atSavePointIt = session.find("atSavePoint");
+        if (atSavePointIt != session.end() && !atSavePointIt->second.asBool())
+            _commandHistory.clearSavePoint();
+
+        cocos2d::ValueMap::const_iterator selectionIt = session.find("selection");
+        if (selectionIt != session.end() && _editingNode)
+        {
+            const std::string selection = selectionIt->second.asString();
+            Internal::performRecursively(_editingNode, [this, &selection](cocos2d::Node* child)
+            {
+                NodeImDrawer* drawer = child->getComponent<NodeImDrawer>();
+                if (drawer && drawer->getId() == selection)
+                    setSelectedNode(child);
+            });
+        }
+
+        // Viewports copy the transform of their camera when they recreate it
+        cocos2d::ValueMap::const_iterator camerasIt = session.find("cameras");
+        if (camerasIt == session.end() || camerasIt->second.getType() != cocos2d::Value::Type::MAP)
+            return;
+
+        const cocos2d::ValueMap& cameras = camerasIt->second.asValueMap();
+        for (cocos2d::Node* child : getChildren())
+        {
+            cocos2d::Camera* camera = dynamic_cast<cocos2d::Camera*>(child);
+            if (!camera || camera->getCameraFlag() != static_cast<cocos2d::CameraFlag>(1 << 15))
+                continue;
+
+            cocos2d::ValueMap::const_iterator cameraIt = cameras.find(camera->getName());
+            if (cameraIt == cameras.end() || cameraIt->second.getType() != cocos2d::Value::Type::MAP)
+                continue;
+
+            const cocos2d::ValueMap& cameraVal = cameraIt->second.asValueMap();
+            cocos2d::ValueMap::const_iterator typeIt = cameraVal.find("type");
+            cocos2d::ValueMap::const_iterator positionIt = cameraVal.find("position");
+            cocos2d::ValueMap::const_iterator rotationIt = cameraVal.find("rotation");
+            cocos2d::Vec3 position, rotation;
+            if (typeIt == cameraVal.end() || typeIt->second.asInt() != static_cast<int>(camera->getType()) ||
+                positionIt == cameraVal.end() || !fromValue(positionIt->second, position) ||
+                rotationIt == cameraVal.end() || !fromValue(rotationIt->second, rotation))
+                continue;
+
+            camera->setPosition3D(position);
+            camera->setRotation3D(rotation);
+        }
+    }
+
+    void Editor::startPrefetch()
+    {
+        const int count = cocos2d::UserDefault::getInstance()->getIntegerForKey("cc_imgui_editor.prefetch_recent_files", s_defaultPrefetchCount);
+        cocos2d::ValueMap::const_iterator it = _settings.find("recent_files");
+        if (count <= 0 || it == _settings.end() || it->second.getType() != cocos2d::Value::Type::VECTOR)
+            return;
+
+        _prefetchQueue.clear();
+        for (const cocos2d::Value& recentFile : it->second.asValueVector())
+        {
+            if (_prefetchQueue.size() >= static_cast<size_t>(count))
+                break;
+
+            // Already on its way, e.g. restored from the last session
+            const std::string file = recentFile.asString();
+            if (!_openingFile || file != _openingFile->_file)
+                _prefetchQueue.push_back(file);
+        }
+    }
+
+    void Editor::updatePrefetch()
+    {
+        if (!_prefetchedFiles.empty())
+        {
+            PrefetchedFile& prefetchedFile = *_prefetchedFiles.back();
+            if (prefetchedFile._opened.valid())
+            {
+                if (prefetchedFile._opened.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                    return;
+
+                const bool opened = prefetchedFile._opened.get();
+                const size_t sizeLimit = static_cast<size_t>(std::max(cocos2d::UserDefault::getInstance()->getIntegerForKey("cc_imgui_editor.prefetch_mb", s_defaultPrefetchSizeMB), 0)) * 1024 * 1024;
+                prefetchedFile._memory = opened ? prefetchedFile._sceneFile->getMemory() : 0;
+                if (!opened || _prefetchedSize + prefetchedFile._memory > sizeLimit)
+                {
+                    // Files further down the list are not worth more than this one
+                    if (opened)
+                        _prefetchQueue.clear();
+
+                    _prefetchedFiles.pop_back();
+                    return;
+                }
+
+                _prefetchedSize += prefetchedFile._memory;
+                prefetchedFile._preload.reset(new PrefabCache::Preload(prefetchedFile._sceneFile->_prefabFiles));
+            }
+
+            if (prefetchedFile._preload)
+            {
+                if (!prefetchedFile._preload->update())
+                    return;
+
+                prefetchedFile._preload.reset();
+            }
+        }
+
+        // The worker threads are left to a file being opened
+        if (_prefetchQueue.empty() || _openingFile)
+            return;
+
+        const std::string file = std::move(_prefetchQueue.front());
+        _prefetchQueue.erase(_prefetchQueue.begin());
+
+        std::unique_ptr<PrefetchedFile> prefetchedFile(new PrefetchedFile());
+        prefetchedFile->_file = file;
+        prefetchedFile->_fullPath = cocos2d::FileUtils::getInstance()->fullPathForFilename(file);
+        if (prefetchedFile->_fullPath.empty())
+            return;
+
+        PrefabCache::getFileStatus(prefetchedFile->_fullPath, prefetchedFile->_modificationTime, prefetchedFile->_size);
+        prefetchedFile->_sceneFile = std::make_shared<SceneFile>();
+        prefetchedFile->_opened = Internal::ThreadPool::getInstance()->enqueue([fullPath = prefetchedFile->_fullPath, sceneFile = prefetchedFile->_sceneFile]()
+        {
+            return openSceneFile(*sceneFile, fullPath) && scanSceneFile(*sceneFile);
+        });
+
+        _prefetchedFiles.push_back(std::move(prefetchedFile));
+    }
+
+    void Editor::updateOpeningFile()
+    {
+        if (!_openingFile)
+            return;
+
+        OpeningFile& openingFile = *_openingFile;
+        const SceneFile& sceneFile = *openingFile._sceneFile;
+        if (openingFile._opened.valid())
+        {
+            if (openingFile._opened.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                return;
+
+            if (!openingFile._opened.get())
+            {
+                alert("Failed to open file: %s", openingFile._file.c_str());
+                _openingFile.reset();
+                return;
+            }
+
+            openingFile._totalNodes = sceneFile._nodeCount;
+            openingFile._preload.reset(new PrefabCache::Preload(sceneFile._prefabFiles));
+        }
+
+        if (openingFile._preload)
+        {
+            if (!openingFile._preload->update())
+                return;
+
+            openingFile._preload.reset();
+        }
+
+        const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + s_openFileTimeBudget;
+        if (!openingFile._root)
+        {
+            cocos2d::Node* root = nullptr;
+            std::vector<NodeRef> children;
+            if (!deserializeNodeWithoutChildren(&root, sceneFile, sceneFile._root, children))
+            {
+                alert("Failed to open file: %s", openingFile._file.c_str());
+                _openingFile.reset();
+                return;
+            }
+
+            openingFile._root = root;
+            openingFile._createdNodes++;
+            if (!children.empty())
+                openingFile._pendingChildren.push_back({root, std::move(children), 0});
+        }
+
+        // Depth first so that children are added in the same order as loadFile does
+        while (!openingFile._pendingChildren.empty() && std::chrono::steady_clock::now() < deadline)
+        {
+            OpeningFile::PendingChildren& pending = openingFile._pendingChildren.back();
+            if (pending._index >= pending._children.size())
+            {
+                openingFile._pendingChildren.pop_back();
+                continue;
+            }
+
+            // Copied, pushing the children below moves the pending entries
+            cocos2d::Node* parent = pending._parent;
+            const NodeRef childRef = pending._children[pending._index++];
+            openingFile._createdNodes++;
+
+            cocos2d::Node* child = nullptr;
+            std::vector<NodeRef> children;
+            if (!deserializeNodeWithoutChildren(&child, sceneFile, childRef, children))
+            {
+                // Keep the progress in line with the scan
+                openingFile._createdNodes += countNodes(sceneFile, childRef) - 1;
+                continue;
+            }
+
+            parent->addChild(child);
+            if (!children.empty())
+                openingFile._pendingChildren.push_back({child, std::move(children), 0});
+        }
+
+        if (openingFile._pendingChildren.empty())
+        {
+            setEditingNode(openingFile._root);
+            if (!openingFile._file.empty())
+                setCurrentFile(openingFile._file);
+
+            if (openingFile._session)
+                applySession(*openingFile._session);
+
+            if (!openingFile._file.empty())
+                _eventBus.publish(EditorEvents::FileOpened{openingFile._file});
+
+            _openingFile.reset();
+        }
+    }
+
+    bool Editor::drawOpeningFile()
+    {
+        const char* windowName = "Opening File";
+        if (_openingFile && !ImGui::IsPopupOpen(windowName))
+            ImGui::OpenPopup(windowName);
+
+        if (ImGui::BeginPopupModal(windowName, nullptr, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_AlwaysAutoResize))
+        {
+            // Finished or failed in updateOpeningFile
+            if (!_openingFile)
+            {
+                ImGui::CloseCurrentPopup();
+                ImGui::EndPopup();
+                return false;
+            }
+
+            ImGui::Text("%s", _openingFile->_file.c_str());
+
+            if (_openingFile->_opened.valid())
+            {
+                ImGui::ProgressBar(0.0f, ImVec2(300.0f, 0.0f), "Reading...");
+            }
+            else if (_openingFile->_preload)
+            {
+                ImGui::ProgressBar(0.0f, ImVec2(300.0f, 0.0f), "Loading prefabs...");
+            }
+            else
+            {
+                const float fraction = static_cast<float>(_openingFile->_createdNodes) / _openingFile->_totalNodes;
+                std::string overlay = cocos2d::StringUtils::format("%zu / %zu nodes", _openingFile->_createdNodes, _openingFile->_totalNodes);
+                ImGui::ProgressBar(fraction, ImVec2(300.0f, 0.0f), overlay.c_str());
+            }
+
+            if (ImGui::Button("Cancel"))
+            {
+                _openingFile.reset();
+                ImGui::CloseCurrentPopup();
+            }
+            ImGui::EndPopup();
+        }
+
+        return _openingFile != nullptr;
+    }
+
     void Editor::updateWindowTitle()
     {
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_MAC) || (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX) || (CC_TARGET_PLATFORM == CC_PLATFORM_EMSCRIPTEN)
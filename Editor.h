@@ -5,6 +5,8 @@
 
 #include "Widget.h"
 #include "CommandHistory.h"
+#include "EventBus.h"
+#include "EditorEvents.h"
 #include "FileDialog.h"
 #include "imgui.h"
 
@@ -29,6 +31,11 @@ namespace CCImEditor
         cocos2d::Node* getEditingNode() const { return _editingNode; };
         void setEditingNode(cocos2d::Node* node);
 
+        // Kept as the user object "CCImGuiWidgets.NodeTree.SelectedNode", a change publishes
+        // EditorEvents::SelectionChanged
+        cocos2d::Node* getSelectedNode() const;
+        void setSelectedNode(cocos2d::Node* node);
+
         void setDebugMode(bool isDebugMode) { _isDebugMode = isDebugMode; }
         bool isDebugMode() const { return _isDebugMode; };
 
@@ -55,8 +62,18 @@ namespace CCImEditor
         }
 
         CommandHistory& getCommandHistory() { return _commandHistory; };
+        EventBus& getEventBus() { return _eventBus; };
 
         static cocos2d::Node* loadFile(const std::string& file);
+
+        // Description of a node with its drawer and children, as in a file, and the node
+        // created back from it with the same ids
+        static bool saveNode(cocos2d::Node* node, cocos2d::ValueMap& target);
+        static cocos2d::Node* loadNode(const cocos2d::ValueMap& source);
+
+        // Opens the file as editing node without blocking, nodes are created over several frames
+        void openFile(const std::string& file);
+        bool isOpeningFile() const { return _openingFile != nullptr; };
         static bool isInstancePresent();
     
         void updateWindowTitle();
@@ -85,11 +102,55 @@ namespace CCImEditor
         void drawDockSpace();
         bool drawFileDialog();
 
+        void updateOpeningFile();
+        bool drawOpeningFile();
+
+        // Snapshot of the editing node with the current file, the selection and the cameras
+        // of the viewports. Written in binary form on exit and opened again on enter, as long
+        // as the current file did not change in between.
+        void saveSession();
+        void restoreSession();
+        void applySession(const cocos2d::ValueMap& session);
+
+        // Recent files are decoded one at a time in the background after onEnter, until
+        // their descriptions reach the memory limit. openFile takes them over.
+        struct PrefetchedFile;
+        void startPrefetch();
+        void updatePrefetch();
+
+        // Saving runs on a worker thread, the result is handled by updateSavingFile
+        struct SavingFile;
         void serializeEditingNodeToFile(const std::string& file);
+        void startSaving(std::unique_ptr<SavingFile> savingFile);
+        void updateSavingFile(bool wait);
         void setCurrentFile(const std::string& file);
 
+        // Diff of the editing node against a file, and three-way merge of the changes made
+        // in a file on top of the editing node, using the current file on disk as base
+        void compareWithFile(const std::string& file);
+        void mergeWithFile(const std::string& file);
+
+        // Packs the current file and the files it references, in the order a load reads them
+        void buildAssetPack(const std::string& file);
+
+        // Writes the editing node for CSLoader and reports what the CSB schema can not hold
+        void exportCsb(const std::string& file);
+
+        // Writes C++ building the editing node, with a CMake target, next to the file
+        void compileScene(const std::string& file);
+
+        // Writes the children of the editing node to chunk files for ChunkStreamer, and
+        // the rest of it to the file as their manifest
+        void exportChunks(const std::string& file);
+
+        // Alerts the title followed by the first lines of a report, all of which are logged
+        void alertReport(const std::string& title, const std::vector<std::string>& lines);
+
         void import(const std::string& path, const std::vector<ImportRule>& rules, bool recursive);
 
+        // Declared first, what subscribes to it is destroyed before it
+        EventBus _eventBus;
+
         typedef std::pair<std::string, std::function<void()>> Runnable;
         std::vector<Runnable> _runnables;
 
@@ -118,6 +179,16 @@ namespace CCImEditor
 
         std::string _currentFile;
         cocos2d::ValueMap _settings;
+
+        struct OpeningFile;
+        std::unique_ptr<OpeningFile> _openingFile;
+
+        std::vector<std::string> _prefetchQueue;
+        std::vector<std::unique_ptr<PrefetchedFile>> _prefetchedFiles;
+        size_t _prefetchedSize = 0; // estimated, of the decoded descriptions
+
+        std::unique_ptr<SavingFile> _savingFile;
+        std::unique_ptr<SavingFile> _nextSavingFile;
         
         struct ImportRuleSet
         {
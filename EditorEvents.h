@@ -0,0 +1,82 @@
+#ifndef __CCIMEDITOR_EDITOREVENTS_H__
+#define __CCIMEDITOR_EDITOREVENTS_H__
+
+#include <string>
+#include "cocos2d.h"
+
+namespace CCImEditor
+{
+    class Command;
+    class ImPropertyGroup;
+
+    // Events published on Editor::getEventBus(), so widgets can cache what they derive from
+    // the scene and rebuild it only when it may have changed
+    namespace EditorEvents
+    {
+        // Null when nothing is selected
+        struct SelectionChanged
+        {
+            cocos2d::Node* _node;
+        };
+
+        // Replaced by a new, opened, restored or merged scene. The command history is reset.
+        struct EditingNodeChanged
+        {
+            cocos2d::Node* _node;
+        };
+
+        // By commands, also when undoing or redoing them
+        struct NodeAdded
+        {
+            cocos2d::Node* _node;
+            cocos2d::Node* _parent;
+        };
+
+        struct NodeRemoved
+        {
+            cocos2d::Node* _node;
+            cocos2d::Node* _parent;
+        };
+
+        struct NodeReparented
+        {
+            cocos2d::Node* _node;
+            cocos2d::Node* _oldParent;
+            cocos2d::Node* _newParent;
+        };
+
+        // Edited in a property group or with a gizmo, for each change while an item is being
+        // dragged. The key is null when several properties changed at once. Recording an
+        // animation changes the key at the current frame too.
+        struct PropertyChanged
+        {
+            cocos2d::Node* _node;
+            ImPropertyGroup* _group;
+            const char* _key;
+        };
+
+        // After a command is executed or redone, and when one already applied is queued
+        struct CommandExecuted
+        {
+            Command* _command;
+        };
+
+        struct CommandUndone
+        {
+            Command* _command;
+        };
+
+        // Once the editing node is the one of the file
+        struct FileOpened
+        {
+            std::string _file;
+        };
+
+        struct FileSaved
+        {
+            std::string _file;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,87 @@
+#include "EventBus.h"
+
+#include <algorithm>
+
+namespace CCImEditor
+{
+    EventBus::Subscription& EventBus::Subscription::operator=(Subscription&& other)
+    {
+        if (this != &other)
+        {
+            reset();
+            _bus = other._bus;
+            _id = other._id;
+            other._bus = nullptr;
+        }
+
+        return *this;
+    }
+
+    void EventBus::Subscription::reset()
+    {
+        if (_bus)
+            _bus->unsubscribe(_id);
+
+        _bus = nullptr;
+    }
+
+    void EventBus::dispatch(std::type_index type, const void* event)
+    {
+        std::unordered_map<std::type_index, std::vector<Listener>>::iterator it = _listeners.find(type);
+        if (it == _listeners.end())
+            return;
+
+        // Listeners subscribed by a listener only get the next events. The callback is copied
+        // as the vector may grow while it runs, the map may rehash but its elements stay.
+        std::vector<Listener>& listeners = it->second;
+        ++_dispatchDepth;
+        const size_t count = listeners.size();
+        for (size_t i = 0; i < count; i++)
+        {
+            std::function<void(const void*)> callback = listeners[i]._callback;
+            if (callback)
+                callback(event);
+        }
+        --_dispatchDepth;
+
+        if (_dispatchDepth == 0 && _hasRemovedListeners)
+        {
+            for (std::pair<const std::type_index, std::vector<Listener>>& pair : _listeners)
+            {
+                std::vector<Listener>& listeners = pair.second;
+                listeners.erase(std::remove_if(listeners.begin(), listeners.end(), [](const Listener& listener)
+                {
+                    return !listener._callback;
+                }), listeners.end());
+            }
+
+            _hasRemovedListeners = false;
+        }
+    }
+
+    void EventBus::unsubscribe(uint64_t id)
+    {
+        for (std::pair<const std::type_index, std::vector<Listener>>& pair : _listeners)
+        {
+            std::vector<Listener>& listeners = pair.second;
+            std::vector<Listener>::iterator it = std::find_if(listeners.begin(), listeners.end(), [id](const Listener& listener)
+            {
+                return listener._id == id;
+            });
+
+            if (it == listeners.end())
+                continue;
+
+            if (_dispatchDepth > 0)
+            {
+                it->_callback = nullptr;
+                _hasRemovedListeners = true;
+            }
+            else
+            {
+                listeners.erase(it);
+            }
+            return;
+        }
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef __CCIMEDITOR_EVENTBUS_H__
+#define __CCIMEDITOR_EVENTBUS_H__
+
+#include <cstdint>
+#include <functional>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+namespace CCImEditor
+{
+    // Delivers events to the listeners of their type, see EditorEvents.h for those of the
+    // editor. Events are published and delivered on the main thread, in the order listeners
+    // subscribed. Listeners may subscribe, unsubscribe and publish while an event is delivered.
+    class EventBus
+    {
+    public:
+        // Unsubscribes the listener when destroyed, must not outlive its bus
+        class Subscription
+        {
+        public:
+            Subscription() {};
+            Subscription(Subscription&& other) : _bus(other._bus), _id(other._id) { other._bus = nullptr; };
+            Subscription& operator=(Subscription&& other);
+            ~Subscription() { reset(); };
+
+            void reset();
+
+        private:
+            friend class EventBus;
+
+            Subscription(const Subscription&) = delete;
+            Subscription& operator=(const Subscription&) = delete;
+
+            EventBus* _bus = nullptr;
+            uint64_t _id = 0;
+        };
+
+        EventBus() {};
+
+        template <typename Event>
+        Subscription subscribe(std::function<void(const Event&)> listener)
+        {
+            Subscription subscription;
+            subscription._bus = this;
+            subscription._id = ++_lastId;
+            _listeners[std::type_index(typeid(Event))].push_back({subscription._id, [listener](const void* event)
+            {
+                listener(*static_cast<const Event*>(event));
+            }});
+            return subscription;
+        }
+
+        template <typename Event>
+        void publish(const Event& event)
+        {
+            dispatch(std::type_index(typeid(Event)), &event);
+        }
+
+    private:
+        EventBus(const EventBus&) = delete;
+        void operator=(const EventBus&) = delete;
+
+        void dispatch(std::type_index type, const void* event);
+        void unsubscribe(uint64_t id);
+
+        struct Listener
+        {
+            uint64_t _id;
+            std::function<void(const void*)> _callback;
+        };
+
+        std::unordered_map<std::type_index, std::vector<Listener>> _listeners;
+        uint64_t _lastId = 0;
+
+        // Listeners removed during a dispatch are only cleared then, and erased once it ends
+        int _dispatchDepth = 0;
+        bool _hasRemovedListeners = false;
+    };
+}
+
+#endif
@@ -0,0 +1,506 @@
+#include "JsonReader.h"
+
+#include <cstdlib>
+#include <climits>
+#include <cstring>
+
+namespace CCImEditor
+{
+    namespace Internal
+    {
+        namespace
+        {
+            const int s_maxDepth = 512;
+
+            bool isDigit(char c)
+            {
+                return c >= '0' && c <= '9';
+            }
+
+            int hexValue(char c)
+            {
+                if (c >= '0' && c <= '9')
+                    return c - '0';
+                if (c >= 'a' && c <= 'f')
+                    return c - 'a' + 10;
+                if (c >= 'A' && c <= 'F')
+                    return c - 'A' + 10;
+                return -1;
+            }
+
+            void appendUtf8(std::string& out, uint32_t codepoint)
+            {
+                if (codepoint < 0x80)
+                {
+                    out.push_back(static_cast<char>(codepoint));
+                }
+                else if (codepoint < 0x800)
+                {
+                    out.push_back(static_cast<char>(0xC0 | (codepoint >> 6)));
+                    out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+                }
+                else if (codepoint < 0x10000)
+                {
+                    out.push_back(static_cast<char>(0xE0 | (codepoint >> 12)));
+                    out.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+                    out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+                }
+                else
+                {
+                    out.push_back(static_cast<char>(0xF0 | (codepoint >> 18)));
+                    out.push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F)));
+                    out.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+                    out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+                }
+            }
+        }
+
+        JsonReader::JsonReader(const char* data, size_t size)
+        : _data(data)
+        , _ptr(data)
+        , _end(data + size)
+        {
+            // Skip UTF-8 BOM
+            if (size >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0)
+                _ptr += 3;
+        }
+
+        JsonReader JsonReader::readerAt(size_t offset) const
+        {
+            JsonReader reader(_data, static_cast<size_t>(_end - _data));
+            if (offset > static_cast<size_t>(_end - _data))
+                reader.fail();
+            else
+                reader._ptr = _data + offset;
+            return reader;
+        }
+
+        JsonReader::Token JsonReader::peek()
+        {
+            skipWhitespace();
+            if (_error || _ptr == _end)
+                return Token::NONE;
+
+            switch (*_ptr)
+            {
+            case '{': return Token::OBJECT;
+            case '[': return Token::ARRAY;
+            case '"': return Token::STRING;
+            case 't': return Token::TRUE_VALUE;
+            case 'f': return Token::FALSE_VALUE;
+            case 'n': return Token::NULL_VALUE;
+            default:
+                if (*_ptr == '-' || isDigit(*_ptr))
+                    return Token::NUMBER;
+                return Token::NONE;
+            }
+        }
+
+        bool JsonReader::beginObject()
+        {
+            if (!expect('{'))
+                return false;
+
+            _first.push_back(true);
+            return true;
+        }
+
+        bool JsonReader::nextMember(std::string_view& key)
+        {
+            if (!nextInContainer('}'))
+                return false;
+
+            if (!readStringView(key))
+                return false;
+
+            // The key may live in _scratch, which is not touched by expect
+            return expect(':');
+        }
+
+        bool JsonReader::beginArray()
+        {
+            if (!expect('['))
+                return false;
+
+            _first.push_back(true);
+            return true;
+        }
+
+        bool JsonReader::nextElement()
+        {
+            return nextInContainer(']');
+        }
+
+        bool JsonReader::readString(std::string& out)
+        {
+            std::string_view view;
+            if (!readStringView(view))
+                return false;
+
+            out.assign(view.data(), view.size());
+            return true;
+        }
+
+        bool JsonReader::readValue(cocos2d::Value& out)
+        {
+            return readValue(out, 0);
+        }
+
+        bool JsonReader::skipValue()
+        {
+            return skipValue(0);
+        }
+
+        bool JsonReader::isFinished()
+        {
+            skipWhitespace();
+            return !_error && _ptr == _end && _first.empty();
+        }
+
+        void JsonReader::skipWhitespace()
+        {
+            while (_ptr < _end && (*_ptr == ' ' || *_ptr == '\n' || *_ptr == '\r' || *_ptr == '\t'))
+                ++_ptr;
+        }
+
+        bool JsonReader::fail()
+        {
+            if (!_error)
+            {
+                CCLOGWARN("Malformed json at offset %zu", getOffset());
+                _error = true;
+            }
+
+            return false;
+        }
+
+        bool JsonReader::expect(char c)
+        {
+            skipWhitespace();
+            if (_error || _ptr == _end || *_ptr != c)
+                return fail();
+
+            ++_ptr;
+            return true;
+        }
+
+        bool JsonReader::readLiteral(const char* literal)
+        {
+            const size_t length = strlen(literal);
+            if (static_cast<size_t>(_end - _ptr) < length || memcmp(_ptr, literal, length) != 0)
+                return fail();
+
+            _ptr += length;
+            return true;
+        }
+
+        bool JsonReader::nextInContainer(char close)
+        {
+            skipWhitespace();
+            if (_error || _first.empty() || _ptr == _end)
+                return fail();
+
+            if (*_ptr == close)
+            {
+                ++_ptr;
+                _first.pop_back();
+                return false;
+            }
+
+            if (_first.back())
+            {
+                _first.back() = false;
+                return true;
+            }
+
+            return expect(',');
+        }
+
+        bool JsonReader::readStringView(std::string_view& out)
+        {
+            if (!expect('"'))
+                return false;
+
+            // Fast path, the string has no escapes and is returned in place
+            const char* begin = _ptr;
+            while (_ptr < _end && *_ptr != '"' && *_ptr != '\\')
+            {
+                if (static_cast<unsigned char>(*_ptr) < 0x20)
+                    return fail();
+                ++_ptr;
+            }
+
+            if (_ptr == _end)
+                return fail();
+
+            if (*_ptr == '"')
+            {
+                out = std::string_view(begin, _ptr - begin);
+                ++_ptr;
+                return true;
+            }
+
+            _scratch.assign(begin, _ptr - begin);
+            while (_ptr < _end && *_ptr != '"')
+            {
+                char c = *_ptr++;
+                if (static_cast<unsigned char>(c) < 0x20)
+                    return fail();
+
+                if (c != '\\')
+                {
+                    _scratch.push_back(c);
+                    continue;
+                }
+
+                if (_ptr == _end)
+                    return fail();
+
+                switch (*_ptr++)
+                {
+                case '"': _scratch.push_back('"'); break;
+                case '\\': _scratch.push_back('\\'); break;
+                case '/': _scratch.push_back('/'); break;
+                case 'b': _scratch.push_back('\b'); break;
+                case 'f': _scratch.push_back('\f'); break;
+                case 'n': _scratch.push_back('\n'); break;
+                case 'r': _scratch.push_back('\r'); break;
+                case 't': _scratch.push_back('\t'); break;
+                case 'u':
+                {
+                    uint32_t codepoint = 0;
+                    for (int i = 0; i < 4; i++)
+                    {
+                        int h = _ptr < _end ? hexValue(*_ptr++) : -1;
+                        if (h < 0)
+                            return fail();
+                        codepoint = (codepoint << 4) | h;
+                    }
+
+                    // Surrogate pair
+                    if (codepoint >= 0xD800 && codepoint <= 0xDBFF)
+                    {
+                        if (_end - _ptr < 6 || _ptr[0] != '\\' || _ptr[1] != 'u')
+                            return fail();
+
+                        _ptr += 2;
+                        uint32_t low = 0;
+                        for (int i = 0; i < 4; i++)
+                        {
+                            int h = hexValue(*_ptr++);
+                            if (h < 0)
+                                return fail();
+                            low = (low << 4) | h;
+                        }
+
+                        if (low < 0xDC00 || low > 0xDFFF)
+                            return fail();
+
+                        codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    else if (codepoint >= 0xDC00 && codepoint <= 0xDFFF)
+                    {
+                        return fail();
+                    }
+
+                    appendUtf8(_scratch, codepoint);
+                    break;
+                }
+                default:
+                    return fail();
+                }
+            }
+
+            if (_ptr == _end)
+                return fail();
+
+            ++_ptr;
+            out = _scratch;
+            return true;
+        }
+
+        bool JsonReader::readNumber(cocos2d::Value& out)
+        {
+            const char* begin = _ptr;
+            bool isInteger = true;
+            if (_ptr < _end && *_ptr == '-')
+                ++_ptr;
+
+            if (_ptr == _end || !isDigit(*_ptr))
+                return fail();
+
+            while (_ptr < _end && isDigit(*_ptr))
+                ++_ptr;
+
+            if (_ptr < _end && *_ptr == '.')
+            {
+                isInteger = false;
+                ++_ptr;
+                if (_ptr == _end || !isDigit(*_ptr))
+                    return fail();
+                while (_ptr < _end && isDigit(*_ptr))
+                    ++_ptr;
+            }
+
+            if (_ptr < _end && (*_ptr == 'e' || *_ptr == 'E'))
+            {
+                isInteger = false;
+                ++_ptr;
+                if (_ptr < _end && (*_ptr == '+' || *_ptr == '-'))
+                    ++_ptr;
+                if (_ptr == _end || !isDigit(*_ptr))
+                    return fail();
+                while (_ptr < _end && isDigit(*_ptr))
+                    ++_ptr;
+            }
+
+            // The input is not NUL terminated, copy the token for strtod/strtoll
+            char buffer[64];
+            const size_t length = _ptr - begin;
+            if (length >= sizeof(buffer))
+                return fail();
+
+            memcpy(buffer, begin, length);
+            buffer[length] = '\0';
+
+            if (isInteger)
+            {
+                long long v = strtoll(buffer, nullptr, 10);
+                if (v >= INT_MIN && v <= INT_MAX)
+                {
+                    out = static_cast<int>(v);
+                    return true;
+                }
+            }
+
+            out = strtod(buffer, nullptr);
+            return true;
+        }
+
+        bool JsonReader::readValue(cocos2d::Value& out, int depth)
+        {
+            if (depth > s_maxDepth)
+                return fail();
+
+            switch (peek())
+            {
+            case Token::OBJECT:
+            {
+                if (!beginObject())
+                    return false;
+
+                cocos2d::ValueMap valueMap;
+                std::string_view key;
+                while (nextMember(key))
+                {
+                    cocos2d::Value& value = valueMap[std::string(key)];
+                    if (!readValue(value, depth + 1))
+                        return false;
+                }
+
+                if (_error)
+                    return false;
+
+                out = std::move(valueMap);
+                return true;
+            }
+            case Token::ARRAY:
+            {
+                if (!beginArray())
+                    return false;
+
+                cocos2d::ValueVector valueVector;
+                while (nextElement())
+                {
+                    valueVector.emplace_back();
+                    if (!readValue(valueVector.back(), depth + 1))
+                        return false;
+                }
+
+                if (_error)
+                    return false;
+
+                out = std::move(valueVector);
+                return true;
+            }
+            case Token::STRING:
+            {
+                std::string_view view;
+                if (!readStringView(view))
+                    return false;
+
+                out = std::string(view);
+                return true;
+            }
+            case Token::NUMBER:
+                return readNumber(out);
+            case Token::TRUE_VALUE:
+                out = true;
+                return readLiteral("true");
+            case Token::FALSE_VALUE:
+                out = false;
+                return readLiteral("false");
+            case Token::NULL_VALUE:
+                out = cocos2d::Value::Null;
+                return readLiteral("null");
+            default:
+                return fail();
+            }
+        }
+
+        bool JsonReader::skipValue(int depth)
+        {
+            if (depth > s_maxDepth)
+                return fail();
+
+            switch (peek())
+            {
+            case Token::OBJECT:
+            {
+                if (!beginObject())
+                    return false;
+
+                std::string_view key;
+                while (nextMember(key))
+                {
+                    if (!skipValue(depth + 1))
+                        return false;
+                }
+
+                return !_error;
+            }
+            case Token::ARRAY:
+            {
+                if (!beginArray())
+                    return false;
+
+                while (nextElement())
+                {
+                    if (!skipValue(depth + 1))
+                        return false;
+                }
+
+                return !_error;
+            }
+            case Token::STRING:
+            {
+                std::string_view view;
+                return readStringView(view);
+            }
+            case Token::NUMBER:
+            {
+                cocos2d::Value value;
+                return readNumber(value);
+            }
+            case Token::TRUE_VALUE:
+                return readLiteral("true");
+            case Token::FALSE_VALUE:
+                return readLiteral("false");
+            case Token::NULL_VALUE:
+                return readLiteral("null");
+            default:
+                return fail();
+            }
+        }
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef __CCIMEDITOR_JSONREADER_H__
+#define __CCIMEDITOR_JSONREADER_H__
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include "cocos2d.h"
+
+namespace CCImEditor
+{
+    namespace Internal
+    {
+        // Pull parser reading JSON in place, tokens are consumed as the caller asks for them
+        // and nothing is built unless readValue is called. The data has to outlive the reader.
+        //
+        //  reader.beginObject();
+        //  std::string_view key;
+        //  while (reader.nextMember(key))
+        //      reader.skipValue();
+        //
+        // Any malformed input puts the reader into an error state in which every call fails.
+        class JsonReader
+        {
+        public:
+            JsonReader(const char* data, size_t size);
+
+            enum class Token
+            {
+                NONE,
+                OBJECT,
+                ARRAY,
+                STRING,
+                NUMBER,
+                TRUE_VALUE,
+                FALSE_VALUE,
+                NULL_VALUE,
+            };
+
+            // Type of the next value without consuming it
+            Token peek();
+
+            bool beginObject();
+
+            // Reads the key of the next member, returns false at the end of the object.
+            // The key is only valid until the next call to the reader.
+            bool nextMember(std::string_view& key);
+
+            bool beginArray();
+
+            // Returns false at the end of the array, otherwise an element follows
+            bool nextElement();
+
+            bool readString(std::string& out);
+            bool readValue(cocos2d::Value& out);
+            bool skipValue();
+
+            // True when the whole input has been consumed without error
+            bool isFinished();
+            bool hasError() const { return _error; };
+            size_t getOffset() const { return static_cast<size_t>(_ptr - _data); };
+
+            // New reader over the same data starting at an offset taken from getOffset, to come
+            // back to a value skipped earlier
+            JsonReader readerAt(size_t offset) const;
+
+        private:
+            void skipWhitespace();
+            bool fail();
+            bool expect(char c);
+            bool readLiteral(const char* literal);
+            bool nextInContainer(char close);
+            bool readStringView(std::string_view& out);
+            bool readNumber(cocos2d::Value& out);
+            bool readValue(cocos2d::Value& out, int depth);
+            bool skipValue(int depth);
+
+            const char* _data;
+            const char* _ptr;
+            const char* _end;
+            bool _error = false;
+            std::string _scratch;
+
+            // One entry per open container, true until its first member or element is read
+            std::vector<bool> _first;
+        };
+    }
+}
+
+#endif
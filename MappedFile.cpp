@@ -0,0 +1,155 @@
+#include "MappedFile.h"
+#include "AssetPack.h"
+
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace CCImEditor
+{
+    namespace Internal
+    {
+        MappedFile::~MappedFile()
+        {
+            close();
+        }
+
+        bool MappedFile::open(const std::string& file)
+        {
+            close();
+
+            cocos2d::FileUtils* fileUtils = cocos2d::FileUtils::getInstance();
+            std::string fullPath = fileUtils->fullPathForFilename(file);
+            if (fullPath.empty())
+                return false;
+
+            AssetPack::recordAccess(fullPath);
+
+            // Served from a mounted pack, which outlives this view
+            if (AssetPack::findMounted(fullPath, _data, _size))
+            {
+                _isOpen = true;
+                return true;
+            }
+
+            if (map(fullPath))
+            {
+                _isMapped = true;
+                _isOpen = true;
+                return true;
+            }
+
+            // Not on the local file system, read it through FileUtils instead
+            _buffer = fileUtils->getDataFromFile(fullPath);
+            if (_buffer.isNull())
+                return false;
+
+            _data = _buffer.getBytes();
+            _size = static_cast<size_t>(_buffer.getSize());
+            _isOpen = true;
+            return true;
+        }
+
+        void MappedFile::close()
+        {
+            if (_isMapped)
+            {
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+                if (_data)
+                    UnmapViewOfFile(_data);
+
+                if (_mappingHandle)
+                    CloseHandle(_mappingHandle);
+
+                if (_fileHandle)
+                    CloseHandle(_fileHandle);
+
+                _mappingHandle = nullptr;
+                _fileHandle = nullptr;
+#else
+                if (_data)
+                    munmap(const_cast<uint8_t*>(_data), _size);
+#endif
+            }
+
+            _buffer.clear();
+            _data = nullptr;
+            _size = 0;
+            _isMapped = false;
+            _isOpen = false;
+        }
+
+        bool MappedFile::map(const std::string& fullPath)
+        {
+            const std::string path = cocos2d::FileUtils::getInstance()->getSuitableFOpen(fullPath);
+
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+            HANDLE fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (fileHandle == INVALID_HANDLE_VALUE)
+                return false;
+
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(fileHandle, &size))
+            {
+                CloseHandle(fileHandle);
+                return false;
+            }
+
+            _fileHandle = fileHandle;
+            _size = static_cast<size_t>(size.QuadPart);
+
+            // An empty file can not be mapped but is still a valid file
+            if (_size == 0)
+                return true;
+
+            _mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (_mappingHandle)
+                _data = static_cast<const uint8_t*>(MapViewOfFile(_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+
+            if (!_data)
+            {
+                _isMapped = true;
+                close();
+                return false;
+            }
+
+            return true;
+#else
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                return false;
+
+            struct stat st;
+            if (fstat(fd, &st) != 0)
+            {
+                ::close(fd);
+                return false;
+            }
+
+            _size = static_cast<size_t>(st.st_size);
+            if (_size > 0)
+            {
+                void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (data == MAP_FAILED)
+                {
+                    ::close(fd);
+                    _size = 0;
+                    return false;
+                }
+
+                madvise(data, _size, MADV_SEQUENTIAL);
+                _data = static_cast<const uint8_t*>(data);
+            }
+
+            // The mapping stays valid after the descriptor is closed
+            ::close(fd);
+            return true;
+#endif
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef __CCIMEDITOR_MAPPEDFILE_H__
+#define __CCIMEDITOR_MAPPEDFILE_H__
+
+#include <string>
+#include <cstdint>
+#include "cocos2d.h"
+
+namespace CCImEditor
+{
+    namespace Internal
+    {
+        // Read-only view of a whole file. The file is memory-mapped when it lives on the
+        // local file system, otherwise (e.g. android assets) it is read into memory.
+        class MappedFile
+        {
+        public:
+            MappedFile() {};
+            ~MappedFile();
+
+            bool open(const std::string& file);
+            void close();
+
+            bool isOpen() const { return _isOpen; };
+            const uint8_t* getData() const { return _data; };
+            size_t getSize() const { return _size; };
+
+        private:
+            MappedFile(const MappedFile&) = delete;
+            void operator=(const MappedFile&) = delete;
+
+            bool map(const std::string& fullPath);
+
+            const uint8_t* _data = nullptr;
+            size_t _size = 0;
+            bool _isOpen = false;
+            bool _isMapped = false;
+            cocos2d::Data _buffer;
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+            void* _fileHandle = nullptr;
+            void* _mappingHandle = nullptr;
+#endif
+        };
+    }
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include "NodeFactory.h"
+#include "NodeImDrawer.h"
 
 namespace CCImEditor
 {
@@ -18,4 +19,51 @@ namespace CCImEditor
         
         return nullptr;
     }
+
+    void NodeFactory::removeDefaultProperties(const std::string& name, cocos2d::ValueMap& properties) const
+    {
+        NodeTypeMap::const_iterator it = _nodeTypes.find(name);
+        if (it != _nodeTypes.end())
+            it->second.removeDefaultProperties(properties);
+    }
+
+    void NodeFactory::addDrawer(cocos2d::Node* owner, ImPropertyGroup* nodePropertyGroup, const NodeType* nodeType)
+    {
+        NodeImDrawer* drawer = NodeImDrawer::create();
+        drawer->_nodePropertyGroup = nodePropertyGroup;
+        drawer->_nodeType = nodeType;
+        owner->addComponent(drawer);
+        owner->setCameraMask(owner->getCameraMask() | (1 << 15));
+    }
+
+    const cocos2d::ValueMap& NodeFactory::NodeType::getDefaultProperties() const
+    {
+        if (!_defaultProperties)
+        {
+            std::shared_ptr<cocos2d::ValueMap> defaultProperties = std::make_shared<cocos2d::ValueMap>();
+            cocos2d::RefPtr<cocos2d::Node> node = create();
+            if (node)
+            {
+                if (NodeImDrawer* drawer = node->getComponent<NodeImDrawer>())
+                    drawer->serialize(*defaultProperties);
+            }
+
+            _defaultProperties = std::move(defaultProperties);
+        }
+
+        return *_defaultProperties;
+    }
+
+    void NodeFactory::NodeType::removeDefaultProperties(cocos2d::ValueMap& properties) const
+    {
+        const cocos2d::ValueMap& defaultProperties = getDefaultProperties();
+        for (cocos2d::ValueMap::iterator property = properties.begin(); property != properties.end();)
+        {
+            cocos2d::ValueMap::const_iterator defaultProperty = defaultProperties.find(property->first);
+            if (defaultProperty != defaultProperties.end() && defaultProperty->second == property->second)
+                property = properties.erase(property);
+            else
+                ++property;
+        }
+    }
 }
@@ -2,8 +2,10 @@
 #define __CCIMEDITOR_NODEFACTORY_H__
 
 #include "cocos2d.h"
+#include "RegisteredType.h"
 
 #include <string>
+#include <memory>
 #include <unordered_map>
 
 namespace CCImEditor
@@ -15,38 +17,45 @@ namespace CCImEditor
         NodeFlags_CanBeRoot = 1 << 2,
     };
 
+    class ImPropertyGroup;
+
     class NodeFactory
     {
     public:
-        struct NodeType
+        struct NodeType : RegisteredType
         {
             friend class NodeFactory;
             
-            NodeType(const std::string& name, const std::string& displayName, uint32_t mask, const std::function<cocos2d::Node*()>& constructor)
-            : _name(name)
-            , _displayName(displayName)
-            , _mask(mask)
-            , _constructor(constructor)
+            NodeType(const std::string& name, const std::string& displayName, uint32_t mask)
+            : RegisteredType(name, displayName, mask)
             {
             }
 
-            const std::string& getName() const { return _name; };
-            const std::string& getDisplayName() const { return _displayName; };
-            uint32_t getMask() const { return _mask; };
-
             cocos2d::Node* create() const { return _constructor(); };
 
+            // Serialized properties of a new node of this type. Recorded from the first
+            // node created for it, as nodes can not be created yet when types are registered.
+            const cocos2d::ValueMap& getDefaultProperties() const;
+
+            // Removes the values a new node of this type already has, so they are not saved.
+            // Loading starts from a new node, nothing has to be done for the missing ones.
+            void removeDefaultProperties(cocos2d::ValueMap& properties) const;
+
         private:
-            std::string _name;
-            std::string _displayName;
-            uint32_t _mask;
             std::function<cocos2d::Node*()> _constructor;
+            mutable std::shared_ptr<const cocos2d::ValueMap> _defaultProperties;
         };
     
         template <typename NodePropertyGroupType, typename OwnerType>
         void registerNode(const char* name, const char* displayName, uint32_t mask = 0)
         {
-            std::function<cocos2d::Node*()> constructor = [name, displayName]() -> cocos2d::Node* {
+            auto result = NodeFactory::getInstance()->_nodeTypes.emplace(name, NodeType(name, displayName, mask));
+            if (!result.second)
+                return;
+
+            // Elements of the map do not move, nodes keep pointing to their type
+            const NodeType* nodeType = &result.first->second;
+            result.first->second._constructor = [nodeType]() -> cocos2d::Node* {
                 auto owner = OwnerType::create();
                 if (!owner)
                     return nullptr;
@@ -55,13 +64,7 @@ namespace CCImEditor
                 if (!nodePropertyGroup)
                     return nullptr;
 
-                const char* shortName = displayName;
-                while(const char* tmp = strstr(shortName, "/"))
-                {
-                    shortName = tmp + 1;
-                }
-                nodePropertyGroup->_shortName = shortName;
-                nodePropertyGroup->_typeName = name;
+                nodePropertyGroup->_type = nodeType;
 
                 if (!nodePropertyGroup->init())
                 {
@@ -71,23 +74,24 @@ namespace CCImEditor
                 nodePropertyGroup->_owner = owner;
                 nodePropertyGroup->autorelease();
 
-                NodeImDrawer* drawer = NodeImDrawer::create();
-                drawer->_nodePropertyGroup = nodePropertyGroup;
-                owner->addComponent(drawer);
-                owner->setCameraMask(owner->getCameraMask() | (1 << 15));
+                addDrawer(owner, nodePropertyGroup, nodeType);
                 return owner;
             };
-            NodeFactory::getInstance()->_nodeTypes.emplace(name, NodeType(name, displayName, mask, constructor));
         }
 
         typedef std::unordered_map<std::string, NodeType> NodeTypeMap;
         const NodeTypeMap& getNodeTypes() { return _nodeTypes; };
 
         cocos2d::Node* createNode(const std::string& name);
+
+        // See NodeType::removeDefaultProperties
+        void removeDefaultProperties(const std::string& name, cocos2d::ValueMap& properties) const;
         
         static NodeFactory* getInstance();
 
     private:
+        static void addDrawer(cocos2d::Node* owner, ImPropertyGroup* nodePropertyGroup, const NodeType* nodeType);
+
         NodeTypeMap _nodeTypes;
     };
 }
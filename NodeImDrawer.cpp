@@ -1,5 +1,11 @@
 #include "NodeImDrawer.h"
 #include "NodeFactory.h"
+#include "Editor.h"
+#include "JsonReader.h"
+#include "runtime/SceneLoader.h"
+#include <algorithm>
+#include <random>
+#include <mutex>
 
 namespace CCImEditor
 {
@@ -16,24 +22,196 @@ namespace CCImEditor
         }
     }
 
+    thread_local ImPropertyGroup::CallContext* ImPropertyGroup::s_callContext = nullptr;
+
+    const std::string& ImPropertyGroup::getTypeName() const
+    {
+        static const std::string empty;
+        return _type ? _type->getName() : empty;
+    }
+
+    const std::string& ImPropertyGroup::getShortName() const
+    {
+        static const std::string empty;
+        return _type ? _type->getShortName() : empty;
+    }
+
+    // Tables are shared by type and may be first needed on a worker thread during a save
+    const ImPropertyGroup::PropertyTable* ImPropertyGroup::getPropertyTable()
+    {
+        if (!hasStaticProperties())
+            return nullptr;
+
+        if (!_propertyTable)
+        {
+            static std::mutex mutex;
+            static std::unordered_map<uint32_t, std::shared_ptr<const PropertyTable>> tables;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            std::shared_ptr<const PropertyTable>& table = tables[_type ? _type->getId() : 0];
+            if (!table)
+            {
+                std::shared_ptr<PropertyTable> recorded = std::make_shared<PropertyTable>();
+                {
+                    CallContext call(this, Context::RECORD, nullptr, nullptr, recorded.get());
+                    draw();
+                }
+
+                // Groups created outside of the factories have no type to share a table with
+                if (!_type)
+                    recorded->_isShared = false;
+
+#if COCOS2D_DEBUG > 0
+                // Files are loaded by SceneLoader and compiled by SceneCompiler from the
+                // properties SceneLoader registers for the type, which have to keep up with draw()
+                if (recorded->_isShared)
+                {
+                    const SceneLoader::NodeType* nodeType = SceneLoader::getInstance()->getNodeType(getTypeName());
+                    const SceneLoader::ComponentType* componentType = nodeType ? nullptr : SceneLoader::getInstance()->getComponentType(getTypeName());
+                    const std::vector<RuntimeProperty>* properties = nodeType ? &nodeType->_properties : componentType ? &componentType->_properties : nullptr;
+                    if (!properties)
+                        CCLOGWARN("%s is not registered with SceneLoader", getTypeName().c_str());
+
+                    for (size_t i = 0; properties && i < recorded->_descriptors.size(); i++)
+                    {
+                        const std::string& key = recorded->_descriptors[i]._key;
+                        std::vector<RuntimeProperty>::const_iterator it = std::find_if(properties->begin(), properties->end(), [&key](const RuntimeProperty& property)
+                        {
+                            return property._key == key;
+                        });
+
+                        if (it == properties->end())
+                            CCLOGWARN("Property %s of %s has no setter in SceneLoader", key.c_str(), getTypeName().c_str());
+                        else if (nodeType && it->_code.empty())
+                            CCLOGWARN("Property %s of %s has no statement for SceneCompiler", key.c_str(), getTypeName().c_str());
+                    }
+                }
+#endif
+
+                table = std::move(recorded);
+            }
+
+            _propertyTable = table;
+        }
+
+        return _propertyTable->_isShared ? _propertyTable.get() : nullptr;
+    }
+
     void ImPropertyGroup::serialize(cocos2d::ValueMap& target)
     {
-        Context ctx = _context;
-        _context = Context::SERIALIZE;
-        _contextValue = &target;
+        if (const PropertyTable* table = getPropertyTable())
+        {
+            for (const PropertyDescriptor& descriptor : table->_descriptors)
+            {
+                descriptor._serialize(this, target[descriptor._key]);
+            }
+
+#if COCOS2D_DEBUG > 0
+            // The table is recorded from the first instance of the type. Another one declaring
+            // other properties in draw() would lose them, see hasStaticProperties.
+            if (!_isPropertyTableChecked)
+            {
+                cocos2d::ValueMap replayed;
+                {
+                    CallContext call(this, Context::SERIALIZE, &replayed, nullptr);
+                    draw();
+                }
+
+                for (const std::pair<const std::string, cocos2d::Value>& pair : replayed)
+                {
+                    if (target.find(pair.first) == target.end())
+                        CCLOGWARN("Property %s of %s is missing from the table of its type", pair.first.c_str(), getTypeName().c_str());
+                    CC_ASSERT(target.find(pair.first) != target.end());
+                }
+                _isPropertyTableChecked = true;
+            }
+#endif
+            return;
+        }
+
+        CallContext call(this, Context::SERIALIZE, &target, nullptr);
         draw();
-        _contextValue = nullptr;
-        _context = ctx;
     }
 
     void ImPropertyGroup::deserialize(const cocos2d::ValueMap& source)
     {
-        Context ctx = _context;
-        _context = Context::DESERIALIZE;
-        _contextValue = const_cast<cocos2d::ValueMap*>(&source); // save only, deserializer only take const-qualified source
-        draw();
-        _contextValue = nullptr;
-        _context = ctx;
+        // Values left out of the source are those a new group already has
+        if (source.empty())
+            return;
+
+        if (const PropertyTable* table = getPropertyTable())
+        {
+            // In declaration order, later setters may depend on earlier ones (e.g. a model before its materials)
+            for (const PropertyDescriptor& descriptor : table->_descriptors)
+            {
+                cocos2d::ValueMap::const_iterator it = source.find(descriptor._key);
+                if (it != source.end())
+                    descriptor._deserialize(this, it->second);
+            }
+        }
+        else
+        {
+            CallContext call(this, Context::DESERIALIZE, nullptr, &source);
+            draw();
+        }
+
+        setDirty();
+    }
+
+    bool ImPropertyGroup::deserialize(Internal::JsonReader& reader)
+    {
+        const PropertyTable* table = getPropertyTable();
+        if (!table)
+        {
+            // Replaying draw() looks properties up by key, it needs the whole map
+            cocos2d::Value source;
+            if (!reader.readValue(source))
+                return false;
+
+            if (source.getType() == cocos2d::Value::Type::MAP)
+                deserialize(source.asValueMap());
+            return true;
+        }
+
+        // Where the value of each property starts, members are in any order in the json but
+        // are set in declaration order like above
+        std::vector<size_t> offsets(table->_descriptors.size(), SIZE_MAX);
+        bool isEmpty = true;
+
+        if (!reader.beginObject())
+            return false;
+
+        std::string_view key;
+        while (reader.nextMember(key))
+        {
+            isEmpty = false;
+            std::unordered_map<std::string, size_t>::const_iterator it = table->_indices.find(std::string(key));
+            if (it != table->_indices.end())
+                offsets[it->second] = reader.getOffset();
+
+            if (!reader.skipValue())
+                return false;
+        }
+
+        if (reader.hasError())
+            return false;
+
+        if (isEmpty)
+            return true;
+
+        for (size_t i = 0; i < offsets.size(); ++i)
+        {
+            if (offsets[i] == SIZE_MAX)
+                continue;
+
+            Internal::JsonReader valueReader = reader.readerAt(offsets[i]);
+            cocos2d::Value value;
+            if (valueReader.readValue(value))
+                table->_descriptors[i]._deserialize(this, value);
+        }
+
+        setDirty();
+        return true;
     }
 
     void ImPropertyGroup::serializeAnimations(cocos2d::ValueMap& target)
@@ -138,14 +316,33 @@ namespace CCImEditor
                 }
             }
         }
+
+        setDirty();
     }
 
-    void ImPropertyGroup::sample()
+    bool ImPropertyGroup::sample()
     {
-        Context ctx = _context;
-        _context = Context::SAMPLE;
+        if (const PropertyTable* table = getPropertyTable())
+        {
+            NodeImDrawer* drawer = getDrawer();
+            auto animation = _animations.find(drawer->_animationName);
+            if (animation == _animations.end())
+                return false;
+
+            // Only the animated properties are visited
+            bool isChanged = false;
+            for (const auto& [key, keys] : animation->second._values)
+            {
+                auto it = table->_indices.find(key);
+                if (it != table->_indices.end() && table->_descriptors[it->second]._sample(this, keys, drawer->_currentFrame))
+                    isChanged = true;
+            }
+            return isChanged;
+        }
+
+        CallContext call(this, Context::SAMPLE, nullptr, nullptr);
         draw();
-        _context = ctx;
+        return call._isChanged;
     }
 
     bool ImPropertyGroup::init()
@@ -153,6 +350,67 @@ namespace CCImEditor
         return true;
     }
 
+    void ImPropertyGroup::setDirty()
+    {
+        cocos2d::Ref* owner = _owner.get();
+        if (cocos2d::Node* node = dynamic_cast<cocos2d::Node*>(owner))
+        {
+            if (NodeImDrawer* drawer = node->getComponent<NodeImDrawer>())
+                drawer->setDirty();
+        }
+        else if (cocos2d::Component* component = dynamic_cast<cocos2d::Component*>(owner))
+        {
+            // Not attached yet, or removed from its node
+            if (component->getOwner())
+            {
+                if (NodeImDrawer* drawer = component->getOwner()->getComponent<NodeImDrawer>())
+                    drawer->setDirty();
+            }
+        }
+    }
+
+    void ImPropertyGroup::propertyChanged(const char* key)
+    {
+        NodeImDrawer* drawer = getDrawer();
+        cocos2d::Node* node = drawer ? drawer->getOwner() : nullptr;
+        Editor::getInstance()->getEventBus().publish(EditorEvents::PropertyChanged{node, this, key});
+    }
+
+    void ImPropertyGroup::setUndoProperties(CustomCommand* command, const char* key, cocos2d::Value after)
+    {
+        NodeImDrawer* drawer = getDrawer();
+        if (!drawer)
+            return;
+
+        cocos2d::ValueMap before;
+        before.emplace(key, std::move(_undoValue));
+        _undoValue = cocos2d::Value::Null;
+
+        cocos2d::ValueMap afterMap;
+        afterMap.emplace(key, std::move(after));
+        command->setProperties(Command::getNodeId(drawer->getOwner()), getComponentName(), std::move(before), std::move(afterMap));
+    }
+
+    std::string ImPropertyGroup::getMergeKey(const char* key) const
+    {
+        NodeImDrawer* drawer = getDrawer();
+        const std::string nodeId = drawer ? Command::getNodeId(drawer->getOwner()) : std::string();
+        if (nodeId.empty())
+            return std::string();
+
+        return nodeId + "|" + getComponentName() + "|" + key;
+    }
+
+    // Groups of components are found back by the name of their component
+    std::string ImPropertyGroup::getComponentName() const
+    {
+        cocos2d::Component* owner = dynamic_cast<cocos2d::Component*>(_owner.get());
+        if (owner && owner != getDrawer())
+            return owner->getName();
+
+        return std::string();
+    }
+
     NodeImDrawer* NodeImDrawer::create() {
         NodeImDrawer* obj = new (std::nothrow)NodeImDrawer();
         if (obj && obj->init())
@@ -171,9 +429,16 @@ namespace CCImEditor
             return false;
 
         setName("CCImEditor.NodeImDrawer");
+        _id = generateId();
         return true;
     }
 
+    std::string NodeImDrawer::generateId()
+    {
+        static std::mt19937_64 engine(std::random_device{}());
+        return cocos2d::StringUtils::format("%016llx", static_cast<unsigned long long>(engine()));
+    }
+
     void NodeImDrawer::draw()
     {
         _nodePropertyGroup->draw();
@@ -185,8 +450,29 @@ namespace CCImEditor
         }
     }
 
+    void NodeImDrawer::setDirty()
+    {
+        _isDirty = true;
+        setChildrenDirty(getOwner());
+    }
+
+    // A subtree cache is only set with those of all the descendants, so the walk stops at
+    // the first ancestor which has none
+    void NodeImDrawer::setChildrenDirty(cocos2d::Node* parent)
+    {
+        for (cocos2d::Node* node = parent; node; node = node->getParent())
+        {
+            NodeImDrawer* drawer = node->getComponent<NodeImDrawer>();
+            if (!drawer || !drawer->_subtreeCache)
+                return;
+
+            drawer->_subtreeCache.reset();
+        }
+    }
+
     void NodeImDrawer::setComponentPropertyGroup(std::string name, ImPropertyGroup* group)
     {
+        setDirty();
         if (group)
         {
             _componentPropertyGroups[name] = group;
@@ -214,10 +500,8 @@ namespace CCImEditor
 
     uint32_t NodeImDrawer::getMask() const
     {
-        const NodeFactory::NodeTypeMap& nodeTypes = NodeFactory::getInstance()->getNodeTypes();
-        NodeFactory::NodeTypeMap::const_iterator it = nodeTypes.find(getTypeName());
-        CC_ASSERT(it != nodeTypes.end());
-        return it->second.getMask();
+        CC_ASSERT(_nodeType);
+        return _nodeType->getMask();
     }
 
     void NodeImDrawer::play(const std::string& animation, AnimationWrapMode wrapMode)
@@ -247,6 +531,7 @@ namespace CCImEditor
                 {
                     it->second._samples = sample;
                     it->second._maxFrame = maxFrame;
+                    drawer->setDirty();
                 }
             }
         });
@@ -368,12 +653,18 @@ namespace CCImEditor
             if (NodeImDrawer* drawer = node->getComponent<NodeImDrawer>())
             {
                 ImPropertyGroup *group = drawer->getNodePropertyGroup();
-                group->sample();
+                bool isChanged = group->sample();
 
                 for (const auto &[componentName, group] : drawer->getComponentPropertyGroups())
                 {
-                    group->sample();
+                    if (group->sample())
+                        isChanged = true;
                 }
+
+                // The serialized cache is only dropped when a sampled value differs from the
+                // one serialize read before, e.g. not on a paused frame or unanimated node
+                if (isChanged)
+                    drawer->setDirty();
             }
         });
     }
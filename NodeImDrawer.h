@@ -3,14 +3,22 @@
 
 #include "cocos2d.h"
 #include "PropertyImDrawer.h"
+#include "AnimationWrapMode.h"
+#include "CustomValueStore.h"
+#include "NodeFactory.h"
+#include "SceneFragment.h"
 #include "commands/CustomCommand.h"
 #include <type_traits>
 #include <utility>
+#include <memory>
+#include <functional>
 
 namespace CCImEditor
 {
     namespace Internal
     {
+        class JsonReader;
+
         namespace Animation
         {
             struct Sequence;
@@ -64,6 +72,10 @@ namespace CCImEditor
 
         struct DefaultGetterBase{};
 
+        // The group keeps the value of properties whose getter is a DefaultGetter
+        template <typename T>
+        struct IsDefaultGetter : std::is_base_of<DefaultGetterBase, std::decay_t<T>> {};
+
         // Deduce type has a lerp function
         template <typename T, typename U, typename = void>
         struct HasLerp : std::false_type {};
@@ -73,6 +85,25 @@ namespace CCImEditor
             decltype(T::lerp(std::declval<U>(), std::declval<U>(), std::declval<float>()))
         >> : std::true_type {};
 
+        // Deduce type can be compared with ==
+        template <typename T, typename = void>
+        struct IsEqualityComparable : std::false_type {};
+
+        template <typename T>
+        struct IsEqualityComparable<T, std::void_t<
+            decltype(static_cast<bool>(std::declval<const T&>() == std::declval<const T&>()))
+        >> : std::true_type {};
+
+        // Getters and setters which behave the same for every instance of a type: member
+        // function pointers, function pointers, lambdas without captures and DefaultGetter
+        template <typename T>
+        struct IsStateless : std::bool_constant<
+            std::is_member_function_pointer<T>::value ||
+            std::is_pointer<T>::value ||
+            std::is_empty<T>::value ||
+            std::is_base_of<DefaultGetterBase, T>::value
+        > {};
+
         void performRecursively(cocos2d::Node *node, std::function<void(cocos2d::Node*)> func);
     }
 
@@ -86,6 +117,7 @@ namespace CCImEditor
             SERIALIZE,
             DESERIALIZE,
             SAMPLE,
+            RECORD,
         };
 
         friend class NodeFactory;
@@ -97,70 +129,135 @@ namespace CCImEditor
         void serialize(cocos2d::ValueMap&);
         void serializeAnimations(cocos2d::ValueMap&);
         void deserialize(const cocos2d::ValueMap&);
+        // Reads the properties object at the reader, building the value of one property at a
+        // time instead of a map of all of them. Returns false if the json is malformed.
+        bool deserialize(Internal::JsonReader&);
         void deserializeAnimations(const cocos2d::ValueMap&);
-        void sample();
-        const std::string& getTypeName() const {return _typeName;}
-        const std::string& getShortName() const {return _shortName;}
+        // Sets the values of the current animation at the current frame. Returns true if a
+        // sampled value changed.
+        bool sample();
+        // Null for groups created outside of NodeFactory and ComponentFactory
+        const RegisteredType* getType() const {return _type;}
+        const std::string& getTypeName() const;
+        const std::string& getShortName() const;
         virtual bool init();
         cocos2d::Ref* getOwner() const {return _owner;}
+
+        // Whether serialize may run on a worker thread while the main thread waits. Groups whose
+        // getters change state (e.g. cached transforms) or read other objects keep false, and
+        // are serialized on the main thread before saves fan out.
+        virtual bool hasThreadSafeGetters() const {return false;}
+
+        // Whether draw() declares the same properties for every instance of the type, which
+        // lets them be recorded once in a table shared by the type. Types declaring properties
+        // which depend on the instance (e.g. per mesh of a model) return false and keep
+        // replaying draw().
+        virtual bool hasStaticProperties() const {return true;}
     private:
-        // Try to get value from _customValue if getter is a DefaultGetterBase.
-        // If getter is not a DefaultGetterBase or value not found in _customValue,
+        // Try to get value from _customValues if getter is a DefaultGetterBase.
+        // If getter is not a DefaultGetterBase or value not found in _customValues,
         // call the getter and return its result
         template <class DrawerType = Internal::DefaultArgumentTag, class PropertyType, class Getter, class Object>
         PropertyType getFromCustomValueOrGetter(const char *key, Getter &&getter, Object&& object)
         {
-            using PropertyOrDrawerType = typename std::conditional<std::is_same<DrawerType, Internal::DefaultArgumentTag>::value, PropertyType, DrawerType>::type;
-
-            if (std::is_base_of<Internal::DefaultGetterBase, Getter>::value)
+            if constexpr (Internal::IsDefaultGetter<Getter>::value)
             {
-                auto it = _customValue.find(key);
-                if (it != _customValue.end())
-                {
-                    PropertyType v;
-                    if (CCImEditor::PropertyImDrawer<PropertyOrDrawerType>::deserialize(it->second, v))
-                    {
-                        return v;
-                    }
-                }
+                PropertyType v;
+                if (_customValues.get(key, v))
+                    return v;
             }
             
             return std::invoke(std::forward<Getter>(getter), std::forward<Object>(object));
         }
 
+        // Sets a sampled value, returns true if the getter reads another value afterwards.
+        // Types without == are taken as changed.
+        template <class DrawerType, class PropertyType, class Getter, class Setter, class Object>
+        bool setSampledValue(const char* key, const Getter& getter, const Setter& setter, Object&& object, const PropertyType& v)
+        {
+            if constexpr (Internal::IsEqualityComparable<PropertyType>::value)
+            {
+                const PropertyType before = getFromCustomValueOrGetter<DrawerType, PropertyType>(key, getter, object);
+                std::invoke(setter, object, v);
+                return !(before == getFromCustomValueOrGetter<DrawerType, PropertyType>(key, getter, object));
+            }
+            else
+            {
+                std::invoke(setter, object, v);
+                return true;
+            }
+        }
+
         // Return a setter warpper which can be used in command history.
-        // The warpper will write value to _customValue too.
-        template <class DrawerType = Internal::DefaultArgumentTag, class PropertyType, class Setter, class Object>
+        // The warpper will write value to _customValues too if the group keeps it.
+        template <bool KeepValue, class PropertyType, class Setter, class Object>
         std::function<void()> getSetterWrapper(const char *key, Setter &&setter, Object&& object, const PropertyType& v)
         {
-            using PropertyOrDrawerType = typename std::conditional<std::is_same<DrawerType, Internal::DefaultArgumentTag>::value, PropertyType, DrawerType>::type;
-
             std::string keyStr = key; // cache key
             auto setterWrapper = std::bind(std::forward<Setter>(setter), std::forward<Object>(object), v);
             return [this, keyStr, v, setterWrapper]()
             {
-                PropertyImDrawer<PropertyOrDrawerType>::serialize(_customValue[keyStr], v);
+                if (KeepValue)
+                    _customValues.set(keyStr.c_str(), v);
                 setterWrapper();
+                setDirty();
             };
         }
 
-    protected:
-
-        template <class DrawerType = Internal::DefaultArgumentTag, class PropertyType>
-        bool getCustomValue(const char *key, PropertyType& v)
+        // Calls apply with the value of the keys at frame, interpolated if the type has a lerp
+        template <class PropertyImDrawerType, class PropertyType, class Apply>
+        static void sampleKeys(const std::map<int, cocos2d::Value>& keys, int frame, Apply&& apply)
         {
-            using PropertyOrDrawerType = typename std::conditional<std::is_same<DrawerType, Internal::DefaultArgumentTag>::value, PropertyType, DrawerType>::type;
-
-            auto it = _customValue.find(key);
-            if (it != _customValue.end())
+            auto it1 = keys.upper_bound(frame);
+            auto it0 = std::prev(it1);
+            if (it1 != keys.end() && it0 != keys.end())
             {
-                if (CCImEditor::PropertyImDrawer<PropertyOrDrawerType>::deserialize(it->second, v))
+                if constexpr (Internal::HasLerp<PropertyImDrawerType, PropertyType>::value)
                 {
-                    return true;
+                    PropertyType v0;
+                    PropertyType v1;
+                    if (PropertyImDrawerType::deserialize(it0->second, v0) &&
+                        PropertyImDrawerType::deserialize(it1->second, v1))
+                    {
+                        float offset = (float)(frame - it0->first) / (it1->first - it0->first);
+                        apply(PropertyImDrawerType::lerp(v0, v1, offset));
+                    }
+                }
+                else
+                {
+                    PropertyType v0;
+                    if (PropertyImDrawerType::deserialize(it0->second, v0))
+                        apply(v0);
                 }
             }
-            
-            return false;
+            else if (it0 != keys.end())
+            {
+                PropertyType v0;
+                if (PropertyImDrawerType::deserialize(it0->second, v0))
+                    apply(v0);
+            }
+            else if (it1 != keys.end())
+            {
+                PropertyType v1;
+                if (PropertyImDrawerType::deserialize(it1->second, v1))
+                    apply(v1);
+            }
+        }
+
+        struct PropertyTable;
+
+        // Adds the property to the table of the type, with thunks calling the getter and setter
+        // on the owner of the group they are given
+        template <class DrawerType, class PropertyType, class Getter, class Setter, class Object>
+        void recordProperty(PropertyTable& table, const char* key, const Getter& getter, const Setter& setter, const Object& object);
+
+    protected:
+
+        // Values are kept with the type of the property, DrawerType does not matter
+        template <class DrawerType = Internal::DefaultArgumentTag, class PropertyType>
+        bool getCustomValue(const char *key, PropertyType& v) const
+        {
+            return _customValues.get(key, v);
         }
 
         template <class DrawerType = Internal::DefaultArgumentTag, class Getter, class Setter, class Object, class... Args>
@@ -180,7 +277,9 @@ namespace CCImEditor
             else
                 key = label;
 
-            if (_context == Context::DRAW)
+            const CallContext* call = getCallContext();
+            const Context context = call ? call->_context : Context::DRAW;
+            if (context == Context::DRAW)
             {
                 // object is always valid for undo/redo. It will be retained if it is removed form scene by a command.
                 using ObjectType = typename std::remove_pointer<typename std::remove_cv<typename std::remove_reference<Object>::type>::type>::type;
@@ -191,8 +290,11 @@ namespace CCImEditor
                     if (!_undo)
                     {
                         auto v0 = getFromCustomValueOrGetter<DrawerType, PropertyType>(key, std::forward<Getter>(getter), std::forward<Object>(object));
-                        _undo = getSetterWrapper<DrawerType>(key, std::forward<Setter>(setter), std::forward<Object>(object), v0);
+                        _undo = getSetterWrapper<Internal::IsDefaultGetter<Getter>::value>(key, std::forward<Setter>(setter), std::forward<Object>(object), v0);
                         _activeID = ImGui::GetItemID();
+                        _undoValue = cocos2d::Value::Null;
+                        if (!getDrawer()->isRecordingAnimation())
+                            PropertyImDrawerType::serialize(_undoValue, v0);
                     }
                     else if (_activeID != ImGui::GetItemID())
                     {
@@ -202,103 +304,78 @@ namespace CCImEditor
                     auto drawer = getDrawer();
                     if (drawer->isRecordingAnimation())
                         PropertyImDrawerType::serialize(_animations[drawer->_animationName]._values[key][drawer->_currentFrame], v);
-                    else
-                        PropertyImDrawerType::serialize(_customValue[key], v);
+                    else if (Internal::IsDefaultGetter<Getter>::value)
+                        _customValues.set(key, v);
                     std::invoke(std::forward<Setter>(setter), std::forward<Object>(object), v);
+                    setDirty();
+                    propertyChanged(key);
                 }
                 else
                 {
                     if (_undo && _activeID == ImGui::GetItemID())
                     {
                         CustomCommand* cmd = CustomCommand::create(
-                            getSetterWrapper<DrawerType>(key, std::forward<Setter>(setter), std::forward<Object>(object), v),
-                            _undo
+                            getSetterWrapper<Internal::IsDefaultGetter<Getter>::value>(key, std::forward<Setter>(setter), std::forward<Object>(object), v),
+                            _undo,
+                            getMergeKey(key)
                         );
+                        if (cmd && !_undoValue.isNull())
+                        {
+                            cocos2d::Value v1;
+                            PropertyImDrawerType::serialize(v1, v);
+                            setUndoProperties(cmd, key, std::move(v1));
+                        }
                         Editor::getInstance()->getCommandHistory().queue(cmd, false);
                         _undo = nullptr;
                         _activeID = 0;
                     }
                 }
             }
-            else if (_context == Context::SAMPLE)
+            else if (context == Context::SAMPLE)
             {
-                do
+                auto drawer = getDrawer();
+                auto animation = _animations.find(drawer->_animationName);
+                if (animation != _animations.end())
                 {
-                    auto drawer = getDrawer();
-                    auto animation = _animations.find(drawer->_animationName);
-                    if (animation == _animations.end())
-                        break;
-
                     auto property = animation->second._values.find(key);
-                    if (property == animation->second._values.end())
-                        break;
-
-                    auto it1 = property->second.upper_bound(drawer->_currentFrame);
-                    auto it0 = std::prev(it1);
-                    if (it1 != property->second.end() && it0 != property->second.end())
+                    if (property != animation->second._values.end())
                     {
-                        if constexpr (Internal::HasLerp<PropertyImDrawerType, PropertyType>::value)
-                        {
-                            PropertyType v0;
-                            PropertyType v1;
-                            if (PropertyImDrawerType::deserialize(it0->second, v0) &&
-                                PropertyImDrawerType::deserialize(it1->second, v1))
-                            {
-                                float offset = (float)(drawer->_currentFrame - it0->first) / (it1->first - it0->first);
-                                PropertyType v = PropertyImDrawerType::lerp(v0, v1, offset);
-                                std::invoke(std::forward<Setter>(setter), std::forward<Object>(object), v);
-                            }
-                        }
-                        else
+                        sampleKeys<PropertyImDrawerType, PropertyType>(property->second, drawer->_currentFrame, [this, key, call, &getter, &setter, &object](const PropertyType& v)
                         {
-                            PropertyType v0;
-                            if (PropertyImDrawerType::deserialize(it0->second, v0))
-                            {
-                                std::invoke(std::forward<Setter>(setter), std::forward<Object>(object), v0);
-                            }
-                        }
+                            if (setSampledValue<DrawerType>(key, getter, setter, object, v))
+                                call->_isChanged = true;
+                        });
                     }
-                    else if (it0 != property->second.end())
-                    {
-                        PropertyType v0;
-                        if (PropertyImDrawerType::deserialize(it0->second, v0))
-                        {
-                            std::invoke(std::forward<Setter>(setter), std::forward<Object>(object), v0);
-                        }
-                    }
-                    else if (it1 != property->second.end())
-                    {
-                        PropertyType v1;
-                        if (PropertyImDrawerType::deserialize(it1->second, v1))
-                        {
-                            std::invoke(std::forward<Setter>(setter), std::forward<Object>(object), v1);
-                        }
-                    }
-                } while (false);
+                }
             }
-            else if (_context == Context::SERIALIZE)
+            else if (context == Context::SERIALIZE)
             {
                 const auto& v = getFromCustomValueOrGetter<DrawerType, PropertyType>(key, std::forward<Getter>(getter), std::forward<Object>(object));
-                PropertyImDrawerType::serialize((*_contextValue)[key], v);
+                PropertyImDrawerType::serialize((*call->_target)[key], v);
             }
-            else if (_context == Context::DESERIALIZE)
+            else if (context == Context::DESERIALIZE)
             {
-                cocos2d::ValueMap::const_iterator it = _contextValue->find(key);
-                if (it != _contextValue->end())
+                cocos2d::ValueMap::const_iterator it = call->_source->find(key);
+                if (it != call->_source->end())
                 {
                     PropertyType v;
                     if (PropertyImDrawerType::deserialize(it->second, v))
                     {
-                        PropertyImDrawerType::serialize(_customValue[key], v);
+                        if (Internal::IsDefaultGetter<Getter>::value)
+                            _customValues.set(key, v);
                         std::invoke(std::forward<Setter>(setter), std::forward<Object>(object), v);
                     }
                 }
             }
+            else if (context == Context::RECORD)
+            {
+                recordProperty<DrawerType, PropertyType>(*call->_table, key, getter, setter, object);
+            }
         }
 
         bool drawHeader(const char* label)
         {
-            if (_context == Context::DRAW && !ImGui::CollapsingHeader(label, ImGuiTreeNodeFlags_DefaultOpen))
+            if (getContext() == Context::DRAW && !ImGui::CollapsingHeader(label, ImGuiTreeNodeFlags_DefaultOpen))
                 return false;
 
             return true;
@@ -306,16 +383,38 @@ namespace CCImEditor
 
         bool drawHeader(const char* label, bool* visible)
         {
-            if (_context == Context::DRAW && !ImGui::CollapsingHeader(label, visible, ImGuiTreeNodeFlags_DefaultOpen))
+            if (getContext() == Context::DRAW && !ImGui::CollapsingHeader(label, visible, ImGuiTreeNodeFlags_DefaultOpen))
                 return false;
 
             return true;
         }
 
-        Context _context = Context::DRAW;
-        cocos2d::ValueMap _customValue;
+        // Mode of the replay of draw() running on the calling thread
+        Context getContext() const
+        {
+            const CallContext* call = getCallContext();
+            return call ? call->_context : Context::DRAW;
+        }
+
+        Internal::CustomValueStore _customValues;
         
     private:
+        // Marks the node owning this group as modified, see NodeImDrawer::isDirty
+        void setDirty();
+
+        // Publishes EditorEvents::PropertyChanged for an edit in draw
+        void propertyChanged(const char* key);
+
+        // Lets the command of an edit in draw be serialized, from _undoValue to after
+        void setUndoProperties(CustomCommand* command, const char* key, cocos2d::Value after);
+
+        // Identifies the edits of a property in draw by the node id and component name, empty
+        // when the group has no node
+        std::string getMergeKey(const char* key) const;
+
+        // Name of the component owning the group, empty for the group of the node itself
+        std::string getComponentName() const;
+
         NodeImDrawer* getDrawer() const 
         {
             cocos2d::Ref* owner = _owner.get();
@@ -330,10 +429,75 @@ namespace CCImEditor
             }
         }
 
-        std::string _typeName;
-        std::string _shortName;
-        cocos2d::ValueMap* _contextValue = nullptr;
+        const RegisteredType* _type = nullptr;
+
+        // State of one serialize, deserialize or sample call. property() finds it through the
+        // calling thread instead of members of the group, so different groups can be replayed
+        // on several threads at once, and a replay can start the replay of another group.
+        struct CallContext
+        {
+            CallContext(const ImPropertyGroup* group, Context context, cocos2d::ValueMap* target, const cocos2d::ValueMap* source, PropertyTable* table = nullptr)
+            : _group(group)
+            , _context(context)
+            , _target(target)
+            , _source(source)
+            , _table(table)
+            , _previous(s_callContext)
+            {
+                s_callContext = this;
+            }
+
+            ~CallContext()
+            {
+                s_callContext = _previous;
+            }
+
+            const ImPropertyGroup* _group;
+            Context _context;
+            cocos2d::ValueMap* _target;
+            const cocos2d::ValueMap* _source;
+            PropertyTable* _table;
+            CallContext* _previous;
+            mutable bool _isChanged = false; // set by SAMPLE when a sampled value changed
+        };
+        static thread_local CallContext* s_callContext;
+
+        // Properties of a registered type in the order draw() declares them, recorded once by
+        // replaying draw() in the RECORD context. serialize, deserialize and sample go through
+        // it instead of draw(). A type whose draw() uses getters or setters with state (lambda
+        // captures) or objects other than the owner can not share a table, and keeps replaying.
+        // Recording only sees the properties of the first instance, types whose properties
+        // vary between instances opt out with hasStaticProperties.
+        struct PropertyDescriptor
+        {
+            std::string _key;
+            std::function<void(ImPropertyGroup*, cocos2d::Value&)> _serialize;
+            std::function<void(ImPropertyGroup*, const cocos2d::Value&)> _deserialize;
+            std::function<bool(ImPropertyGroup*, const std::map<int, cocos2d::Value>&, int)> _sample; // true if the value changed
+        };
+
+        struct PropertyTable
+        {
+            std::vector<PropertyDescriptor> _descriptors;
+            std::unordered_map<std::string, size_t> _indices;
+            bool _isShared = true;
+        };
+
+        // nullptr if the type has to replay draw()
+        const PropertyTable* getPropertyTable();
+        std::shared_ptr<const PropertyTable> _propertyTable;
+#if COCOS2D_DEBUG > 0
+        bool _isPropertyTableChecked = false; // against a replay of draw(), once per instance
+#endif
+
+        // The call replaying this group, if any
+        const CallContext* getCallContext() const
+        {
+            return s_callContext && s_callContext->_group == this ? s_callContext : nullptr;
+        }
+
         std::function<void()> _undo;
+        cocos2d::Value _undoValue; // serialized value before the edit, null while recording an animation
         ImGuiID _activeID = 0;
         cocos2d::WeakPtr<cocos2d::Ref> _owner;
 
@@ -367,13 +531,59 @@ namespace CCImEditor
         T _defaultValue;
     };
 
-    enum class AnimationWrapMode
+    template <class DrawerType, class PropertyType, class Getter, class Setter, class Object>
+    void ImPropertyGroup::recordProperty(PropertyTable& table, const char* key, const Getter& getter, const Setter& setter, const Object& object)
     {
-        Normal,
-        Loop,
-        Reverse,
-        ReverseLoop,
-    };
+        using PropertyOrDrawerType = typename std::conditional<std::is_same<DrawerType, Internal::DefaultArgumentTag>::value, PropertyType, DrawerType>::type;
+        using PropertyImDrawerType = PropertyImDrawer<PropertyOrDrawerType>;
+        using ObjectType = typename std::remove_pointer<Object>::type;
+
+        if constexpr (!Internal::IsStateless<Getter>::value || !Internal::IsStateless<Setter>::value || !std::is_convertible<Object, cocos2d::Ref*>::value)
+        {
+            table._isShared = false;
+        }
+        else
+        {
+            if (static_cast<cocos2d::Ref*>(object) != getOwner())
+            {
+                table._isShared = false;
+                return;
+            }
+
+            const std::string keyStr = key;
+            PropertyDescriptor descriptor;
+            descriptor._key = keyStr;
+            descriptor._serialize = [keyStr, getter](ImPropertyGroup* group, cocos2d::Value& target)
+            {
+                ObjectType* owner = static_cast<ObjectType*>(group->getOwner());
+                PropertyImDrawerType::serialize(target, group->getFromCustomValueOrGetter<DrawerType, PropertyType>(keyStr.c_str(), getter, owner));
+            };
+            descriptor._deserialize = [keyStr, setter](ImPropertyGroup* group, const cocos2d::Value& source)
+            {
+                PropertyType v;
+                if (PropertyImDrawerType::deserialize(source, v))
+                {
+                    if (Internal::IsDefaultGetter<Getter>::value)
+                        group->_customValues.set(keyStr.c_str(), v);
+                    std::invoke(setter, static_cast<ObjectType*>(group->getOwner()), v);
+                }
+            };
+            descriptor._sample = [keyStr, getter, setter](ImPropertyGroup* group, const std::map<int, cocos2d::Value>& keys, int frame)
+            {
+                ObjectType* owner = static_cast<ObjectType*>(group->getOwner());
+                bool isChanged = false;
+                sampleKeys<PropertyImDrawerType, PropertyType>(keys, frame, [&keyStr, &getter, &setter, group, owner, &isChanged](const PropertyType& v)
+                {
+                    if (group->setSampledValue<DrawerType>(keyStr.c_str(), getter, setter, owner, v))
+                        isChanged = true;
+                });
+                return isChanged;
+            };
+
+            table._indices[keyStr] = table._descriptors.size();
+            table._descriptors.push_back(std::move(descriptor));
+        }
+    }
 
     class NodeImDrawer : public cocos2d::Component
     {
@@ -392,13 +602,37 @@ namespace CCImEditor
 
         const std::string& getTypeName() const {return _nodePropertyGroup->getTypeName();}
         const std::string& getShortName() const {return _nodePropertyGroup->getShortName();}
+        const NodeFactory::NodeType* getNodeType() const {return _nodeType;}
         ImPropertyGroup* getNodePropertyGroup() {return _nodePropertyGroup;}
 
+        // Random identifier kept across saves, lets diff and merge match nodes whose name,
+        // type or position changed. Copies of a node get a new one, see generateId.
+        const std::string& getId() const {return _id;}
+        void setId(const std::string& id) {_id = id; setDirty();}
+        static std::string generateId();
+
         const std::string& getFilename() const {return _filename;}
-        void setFilename(const std::string& filename) {_filename = filename;}
+        void setFilename(const std::string& filename) {_filename = filename; setDirty();}
 
-        void setNodePropertyGroup(ImPropertyGroup* group) {_nodePropertyGroup = group;}
+        void setNodePropertyGroup(ImPropertyGroup* group) {_nodePropertyGroup = group; setDirty();}
         void setComponentPropertyGroup(std::string name, ImPropertyGroup* group);
+
+        // A node is dirty when it changed since its serialization was cached. The cache holds
+        // the node, its components and animations but not its children, so saving only
+        // replays the property groups of dirty nodes.
+        bool isDirty() const {return _isDirty;}
+        void setDirty();
+        const std::shared_ptr<const cocos2d::ValueMap>& getSerializedCache() const {return _serializedCache;}
+        void setSerializedCache(std::shared_ptr<const cocos2d::ValueMap> cache) {_serializedCache = std::move(cache); _isDirty = false;}
+
+        // The fragment of the node and its descendants from the last serialization, dropped
+        // when one of them is dirtied or gets other children. Saves share it instead of
+        // copying the subtree.
+        const std::shared_ptr<const SceneFragment>& getSubtreeCache() const {return _subtreeCache;}
+        void setSubtreeCache(std::shared_ptr<const SceneFragment> cache) {_subtreeCache = std::move(cache);}
+
+        // Called by the commands which add, remove or move children of parent
+        static void setChildrenDirty(cocos2d::Node* parent);
         ImPropertyGroup* getComponentPropertyGroup(std::string name) {return _componentPropertyGroups[name];}
         const std::map<std::string, cocos2d::RefPtr<ImPropertyGroup>>& getComponentPropertyGroups() const {return _componentPropertyGroups;}
 
@@ -416,9 +650,14 @@ namespace CCImEditor
         std::unordered_map<std::string, bool> getAnimationNames() const;
 
         uint32_t getMask() const;
+        const NodeFactory::NodeType* _nodeType = nullptr;
         cocos2d::RefPtr<ImPropertyGroup> _nodePropertyGroup;
         std::map<std::string, cocos2d::RefPtr<ImPropertyGroup>> _componentPropertyGroups;
+        std::string _id;
         std::string _filename;
+        bool _isDirty = true;
+        std::shared_ptr<const cocos2d::ValueMap> _serializedCache;
+        std::shared_ptr<const SceneFragment> _subtreeCache;
 
         // animation
         bool _isPlayingAnimation;
@@ -0,0 +1,93 @@
+#ifndef __CCIMEDITOR_NODEPROXIES_H__
+#define __CCIMEDITOR_NODEPROXIES_H__
+
+#include "cocos2d.h"
+
+namespace CCImEditor
+{
+    // Constructors of the registered node types which have no create() without arguments.
+    // Only depends on cocos2d, so that code built without the editor creates the same nodes.
+    class DirectionLightProxy
+    {
+    public:
+        static cocos2d::DirectionLight* create()
+        {
+            return cocos2d::DirectionLight::create(cocos2d::Vec3::UNIT_Z, cocos2d::Color3B::WHITE);
+        }
+    };
+
+    class PointLightProxy
+    {
+    public:
+        static cocos2d::PointLight* create()
+        {
+            return cocos2d::PointLight::create(cocos2d::Vec3::ZERO, cocos2d::Color3B::WHITE, 1.0f);
+        }
+    };
+
+    class AmbientLightProxy
+    {
+    public:
+        static cocos2d::AmbientLight* create()
+        {
+            return cocos2d::AmbientLight::create(cocos2d::Color3B::WHITE);
+        }
+    };
+
+    class SpotLightProxy
+    {
+    public:
+        static cocos2d::SpotLight* create()
+        {
+            return cocos2d::SpotLight::create(cocos2d::Vec3::UNIT_Z, cocos2d::Vec3::ZERO, cocos2d::Color3B::WHITE, 0.0f, CC_DEGREES_TO_RADIANS(30), 5000.0f);
+        }
+    };
+
+    class QuadProxy
+    {
+    public:
+        static cocos2d::Sprite3D* create()
+        {
+            cocos2d::Sprite3D* sprite3D = cocos2d::Sprite3D::create();
+            if (!sprite3D)
+                return nullptr;
+
+            std::vector<float> vertices = {-0.5f, 0.5f, 0.0f, 0.5f, 0.5f, 0.0f, -0.5f, -0.5f, 0.0f, 0.5f, -0.5f, 0.0f};
+            std::vector<float> normals = {0.0, 0.0, 1.0, 0.0, 0.0, 1.0, 0.0, 0.0, 1.0, 0.0, 0.0, 1.0};
+            std::vector<float> uvs = {0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f};
+            std::vector<unsigned short> indices = {0, 2, 1, 2, 3, 1};
+            cocos2d::Mesh* mesh = cocos2d::Mesh::create(vertices, normals, uvs, indices);
+            if (!mesh)
+                return nullptr;
+
+            sprite3D->addMesh(mesh);
+            sprite3D->genMaterial();
+            return sprite3D;
+        }
+    };
+
+    class CubeProxy
+    {
+    public:
+        static cocos2d::Sprite3D* create()
+        {
+            cocos2d::Sprite3D* sprite3D = cocos2d::Sprite3D::create();
+            if (!sprite3D)
+                return nullptr;
+
+            std::vector<float> vertices = {0.5f, 0.5f, 0.5f, 0.5f, 0.5f, -0.5f, 0.5f, -0.5f, 0.5f, 0.5f, -0.5f, -0.5f, -0.5f, 0.5f, -0.5f, -0.5f, 0.5f, 0.5f, -0.5f, -0.5f, -0.5f, -0.5f, -0.5f, 0.5f, -0.5f, 0.5f, -0.5f, 0.5f, 0.5f, -0.5f, -0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, -0.5f, -0.5f, 0.5f, 0.5f, -0.5f, 0.5f, -0.5f, -0.5f, -0.5f, 0.5f, -0.5f, -0.5f, -0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, -0.5f, -0.5f, 0.5f, 0.5f, -0.5f, 0.5f, 0.5f, 0.5f, -0.5f, -0.5f, 0.5f, -0.5f, 0.5f, -0.5f, -0.5f, -0.5f, -0.5f, -0.5f};
+            std::vector<float> normals = {1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, -1.0f};
+            std::vector<float> uvs = {0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f};
+            std::vector<unsigned short> indices = {0, 2, 1, 2, 3, 1, 4, 6, 5, 6, 7, 5, 8, 10, 9, 10, 11, 9, 12, 14, 13, 14, 15, 13, 16, 18, 17, 18, 19, 17, 20, 22, 21, 22, 23, 21};
+            cocos2d::Mesh* mesh = cocos2d::Mesh::create(vertices, normals, uvs, indices);
+            if (!mesh)
+                return nullptr;
+
+            sprite3D->addMesh(mesh);
+            sprite3D->genMaterial();
+            return sprite3D;
+        }
+    };
+}
+
+#endif
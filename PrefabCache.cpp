@@ -0,0 +1,333 @@
+#include "PrefabCache.h"
+#include "BinaryScene.h"
+#include "MappedFile.h"
+#include "JsonReader.h"
+#include "ThreadPool.h"
+#include "DerivedDataCache.h"
+
+#include <sys/stat.h>
+#include <algorithm>
+
+namespace CCImEditor
+{
+    namespace
+    {
+        size_t estimateValueSize(const cocos2d::Value& value)
+        {
+            size_t size = sizeof(cocos2d::Value);
+            switch (value.getType())
+            {
+            case cocos2d::Value::Type::STRING:
+                size += value.asString().capacity();
+                break;
+            case cocos2d::Value::Type::VECTOR:
+                for (const cocos2d::Value& element : value.asValueVector())
+                {
+                    size += estimateValueSize(element);
+                }
+                break;
+            case cocos2d::Value::Type::MAP:
+                size += PrefabCache::estimateSize(value.asValueMap());
+                break;
+            default:
+                break;
+            }
+
+            return size;
+        }
+    }
+
+    PrefabCache* PrefabCache::getInstance()
+    {
+        static PrefabCache instance;
+        return &instance;
+    }
+
+    std::shared_ptr<const cocos2d::ValueMap> PrefabCache::getDescription(const std::string& file)
+    {
+        const std::string fullPath = cocos2d::FileUtils::getInstance()->fullPathForFilename(file);
+        if (fullPath.empty())
+            return nullptr;
+
+        int64_t modificationTime, size;
+        getFileStatus(fullPath, modificationTime, size);
+
+        if (isValid(fullPath, modificationTime, size))
+        {
+            _hits++;
+            return use(fullPath);
+        }
+
+        _misses++;
+        std::shared_ptr<cocos2d::ValueMap> description = std::make_shared<cocos2d::ValueMap>();
+        if (!decodeFile(fullPath, *description))
+        {
+            remove(fullPath);
+            return nullptr;
+        }
+
+        add(fullPath, modificationTime, size, description);
+        return description;
+    }
+
+    PrefabCache::Preload::Preload(const std::vector<std::string>& files)
+    {
+        start(files);
+    }
+
+    bool PrefabCache::Preload::update(bool wait)
+    {
+        PrefabCache* cache = PrefabCache::getInstance();
+        std::vector<std::string> next;
+        do
+        {
+            for (auto it = _jobs.begin(); it != _jobs.end();)
+            {
+                Job& job = *it;
+                if (!wait && job._result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                {
+                    ++it;
+                    continue;
+                }
+
+                cache->_misses++;
+                if (job._result.get())
+                {
+                    // Nested prefabs are only known once their parent is decoded
+                    collectFiles(*job._description, next);
+
+                    cache->add(job._fullPath, job._modificationTime, job._size, std::move(job._description));
+                }
+                else
+                {
+                    CCLOGWARN("Failed to load file %s", job._fullPath.c_str());
+                    cache->remove(job._fullPath);
+                }
+
+                it = _jobs.erase(it);
+            }
+
+            start(next);
+            next.clear();
+        } while (wait && !_jobs.empty());
+
+        return _jobs.empty();
+    }
+
+    void PrefabCache::Preload::start(const std::vector<std::string>& files)
+    {
+        PrefabCache* cache = PrefabCache::getInstance();
+        cocos2d::FileUtils* fileUtils = cocos2d::FileUtils::getInstance();
+        std::vector<std::string> cachedFiles;
+        for (const std::string& file : files)
+        {
+            // Paths are resolved here, FileUtils caches lookups and is not thread-safe
+            std::string fullPath = fileUtils->fullPathForFilename(file);
+            if (fullPath.empty() || !_visited.insert(fullPath).second)
+                continue;
+
+            Job job;
+            getFileStatus(fullPath, job._modificationTime, job._size);
+            if (cache->isValid(fullPath, job._modificationTime, job._size))
+            {
+                collectFiles(*cache->use(fullPath), cachedFiles);
+                continue;
+            }
+
+            job._fullPath = std::move(fullPath);
+            job._description = std::make_shared<cocos2d::ValueMap>();
+            job._result = Internal::ThreadPool::getInstance()->enqueue([path = job._fullPath, description = job._description]()
+            {
+                return decodeFile(path, *description);
+            });
+            _jobs.push_back(std::move(job));
+        }
+
+        if (!cachedFiles.empty())
+            start(cachedFiles);
+    }
+
+    void PrefabCache::preload(const std::vector<std::string>& files)
+    {
+        Preload preload(files);
+        preload.update(true);
+    }
+
+    void PrefabCache::invalidate(const std::string& file)
+    {
+        remove(cocos2d::FileUtils::getInstance()->fullPathForFilename(file));
+    }
+
+    void PrefabCache::invalidateAll()
+    {
+        _entries.clear();
+        _size = 0;
+    }
+
+    void PrefabCache::setSizeLimit(size_t bytes)
+    {
+        _sizeLimit = bytes;
+        evict();
+    }
+
+    const std::shared_ptr<const cocos2d::ValueMap>& PrefabCache::use(const std::string& fullPath)
+    {
+        Entry& entry = _entries.at(fullPath);
+        entry._lastUse = ++_useCount;
+        return entry._description;
+    }
+
+    void PrefabCache::add(const std::string& fullPath, int64_t modificationTime, int64_t size, std::shared_ptr<const cocos2d::ValueMap> description)
+    {
+        remove(fullPath);
+
+        Entry& entry = _entries[fullPath];
+        entry._modificationTime = modificationTime;
+        entry._size = size;
+        entry._memory = fullPath.capacity() + sizeof(Entry) + estimateSize(*description);
+        entry._description = std::move(description);
+        entry._lastUse = ++_useCount;
+        _size += entry._memory;
+        evict();
+    }
+
+    void PrefabCache::remove(const std::string& fullPath)
+    {
+        auto it = _entries.find(fullPath);
+        if (it == _entries.end())
+            return;
+
+        _size -= it->second._memory;
+        _entries.erase(it);
+    }
+
+    // The entry added last is kept even over the limit, its caller is about to use it
+    void PrefabCache::evict()
+    {
+        if (_size <= _sizeLimit)
+            return;
+
+        std::vector<std::pair<uint64_t, std::string>> entries;
+        entries.reserve(_entries.size());
+        for (const auto& [fullPath, entry] : _entries)
+        {
+            if (entry._lastUse != _useCount)
+                entries.emplace_back(entry._lastUse, fullPath);
+        }
+
+        std::sort(entries.begin(), entries.end());
+        for (size_t i = 0; i < entries.size() && _size > _sizeLimit; i++)
+        {
+            remove(entries[i].second);
+        }
+    }
+
+    // Files which are not on the local file system (e.g. android assets) can not
+    // change at runtime, they get -1 and stay cached until invalidated.
+    void PrefabCache::getFileStatus(const std::string& fullPath, int64_t& modificationTime, int64_t& size)
+    {
+        const std::string path = cocos2d::FileUtils::getInstance()->getSuitableFOpen(fullPath);
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+        struct _stat64 st;
+        if (_stat64(path.c_str(), &st) == 0)
+#else
+        struct stat st;
+        if (stat(path.c_str(), &st) == 0)
+#endif
+        {
+            modificationTime = static_cast<int64_t>(st.st_mtime);
+            size = static_cast<int64_t>(st.st_size);
+        }
+        else
+        {
+            modificationTime = -1;
+            size = -1;
+        }
+    }
+
+    bool PrefabCache::isValid(const std::string& fullPath, int64_t modificationTime, int64_t size) const
+    {
+        auto it = _entries.find(fullPath);
+        return it != _entries.end() && it->second._modificationTime == modificationTime && it->second._size == size;
+    }
+
+    void PrefabCache::collectFiles(const cocos2d::ValueMap& source, std::vector<std::string>& files)
+    {
+        cocos2d::ValueMap::const_iterator fileIt = source.find("file");
+        if (fileIt != source.end() && fileIt->second.getType() == cocos2d::Value::Type::STRING)
+            files.push_back(fileIt->second.asString());
+
+        cocos2d::ValueMap::const_iterator childrenIt = source.find("children");
+        if (childrenIt != source.end() && childrenIt->second.getType() == cocos2d::Value::Type::VECTOR)
+        {
+            for (const cocos2d::Value& childVal : childrenIt->second.asValueVector())
+            {
+                if (childVal.getType() == cocos2d::Value::Type::MAP)
+                    collectFiles(childVal.asValueMap(), files);
+            }
+        }
+    }
+
+    bool PrefabCache::decodeFile(const std::string& file, cocos2d::ValueMap& out)
+    {
+        std::string extension = cocos2d::FileUtils::getInstance()->getFileExtension(file);
+        if (extension == BinaryScene::getFileExtension())
+        {
+            Internal::MappedFile mappedFile;
+            BinaryScene::Reader reader;
+            if (!mappedFile.open(file) || !reader.init(mappedFile.getData(), mappedFile.getSize()))
+                return false;
+
+            out = reader.getRoot().toValueMap();
+            return true;
+        }
+
+        Internal::MappedFile mappedFile;
+        if (!mappedFile.open(file))
+            return false;
+
+        // Text formats are decoded once, later decodes read the binary scene stored for their content
+        DerivedDataCache* derivedDataCache = DerivedDataCache::getInstance();
+        std::string key;
+        if (derivedDataCache->isEnabled())
+        {
+            key = DerivedDataCache::getKey(mappedFile.getData(), mappedFile.getSize());
+            if (derivedDataCache->load(key, out))
+                return true;
+        }
+
+        const char* data = reinterpret_cast<const char*>(mappedFile.getData());
+        if (extension == ".json")
+        {
+            Internal::JsonReader reader(data, mappedFile.getSize());
+            cocos2d::Value value;
+            if (!reader.readValue(value) || !reader.isFinished() || value.getType() != cocos2d::Value::Type::MAP)
+                return false;
+
+            out = std::move(value.asValueMap());
+        }
+        else
+        {
+            out = cocos2d::FileUtils::getInstance()->getValueMapFromData(data, static_cast<int>(mappedFile.getSize()));
+            if (out.empty())
+                return false;
+        }
+
+        if (!key.empty())
+            derivedDataCache->store(key, out);
+
+        return true;
+    }
+
+    size_t PrefabCache::estimateSize(const cocos2d::ValueMap& description)
+    {
+        size_t size = 0;
+        for (const auto& [key, value] : description)
+        {
+            // Hash node with the key and its next pointer, and the bucket
+            size += key.capacity() + estimateValueSize(value) + 2 * sizeof(void*);
+        }
+
+        return size;
+    }
+}
@@ -0,0 +1,109 @@
+#ifndef __CCIMEDITOR_PREFABCACHE_H__
+#define __CCIMEDITOR_PREFABCACHE_H__
+
+#include "cocos2d.h"
+
+#include <string>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <future>
+#include <unordered_set>
+
+namespace CCImEditor
+{
+    // Decoded descriptions of the files referenced by nodes ("file" entry), so a prefab
+    // used many times is read and decoded once. Entries are keyed by full path and are
+    // reloaded when the modification time or size of the file changes. Once the entries
+    // grow over the size limit, the least recently used ones are dropped; descriptions
+    // still held by their users stay alive until released.
+    class PrefabCache
+    {
+    public:
+        static PrefabCache* getInstance();
+
+        // Returns nullptr if the file can not be read or decoded
+        std::shared_ptr<const cocos2d::ValueMap> getDescription(const std::string& file);
+
+        // Decodes files and the files they reference on the worker threads, so that the
+        // following getDescription calls are hits. Finished files are added to the cache
+        // by update, which returns true once there is nothing left.
+        class Preload
+        {
+        public:
+            explicit Preload(const std::vector<std::string>& files);
+
+            bool update(bool wait = false);
+
+        private:
+            void start(const std::vector<std::string>& files);
+
+            struct Job
+            {
+                std::string _fullPath;
+                int64_t _modificationTime;
+                int64_t _size;
+                std::shared_ptr<cocos2d::ValueMap> _description;
+                std::future<bool> _result;
+            };
+
+            std::vector<Job> _jobs;
+            std::unordered_set<std::string> _visited;
+        };
+
+        // Blocks until the files and the files they reference are decoded
+        void preload(const std::vector<std::string>& files);
+
+        void invalidate(const std::string& file);
+        void invalidateAll();
+
+        // Estimated memory of the descriptions, see estimateSize
+        void setSizeLimit(size_t bytes);
+        size_t getSizeLimit() const { return _sizeLimit; };
+        size_t getSize() const { return _size; };
+
+        uint32_t getHits() const { return _hits; };
+        uint32_t getMisses() const { return _misses; };
+        void resetStatistics() { _hits = 0; _misses = 0; };
+
+        // Decodes a scene file of any supported format into its description.
+        // Safe to call from worker threads as long as file is a full path.
+        static bool decodeFile(const std::string& file, cocos2d::ValueMap& out);
+
+        // Modification time and size of a file, used to find out whether it changed since it was read
+        static void getFileStatus(const std::string& fullPath, int64_t& modificationTime, int64_t& size);
+
+        // Appends the files referenced by the node described by source and its children
+        static void collectFiles(const cocos2d::ValueMap& source, std::vector<std::string>& files);
+
+        // Rough heap usage of a decoded description. Safe to call from worker threads.
+        static size_t estimateSize(const cocos2d::ValueMap& description);
+
+    private:
+        bool isValid(const std::string& fullPath, int64_t modificationTime, int64_t size) const;
+
+        // Marks the entry as the most recently used
+        const std::shared_ptr<const cocos2d::ValueMap>& use(const std::string& fullPath);
+        void add(const std::string& fullPath, int64_t modificationTime, int64_t size, std::shared_ptr<const cocos2d::ValueMap> description);
+        void remove(const std::string& fullPath);
+        void evict();
+
+        struct Entry
+        {
+            int64_t _modificationTime;
+            int64_t _size;
+            std::shared_ptr<const cocos2d::ValueMap> _description;
+            size_t _memory = 0;
+            uint64_t _lastUse = 0;
+        };
+
+        std::unordered_map<std::string, Entry> _entries;
+        uint64_t _useCount = 0;
+        size_t _size = 0;
+        size_t _sizeLimit = 128 * 1024 * 1024;
+        uint32_t _hits = 0;
+        uint32_t _misses = 0;
+    };
+}
+
+#endif
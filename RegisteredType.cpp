@@ -0,0 +1,20 @@
+#include "RegisteredType.h"
+
+namespace CCImEditor
+{
+    namespace
+    {
+        // Types are registered on the main thread
+        uint32_t s_nextId = 1;
+    }
+
+    RegisteredType::RegisteredType(const std::string& name, const std::string& displayName, uint32_t mask)
+    : _id(s_nextId++)
+    , _name(name)
+    , _displayName(displayName)
+    , _mask(mask)
+    {
+        const size_t lastSlash = _displayName.find_last_of('/');
+        _shortName = lastSlash != std::string::npos ? _displayName.substr(lastSlash + 1) : _displayName;
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef __CCIMEDITOR_REGISTEREDTYPE_H__
+#define __CCIMEDITOR_REGISTEREDTYPE_H__
+
+#include <string>
+#include <cstdint>
+
+namespace CCImEditor
+{
+    // A type registered with NodeFactory, ComponentFactory or WidgetFactory. The factories
+    // keep one per name for the lifetime of the program, and what they create points to it,
+    // so names are stored once and type checks compare pointers or ids instead of strings.
+    class RegisteredType
+    {
+    public:
+        RegisteredType(const std::string& name, const std::string& displayName, uint32_t mask);
+
+        // Unique across the factories, in the order types are registered
+        uint32_t getId() const { return _id; };
+        const std::string& getName() const { return _name; };
+        const std::string& getDisplayName() const { return _displayName; };
+
+        // Last part of the display name, e.g. "Point Light" for "3D/Light/Point Light"
+        const std::string& getShortName() const { return _shortName; };
+        uint32_t getMask() const { return _mask; };
+
+    private:
+        uint32_t _id;
+        std::string _name;
+        std::string _displayName;
+        std::string _shortName;
+        uint32_t _mask;
+    };
+}
+
+#endif
@@ -0,0 +1,446 @@
+#include "SceneCompiler.h"
+#include "AtomicFile.h"
+#include "PrefabCache.h"
+#include "runtime/SceneLoader.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <unordered_set>
+
+namespace CCImEditor
+{
+    namespace
+    {
+        const cocos2d::ValueMap& getMap(const cocos2d::ValueMap& valueMap, const char* key)
+        {
+            static const cocos2d::ValueMap empty;
+            cocos2d::ValueMap::const_iterator it = valueMap.find(key);
+            return it != valueMap.end() && it->second.getType() == cocos2d::Value::Type::MAP ? it->second.asValueMap() : empty;
+        }
+
+        std::string getString(const cocos2d::ValueMap& valueMap, const char* key)
+        {
+            cocos2d::ValueMap::const_iterator it = valueMap.find(key);
+            return it != valueMap.end() && it->second.getType() == cocos2d::Value::Type::STRING ? it->second.asString() : std::string();
+        }
+
+        // Statements setting the properties of one node, in the order of the SceneLoader
+        // table of its type, which is the order the editor and the loader set them
+        class PropertyWriter
+        {
+        public:
+            PropertyWriter(const cocos2d::ValueMap& properties, const std::string& variable, std::string& code)
+            : _properties(properties)
+            , _variable(variable)
+            , _code(code)
+            {
+            }
+
+            const cocos2d::Value* find(const std::string& key) const
+            {
+                cocos2d::ValueMap::const_iterator it = _properties.find(key);
+                return it != _properties.end() ? &it->second : nullptr;
+            }
+
+            void consume(const std::string& key) { _compiled.insert(key); };
+
+            void statement(const std::string& statement)
+            {
+                _code += statement.empty() ? "\n" : "        " + statement + "\n";
+            }
+
+            // Values the property can not write as C++ are left for the report
+            void set(const RuntimeProperty& property)
+            {
+                const cocos2d::Value* value = find(property._key);
+                std::string code;
+                if (!value || _compiled.count(property._key) > 0 || !property.compile(_variable, *value, code))
+                    return;
+
+                consume(property._key);
+                if (!code.empty())
+                    statement(code);
+            }
+
+            void set(const std::vector<RuntimeProperty>& properties)
+            {
+                for (const RuntimeProperty& property : properties)
+                {
+                    set(property);
+                }
+            }
+
+            const std::string& getVariable() const { return _variable; };
+
+            void report(const std::string& path, std::vector<std::string>& report) const
+            {
+                std::vector<std::string> keys;
+                for (const auto& [key, value] : _properties)
+                {
+                    if (_compiled.count(key) == 0)
+                        keys.push_back(key);
+                }
+
+                std::sort(keys.begin(), keys.end());
+                for (const std::string& key : keys)
+                {
+                    report.push_back(cocos2d::StringUtils::format("%s: property %s is not compiled", path.c_str(), key.c_str()));
+                }
+            }
+
+        private:
+            const cocos2d::ValueMap& _properties;
+            std::string _variable;
+            std::string& _code;
+            std::unordered_set<std::string> _compiled;
+        };
+
+        // The meshes of nodes/Sprite3D.cpp, which SceneLoader applies out of its table
+        void writeSprite3DMeshes(PropertyWriter& writer, const cocos2d::ValueMap& properties)
+        {
+            std::vector<int> meshes;
+            for (const auto& [key, value] : properties)
+            {
+                const size_t dot = key.find('.');
+                if (dot != std::string::npos && (key.compare(0, dot, "Material") == 0 || key.compare(0, dot, "Texture") == 0 || key.compare(0, dot, "Transparent") == 0))
+                    meshes.push_back(atoi(key.c_str() + dot + 1));
+            }
+
+            std::sort(meshes.begin(), meshes.end());
+            meshes.erase(std::unique(meshes.begin(), meshes.end()), meshes.end());
+
+            const std::string& variable = writer.getVariable();
+            for (int i : meshes)
+            {
+                const std::string material = cocos2d::StringUtils::format("Material.%d", i);
+                const cocos2d::Value* value = writer.find(material);
+                if (value && value->getType() == cocos2d::Value::Type::STRING)
+                {
+                    writer.consume(material);
+                    if (!value->asString().empty())
+                    {
+                        writer.statement("if (cocos2d::Material* material = cocos2d::Material::createWithFilename(" + Internal::stringLiteral(value->asString()) + "))");
+                        writer.statement(cocos2d::StringUtils::format("    %s->setMaterial(material, %d);", variable.c_str(), i));
+                    }
+                }
+
+                const std::string texture = cocos2d::StringUtils::format("Texture.%d", i);
+                value = writer.find(texture);
+                if (value && value->getType() == cocos2d::Value::Type::STRING)
+                {
+                    writer.consume(texture);
+                    if (!value->asString().empty())
+                    {
+                        writer.statement(cocos2d::StringUtils::format("if (cocos2d::Mesh* mesh = %s->getMeshByIndex(%d))", variable.c_str(), i));
+                        writer.statement("    mesh->setTexture(" + Internal::stringLiteral(value->asString()) + ");");
+                    }
+                }
+
+                const std::string transparent = cocos2d::StringUtils::format("Transparent.%d", i);
+                value = writer.find(transparent);
+                if (value && Internal::isNumber(*value))
+                {
+                    writer.consume(transparent);
+                    writer.statement(cocos2d::StringUtils::format("if (cocos2d::Mesh* mesh = %s->getMeshByIndex(%d))", variable.c_str(), i));
+                    writer.statement("    mesh->setTransparent(" + RuntimeValue<bool>::literal(*value) + ");");
+                }
+            }
+        }
+
+        // The faces of nodes/Skybox.cpp, which SceneLoader applies out of its table
+        void writeSkybox(PropertyWriter& writer)
+        {
+            const char* faces[] = {"Left", "Right", "Up", "Down", "Front", "Back"};
+            std::string arguments;
+            bool modified = false;
+            for (const char* face : faces)
+            {
+                const cocos2d::Value* value = writer.find(face);
+                const bool isPath = value && value->getType() == cocos2d::Value::Type::STRING;
+                if (isPath)
+                {
+                    writer.consume(face);
+                    modified = modified || !value->asString().empty();
+                }
+
+                arguments += (arguments.empty() ? "" : ", ") + Internal::stringLiteral(isPath ? value->asString() : std::string());
+            }
+
+            if (modified)
+            {
+                writer.statement("if (cocos2d::TextureCube* texture = cocos2d::TextureCube::create(" + arguments + "))");
+                writer.statement("    " + writer.getVariable() + "->setTexture(texture);");
+            }
+        }
+
+        class Compiler
+        {
+        public:
+            explicit Compiler(std::vector<std::string>& report)
+            : _report(report)
+            {
+            }
+
+            bool compile(const cocos2d::ValueMap& description, std::string& root)
+            {
+                root = compileNode(description, getName(description));
+                return !root.empty();
+            }
+
+            const std::string& getCode() const { return _code; };
+            bool usesProxies() const { return _usesProxies; };
+
+        private:
+            static std::string getName(const cocos2d::ValueMap& description)
+            {
+                const std::string name = getString(getMap(description, "properties"), "Name");
+                return !name.empty() ? name : getString(description, "type");
+            }
+
+            // Returns the variable holding the node, or an empty string on errors
+            std::string compileNode(const cocos2d::ValueMap& description, const std::string& path)
+            {
+                const std::string type = getString(description, "type");
+                if (type.empty())
+                {
+                    CCLOGWARN("%s has no type", path.c_str());
+                    return std::string();
+                }
+
+                // Prefab instances are the prefab, with the values of the instance
+                // over those of its root
+                const std::string file = getString(description, "file");
+                cocos2d::ValueMap prefab;
+                cocos2d::ValueMap properties = getMap(description, "properties");
+                if (!file.empty())
+                {
+                    const std::string fullPath = cocos2d::FileUtils::getInstance()->fullPathForFilename(file);
+                    if (_prefabs.count(fullPath) > 0)
+                    {
+                        CCLOGWARN("%s instantiates %s recursively", path.c_str(), file.c_str());
+                        return std::string();
+                    }
+
+                    if (fullPath.empty() || !PrefabCache::decodeFile(fullPath, prefab))
+                    {
+                        CCLOGWARN("Failed to load prefab %s", file.c_str());
+                        return std::string();
+                    }
+
+                    for (const auto& [key, value] : getMap(prefab, "properties"))
+                    {
+                        properties.emplace(key, value);
+                    }
+
+                    _prefabs.insert(fullPath);
+                }
+
+                const std::string variable = cocos2d::StringUtils::format("n%d", _nextVariable++);
+                PropertyWriter writer(properties, variable, _code);
+
+                // Registered types are written from the table SceneLoader sets them with
+                const SceneLoader::NodeType* nodeType = SceneLoader::getInstance()->getNodeType(type);
+                const char* className = "cocos2d::Node";
+                std::string constructor = "cocos2d::Node::create()";
+                std::function<void()> write;
+                if (type == "CCImEditor.Sprite")
+                {
+                    className = "cocos2d::Sprite";
+                    constructor = "cocos2d::Sprite::create()";
+                }
+                else if (type == "CCImEditor.Label")
+                {
+                    className = "cocos2d::Label";
+                    constructor = "cocos2d::Label::create()";
+                }
+                else if (type == "CCImEditor.Sprite3D")
+                {
+                    const std::string model = getString(properties, "Model");
+                    className = "cocos2d::Sprite3D";
+                    constructor = model.empty() ? "cocos2d::Sprite3D::create()" : "cocos2d::Sprite3D::create(" + Internal::stringLiteral(model) + ")";
+                    writer.consume("Model");
+                    write = [&writer, &properties]() { writeSprite3DMeshes(writer, properties); };
+                }
+                else if (type == "CCImEditor.Quad" || type == "CCImEditor.Cube")
+                {
+                    className = "cocos2d::Sprite3D";
+                    constructor = type == "CCImEditor.Quad" ? "CCImEditor::QuadProxy::create()" : "CCImEditor::CubeProxy::create()";
+                }
+                else if (type == "CCImEditor.Skybox")
+                {
+                    className = "cocos2d::Skybox";
+                    constructor = "cocos2d::Skybox::create()";
+                    write = [&writer]() { writeSkybox(writer); };
+                }
+                else if (type == "CCImEditor.DirectionLight")
+                {
+                    className = "cocos2d::DirectionLight";
+                    constructor = "CCImEditor::DirectionLightProxy::create()";
+                }
+                else if (type == "CCImEditor.PointLight" || type == "CCImEditor.SpotLight")
+                {
+                    const bool isSpot = type == "CCImEditor.SpotLight";
+                    className = isSpot ? "cocos2d::SpotLight" : "cocos2d::PointLight";
+                    constructor = isSpot ? "CCImEditor::SpotLightProxy::create()" : "CCImEditor::PointLightProxy::create()";
+                }
+                else if (type == "CCImEditor.AmbientLight")
+                {
+                    className = "cocos2d::AmbientLight";
+                    constructor = "CCImEditor::AmbientLightProxy::create()";
+                }
+                else if (type != "CCImEditor.Node2D" && type != "CCImEditor.Node3D")
+                {
+                    // Custom types become plain nodes with their transform
+                    const cocos2d::Value* position = writer.find("Position");
+                    const bool is3D = position && Internal::getNumbers(*position, 3);
+                    nodeType = SceneLoader::getInstance()->getNodeType(is3D ? "CCImEditor.Node3D" : "CCImEditor.Node2D");
+                    _report.push_back(cocos2d::StringUtils::format("%s: %s is compiled as a cocos2d::Node", path.c_str(), type.c_str()));
+                }
+
+                _usesProxies = _usesProxies || constructor.compare(0, 12, "CCImEditor::") == 0;
+
+                writer.statement(cocos2d::StringUtils::format("%s* %s = %s;", className, variable.c_str(), constructor.c_str()));
+                writer.statement("if (!" + variable + ")");
+                writer.statement("    return nullptr;");
+                if (nodeType)
+                    writer.set(nodeType->_properties);
+                if (write)
+                    write();
+                writer.report(path, _report);
+
+                reportUncompiled(description, path);
+                if (!prefab.empty())
+                    reportUncompiled(prefab, path);
+
+                const cocos2d::ValueMap& children = !prefab.empty() ? prefab : description;
+                cocos2d::ValueMap::const_iterator childrenIt = children.find("children");
+                if (childrenIt != children.end() && childrenIt->second.getType() == cocos2d::Value::Type::VECTOR)
+                {
+                    for (const cocos2d::Value& child : childrenIt->second.asValueVector())
+                    {
+                        if (child.getType() != cocos2d::Value::Type::MAP)
+                            continue;
+
+                        writer.statement("");
+                        const std::string childVariable = compileNode(child.asValueMap(), path + "/" + getName(child.asValueMap()));
+                        if (childVariable.empty())
+                            return std::string();
+
+                        writer.statement(variable + "->addChild(" + childVariable + ");");
+                    }
+                }
+
+                if (!file.empty())
+                    _prefabs.erase(cocos2d::FileUtils::getInstance()->fullPathForFilename(file));
+
+                return variable;
+            }
+
+            void reportUncompiled(const cocos2d::ValueMap& description, const std::string& path)
+            {
+                for (const auto& [name, animation] : getMap(description, "animations"))
+                {
+                    _report.push_back(cocos2d::StringUtils::format("%s: animation %s is not compiled", path.c_str(), name.c_str()));
+                }
+
+                for (const auto& [name, component] : getMap(description, "components"))
+                {
+                    if (component.getType() == cocos2d::Value::Type::MAP)
+                        _report.push_back(cocos2d::StringUtils::format("%s: component %s (%s) is not compiled", path.c_str(), name.c_str(), getString(component.asValueMap(), "type").c_str()));
+                }
+            }
+
+            std::vector<std::string>& _report;
+            std::string _code;
+            int _nextVariable = 0;
+            bool _usesProxies = false;
+            std::unordered_set<std::string> _prefabs;
+        };
+
+        bool writeFile(const std::string& fullPath, const std::string& content)
+        {
+            Internal::AtomicFile atomicFile;
+            return atomicFile.open(fullPath) && atomicFile.write(content.data(), content.size()) && atomicFile.commit();
+        }
+    }
+
+    bool SceneCompiler::compile(const cocos2d::ValueMap& description, const std::string& sceneFile, const std::string& name, Output& output, std::vector<std::string>& report)
+    {
+        Compiler compiler(report);
+        std::string root;
+        if (!compiler.compile(description, root))
+            return false;
+
+        const std::string generated = "// Generated by cc_imgui_editor from " + sceneFile + ", do not edit.\n";
+
+        std::string guard = "__COMPILEDSCENES_" + name + "_H__";
+        std::transform(guard.begin(), guard.end(), guard.begin(), ::toupper);
+
+        output._header = generated;
+        output._header += "#ifndef " + guard + "\n";
+        output._header += "#define " + guard + "\n\n";
+        output._header += "#include \"cocos2d.h\"\n\n";
+        output._header += "namespace CompiledScenes\n{\n";
+        output._header += "    // Returns an autoreleased node, or nullptr if a node could not be created\n";
+        output._header += "    cocos2d::Node* " + name + "();\n";
+        output._header += "}\n\n#endif\n";
+
+        output._source = generated;
+        output._source += "#include \"" + name + ".h\"\n";
+        if (compiler.usesProxies())
+            output._source += "#include \"NodeProxies.h\"\n";
+        output._source += "\nnamespace CompiledScenes\n{\n";
+        output._source += "    cocos2d::Node* " + name + "()\n    {\n";
+        output._source += compiler.getCode();
+        output._source += "\n        return " + root + ";\n    }\n}\n";
+
+        // CC_IMGUI_EDITOR_ROOT_PATH is set by the CMakeLists.txt of the editor
+        output._cmake = "# Generated by cc_imgui_editor from " + sceneFile + ", do not edit.\n";
+        output._cmake += "# include() it and link " + name + " into the game.\n";
+        output._cmake += "add_library(" + name + " STATIC\n";
+        output._cmake += "    ${CMAKE_CURRENT_LIST_DIR}/" + name + ".cpp\n";
+        output._cmake += "    ${CMAKE_CURRENT_LIST_DIR}/" + name + ".h\n";
+        output._cmake += ")\n";
+        output._cmake += "target_include_directories(" + name + " PUBLIC ${CMAKE_CURRENT_LIST_DIR} PRIVATE ${CC_IMGUI_EDITOR_ROOT_PATH})\n";
+        output._cmake += "target_link_libraries(" + name + " cocos2d)\n";
+        output._cmake += "use_cocos2dx_compile_define(" + name + ")\n";
+        return true;
+    }
+
+    bool SceneCompiler::compileToDirectory(const cocos2d::ValueMap& description, const std::string& sceneFile, const std::string& directory, const std::string& name, std::vector<std::string>& report)
+    {
+        Output output;
+        if (!compile(description, sceneFile, name, output, report))
+            return false;
+
+        std::string prefix = directory;
+        if (!prefix.empty() && prefix.back() != '/' && prefix.back() != '\\')
+            prefix += '/';
+
+        cocos2d::FileUtils::getInstance()->createDirectory(directory);
+        return writeFile(prefix + name + ".h", output._header)
+            && writeFile(prefix + name + ".cpp", output._source)
+            && writeFile(prefix + name + ".cmake", output._cmake);
+    }
+
+    std::string SceneCompiler::getName(const std::string& file)
+    {
+        const size_t slash = file.find_last_of("/\\");
+        std::string name = file.substr(slash == std::string::npos ? 0 : slash + 1);
+        const size_t dot = name.find('.');
+        if (dot != std::string::npos)
+            name.erase(dot);
+
+        for (char& c : name)
+        {
+            if (!isalnum(static_cast<unsigned char>(c)))
+                c = '_';
+        }
+
+        if (name.empty() || isdigit(static_cast<unsigned char>(name[0])))
+            name.insert(0, "scene_");
+
+        return name;
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef __CCIMEDITOR_SCENECOMPILER_H__
+#define __CCIMEDITOR_SCENECOMPILER_H__
+
+#include <string>
+#include <vector>
+#include "cocos2d.h"
+
+namespace CCImEditor
+{
+    // Turns a scene description into C++ which builds the same node graph with the setters
+    // SceneLoader registers for the node types, and into a CMake file adding it as
+    // a library. Loading the scene then runs no parser and looks up no property by name:
+    //
+    //   include(${SCENES_DIR}/menu.cmake)
+    //   target_link_libraries(${APP_NAME} menu)
+    //
+    //   cocos2d::Node* node = CompiledScenes::menu();
+    //
+    // Prefab instances are compiled inline from their files. Components and animations are
+    // not compiled, each of them is described by a line of the report.
+    class SceneCompiler
+    {
+    public:
+        struct Output
+        {
+            std::string _header;
+            std::string _source;
+            std::string _cmake;
+        };
+
+        // name is the name of the function, the files and the target. sceneFile is only
+        // mentioned in the generated code. Prefabs are read on the calling thread.
+        static bool compile(const cocos2d::ValueMap& description, const std::string& sceneFile, const std::string& name, Output& output, std::vector<std::string>& report);
+
+        // Writes <name>.h, <name>.cpp and <name>.cmake to the directory
+        static bool compileToDirectory(const cocos2d::ValueMap& description, const std::string& sceneFile, const std::string& directory, const std::string& name, std::vector<std::string>& report);
+
+        // C++ identifier made of the file name without directory and extension
+        static std::string getName(const std::string& file);
+    };
+}
+
+#endif
@@ -0,0 +1,22 @@
+#include "SceneFragment.h"
+
+namespace CCImEditor
+{
+    void SceneFragment::toValueMap(cocos2d::ValueMap& target) const
+    {
+        target = _node ? *_node : cocos2d::ValueMap();
+        if (!_hasChildren)
+            return;
+
+        cocos2d::ValueVector childrenVal;
+        childrenVal.reserve(_children.size());
+        for (const std::shared_ptr<const SceneFragment>& child : _children)
+        {
+            cocos2d::ValueMap childVal;
+            child->toValueMap(childVal);
+            childrenVal.push_back(cocos2d::Value(std::move(childVal)));
+        }
+
+        target["children"] = cocos2d::Value(std::move(childrenVal));
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef __CCIMEDITOR_SCENEFRAGMENT_H__
+#define __CCIMEDITOR_SCENEFRAGMENT_H__
+
+#include <memory>
+#include <vector>
+#include "cocos2d.h"
+
+namespace CCImEditor
+{
+    // A node of a scene description split into immutable parts, the description of the node
+    // without its "children" and the fragments of its children. The editor keeps the last
+    // fragment of each subtree, a save builds new ones only along the paths to the modified
+    // nodes and shares the others with the previous save. SceneWriter and BinaryScene write
+    // it as the description it stands for.
+    struct SceneFragment
+    {
+        std::shared_ptr<const cocos2d::ValueMap> _node;
+        std::vector<std::shared_ptr<const SceneFragment>> _children;
+
+        // Prefab instances are saved without "children"
+        bool _hasChildren = false;
+
+        // Copies the whole subtree, for code which edits or walks descriptions
+        void toValueMap(cocos2d::ValueMap& target) const;
+    };
+}
+
+#endif
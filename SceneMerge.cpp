@@ -0,0 +1,463 @@
+#include "SceneMerge.h"
+
+#include <algorithm>
+#include <list>
+#include <unordered_map>
+
+namespace CCImEditor
+{
+    namespace
+    {
+        const cocos2d::Value* findValue(const cocos2d::ValueMap& valueMap, const std::string& key)
+        {
+            cocos2d::ValueMap::const_iterator it = valueMap.find(key);
+            return it != valueMap.end() ? &it->second : nullptr;
+        }
+
+        std::string getString(const cocos2d::ValueMap& valueMap, const std::string& key)
+        {
+            const cocos2d::Value* value = findValue(valueMap, key);
+            return value && value->getType() == cocos2d::Value::Type::STRING ? value->asString() : std::string();
+        }
+
+        std::string getName(const cocos2d::ValueMap& node)
+        {
+            const cocos2d::Value* properties = findValue(node, "properties");
+            if (properties && properties->getType() == cocos2d::Value::Type::MAP)
+            {
+                std::string name = getString(properties->asValueMap(), "Name");
+                if (!name.empty())
+                    return name;
+            }
+
+            return getString(node, "type");
+        }
+
+        std::vector<std::string> getSortedKeys(const cocos2d::ValueMap& valueMap)
+        {
+            std::vector<std::string> keys;
+            keys.reserve(valueMap.size());
+            for (const auto& [key, value] : valueMap)
+            {
+                keys.push_back(key);
+            }
+
+            std::sort(keys.begin(), keys.end());
+            return keys;
+        }
+
+        bool isMap(const cocos2d::Value* value)
+        {
+            return value && value->getType() == cocos2d::Value::Type::MAP;
+        }
+
+        bool equals(const cocos2d::Value* a, const cocos2d::Value* b)
+        {
+            if (!a || !b)
+                return a == b;
+
+            return *a == *b;
+        }
+
+        const cocos2d::ValueVector* getChildren(const cocos2d::ValueMap* node)
+        {
+            const cocos2d::Value* children = node ? findValue(*node, "children") : nullptr;
+            return children && children->getType() == cocos2d::Value::Type::VECTOR ? &children->asValueVector() : nullptr;
+        }
+
+        // Ids can only match children of the sides compared if all of them have one. A file
+        // saved before nodes had ids is loaded with new random ones, which match nothing in
+        // the file, so then they are all matched by type and name.
+        bool hasIds(const cocos2d::ValueMap* node)
+        {
+            if (const cocos2d::ValueVector* children = getChildren(node))
+            {
+                for (const cocos2d::Value& child : *children)
+                {
+                    if (child.getType() == cocos2d::Value::Type::MAP && getString(child.asValueMap(), "id").empty())
+                        return false;
+                }
+            }
+
+            return true;
+        }
+
+        // Children of a node in order, with their identity
+        struct ChildIndex
+        {
+            ChildIndex(const cocos2d::ValueMap* node, bool useIds)
+            {
+                const cocos2d::ValueVector* children = getChildren(node);
+                if (!children)
+                    return;
+
+                std::unordered_map<std::string, int> occurrences;
+                for (const cocos2d::Value& child : *children)
+                {
+                    if (child.getType() != cocos2d::Value::Type::MAP)
+                        continue;
+
+                    const cocos2d::ValueMap& childMap = child.asValueMap();
+                    std::string key = useIds ? getString(childMap, "id") : std::string();
+                    if (key.empty())
+                        key = "#" + getString(childMap, "type") + "/" + getName(childMap);
+
+                    // Nodes without id sharing type and name are told apart by their order
+                    int& occurrence = occurrences[key];
+                    if (occurrence++ > 0)
+                        key += "#" + std::to_string(occurrence - 1);
+
+                    _positions.emplace(key, _keys.size());
+                    _keys.push_back(std::move(key));
+                    _nodes.push_back(&childMap);
+                }
+            }
+
+            const cocos2d::ValueMap* find(const std::string& key) const
+            {
+                std::unordered_map<std::string, size_t>::const_iterator it = _positions.find(key);
+                return it != _positions.end() ? _nodes[it->second] : nullptr;
+            }
+
+            bool contains(const std::string& key) const
+            {
+                return _positions.count(key) > 0;
+            }
+
+            std::vector<std::string> _keys;
+            std::vector<const cocos2d::ValueMap*> _nodes;
+            std::unordered_map<std::string, size_t> _positions;
+        };
+
+        std::string getChildPath(const std::string& path, const cocos2d::ValueMap& child)
+        {
+            return path + "/" + getName(child);
+        }
+
+        // Keys of side also in other, in the order of side
+        std::vector<std::string> getCommonKeys(const ChildIndex& side, const ChildIndex& other)
+        {
+            std::vector<std::string> keys;
+            for (const std::string& key : side._keys)
+            {
+                if (other.contains(key))
+                    keys.push_back(key);
+            }
+
+            return keys;
+        }
+
+        bool isReordered(const ChildIndex& base, const ChildIndex& side)
+        {
+            return getCommonKeys(base, side) != getCommonKeys(side, base);
+        }
+
+        // Marks the elements of the longest increasing subsequence of values in O(n log n),
+        // the elements left out are the fewest which have to move to restore the order
+        std::vector<bool> markLongestIncreasing(const std::vector<size_t>& values)
+        {
+            const size_t none = static_cast<size_t>(-1);
+            std::vector<size_t> tails;
+            std::vector<size_t> previous(values.size(), none);
+            for (size_t i = 0; i < values.size(); i++)
+            {
+                std::vector<size_t>::iterator it = std::lower_bound(tails.begin(), tails.end(), values[i],
+                    [&values](size_t index, size_t value)
+                    {
+                        return values[index] < value;
+                    });
+
+                if (it != tails.begin())
+                    previous[i] = *(it - 1);
+
+                if (it == tails.end())
+                    tails.push_back(i);
+                else
+                    *it = i;
+            }
+
+            std::vector<bool> marked(values.size(), false);
+            for (size_t i = tails.empty() ? none : tails.back(); i != none; i = previous[i])
+            {
+                marked[i] = true;
+            }
+
+            return marked;
+        }
+
+        // Children are diffed as nodes, and ids only identify them
+        bool isDiffed(const std::string& key, bool isNode)
+        {
+            return !isNode || (key != "children" && key != "id");
+        }
+
+        void diffMaps(const std::string& path, const std::string& prefix, const cocos2d::ValueMap& base, const cocos2d::ValueMap& other, bool isNode, std::vector<SceneMerge::Change>& changes)
+        {
+            for (const std::string& key : getSortedKeys(base))
+            {
+                if (!isDiffed(key, isNode))
+                    continue;
+
+                const cocos2d::Value& baseValue = base.at(key);
+                const cocos2d::Value* otherValue = findValue(other, key);
+                if (isMap(&baseValue) && isMap(otherValue))
+                    diffMaps(path, prefix + key + "/", baseValue.asValueMap(), otherValue->asValueMap(), false, changes);
+                else if (!equals(&baseValue, otherValue))
+                    changes.push_back({SceneMerge::Change::Type::MODIFIED, path, prefix + key});
+            }
+
+            for (const std::string& key : getSortedKeys(other))
+            {
+                if (isDiffed(key, isNode) && base.count(key) == 0)
+                    changes.push_back({SceneMerge::Change::Type::MODIFIED, path, prefix + key});
+            }
+        }
+
+        void diffNode(const std::string& path, const cocos2d::ValueMap& base, const cocos2d::ValueMap& other, std::vector<SceneMerge::Change>& changes)
+        {
+            diffMaps(path, "", base, other, true, changes);
+
+            const bool useIds = hasIds(&base) && hasIds(&other);
+            ChildIndex baseChildren(&base, useIds);
+            ChildIndex otherChildren(&other, useIds);
+
+            std::vector<size_t> basePositions;
+            std::vector<size_t> otherPositions;
+            for (size_t i = 0; i < otherChildren._keys.size(); i++)
+            {
+                std::unordered_map<std::string, size_t>::const_iterator it = baseChildren._positions.find(otherChildren._keys[i]);
+                if (it == baseChildren._positions.end())
+                {
+                    changes.push_back({SceneMerge::Change::Type::ADDED, getChildPath(path, *otherChildren._nodes[i]), ""});
+                }
+                else
+                {
+                    basePositions.push_back(it->second);
+                    otherPositions.push_back(i);
+                }
+            }
+
+            for (size_t i = 0; i < baseChildren._keys.size(); i++)
+            {
+                if (!otherChildren.contains(baseChildren._keys[i]))
+                    changes.push_back({SceneMerge::Change::Type::REMOVED, getChildPath(path, *baseChildren._nodes[i]), ""});
+            }
+
+            const std::vector<bool> inOrder = markLongestIncreasing(basePositions);
+            for (size_t i = 0; i < basePositions.size(); i++)
+            {
+                const cocos2d::ValueMap& otherChild = *otherChildren._nodes[otherPositions[i]];
+                const std::string childPath = getChildPath(path, otherChild);
+                if (!inOrder[i])
+                    changes.push_back({SceneMerge::Change::Type::MOVED, childPath, ""});
+
+                diffNode(childPath, *baseChildren._nodes[basePositions[i]], otherChild, changes);
+            }
+        }
+
+        class Merger
+        {
+        public:
+            explicit Merger(std::vector<SceneMerge::Conflict>& conflicts)
+            : _conflicts(conflicts)
+            {
+            }
+
+            void mergeNode(const std::string& path, const cocos2d::ValueMap* base, const cocos2d::ValueMap& ours, const cocos2d::ValueMap& theirs, cocos2d::ValueMap& merged)
+            {
+                mergeMaps(path, "", base, ours, theirs, true, merged);
+
+                const cocos2d::Value* ourChildren = findValue(ours, "children");
+                const cocos2d::Value* theirChildren = findValue(theirs, "children");
+                if (ourChildren && theirChildren)
+                {
+                    mergeChildren(path, base, ours, theirs, merged);
+                }
+                else
+                {
+                    // Prefab instances have no children, one side may have packed or unpacked it
+                    const cocos2d::Value* baseChildren = base ? findValue(*base, "children") : nullptr;
+                    cocos2d::Value children;
+                    if (mergeValue(path, "children", baseChildren, ourChildren, theirChildren, children))
+                        merged.emplace("children", std::move(children));
+                }
+            }
+
+        private:
+            void addConflict(const std::string& path, const std::string& key)
+            {
+                _conflicts.push_back({path, key});
+            }
+
+            // Returns false if the value is absent from the merge
+            bool mergeValue(const std::string& path, const std::string& key, const cocos2d::Value* base, const cocos2d::Value* ours, const cocos2d::Value* theirs, cocos2d::Value& merged)
+            {
+                const cocos2d::Value* result = ours;
+                if (equals(ours, theirs) || equals(base, theirs))
+                {
+                    result = ours;
+                }
+                else if (equals(base, ours))
+                {
+                    result = theirs;
+                }
+                else if (isMap(ours) && isMap(theirs) && (!base || isMap(base)))
+                {
+                    cocos2d::ValueMap resultMap;
+                    mergeMaps(path, key + "/", base ? &base->asValueMap() : nullptr, ours->asValueMap(), theirs->asValueMap(), false, resultMap);
+                    merged = std::move(resultMap);
+                    return true;
+                }
+                else
+                {
+                    addConflict(path, key);
+                }
+
+                if (!result)
+                    return false;
+
+                merged = *result;
+                return true;
+            }
+
+            void mergeMaps(const std::string& path, const std::string& prefix, const cocos2d::ValueMap* base, const cocos2d::ValueMap& ours, const cocos2d::ValueMap& theirs, bool isNode, cocos2d::ValueMap& merged)
+            {
+                // Keys only in base were removed on both sides
+                for (const std::string& key : getSortedKeys(ours))
+                {
+                    if (isNode && key == "children")
+                        continue;
+
+                    cocos2d::Value value;
+                    if (mergeValue(path, prefix + key, base ? findValue(*base, key) : nullptr, &ours.at(key), findValue(theirs, key), value))
+                        merged.emplace(key, std::move(value));
+                }
+
+                for (const std::string& key : getSortedKeys(theirs))
+                {
+                    if ((isNode && key == "children") || ours.count(key) > 0)
+                        continue;
+
+                    cocos2d::Value value;
+                    if (mergeValue(path, prefix + key, base ? findValue(*base, key) : nullptr, nullptr, &theirs.at(key), value))
+                        merged.emplace(key, std::move(value));
+                }
+            }
+
+            // A child removed on one side is kept if the other side modified it
+            bool keepRemoved(const std::string& path, const cocos2d::ValueMap& baseChild, const cocos2d::ValueMap& child)
+            {
+                if (baseChild == child)
+                    return false;
+
+                addConflict(getChildPath(path, child), "");
+                return true;
+            }
+
+            void mergeChildren(const std::string& path, const cocos2d::ValueMap* base, const cocos2d::ValueMap& ours, const cocos2d::ValueMap& theirs, cocos2d::ValueMap& merged)
+            {
+                const bool useIds = hasIds(base) && hasIds(&ours) && hasIds(&theirs);
+                ChildIndex baseChildren(base, useIds);
+                ChildIndex ourChildren(&ours, useIds);
+                ChildIndex theirChildren(&theirs, useIds);
+
+                // The order comes from the side which changed it, ours if both did
+                const bool oursReordered = isReordered(baseChildren, ourChildren);
+                const bool theirsReordered = isReordered(baseChildren, theirChildren);
+                if (oursReordered && theirsReordered && getCommonKeys(ourChildren, theirChildren) != getCommonKeys(theirChildren, ourChildren))
+                    addConflict(path, "children");
+
+                const bool theirsFirst = theirsReordered && !oursReordered;
+                const ChildIndex& primary = theirsFirst ? theirChildren : ourChildren;
+                const ChildIndex& secondary = theirsFirst ? ourChildren : theirChildren;
+
+                std::list<std::string> order;
+                std::unordered_map<std::string, std::list<std::string>::iterator> positions;
+                for (size_t i = 0; i < primary._keys.size(); i++)
+                {
+                    const std::string& key = primary._keys[i];
+                    const cocos2d::ValueMap* baseChild = baseChildren.find(key);
+                    if (baseChild && !secondary.contains(key) && !keepRemoved(path, *baseChild, *primary._nodes[i]))
+                        continue;
+
+                    positions.emplace(key, order.insert(order.end(), key));
+                }
+
+                // Children added by the secondary side follow the sibling they follow there
+                std::list<std::string>::iterator anchor = order.begin();
+                for (size_t i = 0; i < secondary._keys.size(); i++)
+                {
+                    const std::string& key = secondary._keys[i];
+                    std::unordered_map<std::string, std::list<std::string>::iterator>::iterator it = positions.find(key);
+                    if (it != positions.end())
+                    {
+                        anchor = std::next(it->second);
+                        continue;
+                    }
+
+                    const cocos2d::ValueMap* baseChild = baseChildren.find(key);
+                    if (baseChild && !keepRemoved(path, *baseChild, *secondary._nodes[i]))
+                        continue;
+
+                    positions.emplace(key, order.insert(anchor, key));
+                }
+
+                cocos2d::ValueVector children;
+                children.reserve(order.size());
+                for (const std::string& key : order)
+                {
+                    const cocos2d::ValueMap* ourChild = ourChildren.find(key);
+                    const cocos2d::ValueMap* theirChild = theirChildren.find(key);
+                    if (ourChild && theirChild)
+                    {
+                        cocos2d::ValueMap child;
+                        mergeNode(getChildPath(path, *ourChild), baseChildren.find(key), *ourChild, *theirChild, child);
+                        children.push_back(cocos2d::Value(std::move(child)));
+                    }
+                    else
+                    {
+                        children.push_back(cocos2d::Value(ourChild ? *ourChild : *theirChild));
+                    }
+                }
+
+                merged.emplace("children", cocos2d::Value(std::move(children)));
+            }
+
+            std::vector<SceneMerge::Conflict>& _conflicts;
+        };
+    }
+
+    void SceneMerge::diff(const cocos2d::ValueMap& base, const cocos2d::ValueMap& other, std::vector<Change>& changes)
+    {
+        diffNode(getName(other), base, other, changes);
+    }
+
+    bool SceneMerge::merge(const cocos2d::ValueMap& base, const cocos2d::ValueMap& ours, const cocos2d::ValueMap& theirs, cocos2d::ValueMap& merged, std::vector<Conflict>& conflicts)
+    {
+        const size_t conflictCount = conflicts.size();
+        merged.clear();
+
+        Merger merger(conflicts);
+        merger.mergeNode(getName(ours), &base, ours, theirs, merged);
+        return conflicts.size() == conflictCount;
+    }
+
+    std::string SceneMerge::toString(const Change& change)
+    {
+        switch (change._type)
+        {
+        case Change::Type::ADDED: return "+ " + change._path;
+        case Change::Type::REMOVED: return "- " + change._path;
+        case Change::Type::MOVED: return "> " + change._path;
+        default: return "~ " + change._path + ": " + change._key;
+        }
+    }
+
+    std::string SceneMerge::toString(const Conflict& conflict)
+    {
+        if (conflict._key.empty())
+            return conflict._path + ": removed on one side and modified on the other";
+
+        return conflict._path + ": " + conflict._key;
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef __CCIMEDITOR_SCENEMERGE_H__
+#define __CCIMEDITOR_SCENEMERGE_H__
+
+#include <string>
+#include <vector>
+#include "cocos2d.h"
+
+namespace CCImEditor
+{
+    // Structural diff and three-way merge of scene descriptions. Nodes are matched by their
+    // "id", so renamed, moved and reordered nodes are recognized. Siblings of which one on
+    // any side has no id, as in files saved before nodes had one, are all matched by type
+    // and name instead. Nodes, children and keys are looked up through hash
+    // maps and each value is compared at most a few times, the cost grows with the size
+    // of the scenes and not with the square of their child counts.
+    class SceneMerge
+    {
+    public:
+        struct Change
+        {
+            enum class Type
+            {
+                ADDED,
+                REMOVED,
+                MODIFIED,
+                MOVED,
+            };
+
+            Type _type;
+            std::string _path; // names of the node and its ancestors, e.g. "Root/Player/Body"
+            std::string _key;  // modified value, e.g. "properties/Position" or "components/Lua/properties/Script"
+        };
+
+        struct Conflict
+        {
+            std::string _path;
+            std::string _key; // empty if a node was removed on one side and modified on the other
+        };
+
+        // Changes turning base into other
+        static void diff(const cocos2d::ValueMap& base, const cocos2d::ValueMap& other, std::vector<Change>& changes);
+
+        // Applies the changes from base to theirs on top of ours. Where both sides changed the
+        // same value differently, ours is kept and the conflict is reported.
+        // Returns true if there is no conflict.
+        static bool merge(const cocos2d::ValueMap& base, const cocos2d::ValueMap& ours, const cocos2d::ValueMap& theirs, cocos2d::ValueMap& merged, std::vector<Conflict>& conflicts);
+
+        static std::string toString(const Change& change);
+        static std::string toString(const Conflict& conflict);
+    };
+}
+
+#endif
@@ -0,0 +1,408 @@
+#include "SceneWriter.h"
+#include "AtomicFile.h"
+#include "BinaryScene.h"
+#include "SceneFragment.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace CCImEditor
+{
+    namespace
+    {
+        typedef std::vector<const cocos2d::ValueMap::value_type*> SortedEntries;
+
+        const cocos2d::ValueMap s_emptyMap;
+
+        // The children of a fragment are written in place of this entry
+        const cocos2d::ValueMap::value_type s_childrenEntry("children", cocos2d::Value());
+
+        void sortEntries(const cocos2d::ValueMap& valueMap, const SceneFragment* children, SortedEntries& entries)
+        {
+            entries.reserve(valueMap.size() + 1);
+            for (const cocos2d::ValueMap::value_type& entry : valueMap)
+            {
+                entries.push_back(&entry);
+            }
+
+            if (children)
+                entries.push_back(&s_childrenEntry);
+
+            std::sort(entries.begin(), entries.end(), [](const cocos2d::ValueMap::value_type* a, const cocos2d::ValueMap::value_type* b)
+            {
+                return a->first < b->first;
+            });
+        }
+    }
+
+    SceneWriter::SceneWriter(Format format, bool compact, const Sink& sink)
+    : _format(format)
+    , _compact(compact)
+    , _sink(sink)
+    {
+    }
+
+    bool SceneWriter::write(const cocos2d::ValueMap& root)
+    {
+        return write(root, nullptr);
+    }
+
+    bool SceneWriter::write(const SceneFragment& root)
+    {
+        return write(root._node ? *root._node : s_emptyMap, root._hasChildren ? &root : nullptr);
+    }
+
+    bool SceneWriter::write(const cocos2d::ValueMap& root, const SceneFragment* children)
+    {
+        _failed = false;
+        _used = 0;
+
+        if (_format == Format::JSON)
+        {
+            writeJsonMap(root, children, 0);
+            put('\n');
+        }
+        else
+        {
+            put("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+            put("<!DOCTYPE plist PUBLIC \"-//Apple//DTD PLIST 1.0//EN\" \"http://www.apple.com/DTDs/PropertyList-1.0.dtd\">\n");
+            put("<plist version=\"1.0\">");
+            newLine(0);
+            writePListMap(root, children, 0);
+            newLine(0);
+            put("</plist>\n");
+        }
+
+        flush();
+        return !_failed;
+    }
+
+    template <typename Root>
+    bool SceneWriter::writeFile(const std::string& fullPath, const Root& root, bool compact)
+    {
+        Internal::AtomicFile atomicFile;
+        if (!atomicFile.open(fullPath))
+            return false;
+
+        const std::string extension = cocos2d::FileUtils::getInstance()->getFileExtension(fullPath);
+        if (extension == BinaryScene::getFileExtension())
+        {
+            std::string content;
+            return BinaryScene::encode(root, content) && atomicFile.write(content.data(), content.size()) && atomicFile.commit();
+        }
+
+        SceneWriter writer(extension == ".json" ? Format::JSON : Format::PLIST, compact,
+            [&atomicFile](const char* data, size_t size)
+            {
+                return atomicFile.write(data, size);
+            });
+        return writer.write(root) && atomicFile.commit();
+    }
+
+    bool SceneWriter::writeFile(const std::string& fullPath, const cocos2d::ValueMap& root, bool compact)
+    {
+        return writeFile<cocos2d::ValueMap>(fullPath, root, compact);
+    }
+
+    bool SceneWriter::writeFile(const std::string& fullPath, const SceneFragment& root, bool compact)
+    {
+        return writeFile<SceneFragment>(fullPath, root, compact);
+    }
+
+    void SceneWriter::writeJson(const cocos2d::Value& value, int depth)
+    {
+        switch (value.getType())
+        {
+        case cocos2d::Value::Type::MAP:
+            writeJsonMap(value.asValueMap(), nullptr, depth);
+            break;
+        case cocos2d::Value::Type::VECTOR:
+        {
+            const cocos2d::ValueVector& valueVector = value.asValueVector();
+            put('[');
+            for (size_t i = 0; i < valueVector.size(); i++)
+            {
+                if (i > 0)
+                    put(',');
+
+                newLine(depth + 1);
+                writeJson(valueVector[i], depth + 1);
+            }
+
+            if (!valueVector.empty())
+                newLine(depth);
+            put(']');
+            break;
+        }
+        case cocos2d::Value::Type::STRING:
+            writeJsonString(value.asString());
+            break;
+        case cocos2d::Value::Type::BOOLEAN:
+            put(value.asBool() ? "true" : "false");
+            break;
+        case cocos2d::Value::Type::NONE:
+            put("null");
+            break;
+        default:
+            writeNumber(value);
+            break;
+        }
+    }
+
+    void SceneWriter::writeJsonMap(const cocos2d::ValueMap& valueMap, const SceneFragment* children, int depth)
+    {
+        SortedEntries entries;
+        sortEntries(valueMap, children, entries);
+
+        put('{');
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            if (i > 0)
+                put(',');
+
+            newLine(depth + 1);
+            writeJsonString(entries[i]->first);
+            put(_compact ? ":" : ": ");
+            if (entries[i] == &s_childrenEntry)
+                writeJsonChildren(*children, depth + 1);
+            else
+                writeJson(entries[i]->second, depth + 1);
+        }
+
+        if (!entries.empty())
+            newLine(depth);
+        put('}');
+    }
+
+    // Same layout as writeJson for a vector
+    void SceneWriter::writeJsonChildren(const SceneFragment& fragment, int depth)
+    {
+        put('[');
+        for (size_t i = 0; i < fragment._children.size(); i++)
+        {
+            if (i > 0)
+                put(',');
+
+            const SceneFragment& child = *fragment._children[i];
+            newLine(depth + 1);
+            writeJsonMap(child._node ? *child._node : s_emptyMap, child._hasChildren ? &child : nullptr, depth + 1);
+        }
+
+        if (!fragment._children.empty())
+            newLine(depth);
+        put(']');
+    }
+
+    void SceneWriter::writeJsonString(const std::string& str)
+    {
+        put('"');
+        for (char c : str)
+        {
+            switch (c)
+            {
+            case '"': put("\\\""); break;
+            case '\\': put("\\\\"); break;
+            case '\b': put("\\b"); break;
+            case '\f': put("\\f"); break;
+            case '\n': put("\\n"); break;
+            case '\r': put("\\r"); break;
+            case '\t': put("\\t"); break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+                    put(escaped);
+                }
+                else
+                {
+                    put(c);
+                }
+                break;
+            }
+        }
+        put('"');
+    }
+
+    void SceneWriter::writePList(const cocos2d::Value& value, int depth)
+    {
+        switch (value.getType())
+        {
+        case cocos2d::Value::Type::MAP:
+            writePListMap(value.asValueMap(), nullptr, depth);
+            break;
+        case cocos2d::Value::Type::VECTOR:
+        {
+            const cocos2d::ValueVector& valueVector = value.asValueVector();
+            put("<array>");
+            for (const cocos2d::Value& element : valueVector)
+            {
+                if (element.isNull())
+                    continue;
+
+                newLine(depth + 1);
+                writePList(element, depth + 1);
+            }
+
+            newLine(depth);
+            put("</array>");
+            break;
+        }
+        case cocos2d::Value::Type::STRING:
+            put("<string>");
+            writeXmlEscaped(value.asString());
+            put("</string>");
+            break;
+        case cocos2d::Value::Type::BOOLEAN:
+            put(value.asBool() ? "<true/>" : "<false/>");
+            break;
+        case cocos2d::Value::Type::FLOAT:
+        case cocos2d::Value::Type::DOUBLE:
+            put("<real>");
+            writeNumber(value);
+            put("</real>");
+            break;
+        default:
+            put("<integer>");
+            writeNumber(value);
+            put("</integer>");
+            break;
+        }
+    }
+
+    void SceneWriter::writePListMap(const cocos2d::ValueMap& valueMap, const SceneFragment* children, int depth)
+    {
+        SortedEntries entries;
+        sortEntries(valueMap, children, entries);
+
+        put("<dict>");
+        for (const cocos2d::ValueMap::value_type* entry : entries)
+        {
+            // PList has no null
+            if (entry != &s_childrenEntry && entry->second.isNull())
+                continue;
+
+            newLine(depth + 1);
+            put("<key>");
+            writeXmlEscaped(entry->first);
+            put("</key>");
+            newLine(depth + 1);
+            if (entry == &s_childrenEntry)
+                writePListChildren(*children, depth + 1);
+            else
+                writePList(entry->second, depth + 1);
+        }
+
+        newLine(depth);
+        put("</dict>");
+    }
+
+    // Same layout as writePList for a vector
+    void SceneWriter::writePListChildren(const SceneFragment& fragment, int depth)
+    {
+        put("<array>");
+        for (const std::shared_ptr<const SceneFragment>& child : fragment._children)
+        {
+            newLine(depth + 1);
+            writePListMap(child->_node ? *child->_node : s_emptyMap, child->_hasChildren ? child.get() : nullptr, depth + 1);
+        }
+
+        newLine(depth);
+        put("</array>");
+    }
+
+    void SceneWriter::writeXmlEscaped(const std::string& str)
+    {
+        for (char c : str)
+        {
+            switch (c)
+            {
+            case '&': put("&amp;"); break;
+            case '<': put("&lt;"); break;
+            case '>': put("&gt;"); break;
+            case '"': put("&quot;"); break;
+            case '\'': put("&apos;"); break;
+            default: put(c); break;
+            }
+        }
+    }
+
+    void SceneWriter::writeNumber(const cocos2d::Value& value)
+    {
+        char number[32];
+        switch (value.getType())
+        {
+        case cocos2d::Value::Type::FLOAT:
+        case cocos2d::Value::Type::DOUBLE:
+        {
+            // Shortest form which reads back the same value, JSON has no inf or nan
+            const bool isFloat = value.getType() == cocos2d::Value::Type::FLOAT;
+            const double v = std::isfinite(value.asDouble()) ? value.asDouble() : 0.0;
+            for (int digits = isFloat ? 6 : 15; digits <= (isFloat ? 9 : 17); digits++)
+            {
+                snprintf(number, sizeof(number), "%.*g", digits, v);
+                if (isFloat ? strtof(number, nullptr) == static_cast<float>(v) : strtod(number, nullptr) == v)
+                    break;
+            }
+            break;
+        }
+        case cocos2d::Value::Type::UNSIGNED:
+            snprintf(number, sizeof(number), "%u", value.asUnsignedInt());
+            break;
+        default:
+            snprintf(number, sizeof(number), "%d", value.asInt());
+            break;
+        }
+
+        put(number);
+    }
+
+    void SceneWriter::newLine(int depth)
+    {
+        if (_compact)
+            return;
+
+        put('\n');
+        for (int i = 0; i < depth; i++)
+        {
+            put(_format == Format::JSON ? "    " : "\t");
+        }
+    }
+
+    void SceneWriter::put(char c)
+    {
+        if (_used == s_bufferSize)
+            flush();
+
+        _buffer[_used++] = c;
+    }
+
+    void SceneWriter::put(const char* str)
+    {
+        put(str, strlen(str));
+    }
+
+    void SceneWriter::put(const char* data, size_t size)
+    {
+        while (size > 0)
+        {
+            if (_used == s_bufferSize)
+                flush();
+
+            const size_t n = std::min(size, s_bufferSize - _used);
+            memcpy(_buffer + _used, data, n);
+            _used += n;
+            data += n;
+            size -= n;
+        }
+    }
+
+    void SceneWriter::flush()
+    {
+        if (_used > 0 && !_failed && !_sink(_buffer, _used))
+            _failed = true;
+
+        _used = 0;
+    }
+}
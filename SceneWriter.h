@@ -0,0 +1,73 @@
+#ifndef __CCIMEDITOR_SCENEWRITER_H__
+#define __CCIMEDITOR_SCENEWRITER_H__
+
+#include <string>
+#include <functional>
+#include "cocos2d.h"
+
+namespace CCImEditor
+{
+    struct SceneFragment;
+
+    // Writes a scene description as JSON or XML PList. Map keys are written in sorted order
+    // so that saving the same scene twice gives the same bytes, and the output goes through
+    // a fixed size buffer to the sink instead of being built in memory.
+    class SceneWriter
+    {
+    public:
+        enum class Format
+        {
+            JSON,
+            PLIST,
+        };
+
+        // Receives the output in chunks, returns false to stop writing
+        typedef std::function<bool(const char* data, size_t size)> Sink;
+
+        SceneWriter(Format format, bool compact, const Sink& sink);
+
+        bool write(const cocos2d::ValueMap& root);
+        bool write(const SceneFragment& root);
+
+        // Atomically replaces the file at fullPath, the format follows its extension
+        // (.ccbin, .json, otherwise PList). Safe to call from worker threads.
+        static bool writeFile(const std::string& fullPath, const cocos2d::ValueMap& root, bool compact);
+        static bool writeFile(const std::string& fullPath, const SceneFragment& root, bool compact);
+
+    private:
+        SceneWriter(const SceneWriter&) = delete;
+        void operator=(const SceneWriter&) = delete;
+
+        template <typename Root>
+        static bool writeFile(const std::string& fullPath, const Root& root, bool compact);
+
+        // children is the fragment whose children are written as the "children" of the map
+        bool write(const cocos2d::ValueMap& root, const SceneFragment* children);
+        void writeJson(const cocos2d::Value& value, int depth);
+        void writeJsonMap(const cocos2d::ValueMap& valueMap, const SceneFragment* children, int depth);
+        void writeJsonChildren(const SceneFragment& fragment, int depth);
+        void writeJsonString(const std::string& str);
+        void writePList(const cocos2d::Value& value, int depth);
+        void writePListMap(const cocos2d::ValueMap& valueMap, const SceneFragment* children, int depth);
+        void writePListChildren(const SceneFragment& fragment, int depth);
+        void writeXmlEscaped(const std::string& str);
+        void writeNumber(const cocos2d::Value& value);
+
+        void newLine(int depth);
+        void put(char c);
+        void put(const char* str);
+        void put(const char* data, size_t size);
+        void flush();
+
+        Format _format;
+        bool _compact;
+        Sink _sink;
+        bool _failed = false;
+
+        static const size_t s_bufferSize = 64 * 1024;
+        char _buffer[s_bufferSize];
+        size_t _used = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,70 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace CCImEditor
+{
+    namespace Internal
+    {
+        ThreadPool::ThreadPool(size_t threadCount)
+        {
+            threadCount = std::max<size_t>(threadCount, 1);
+            _threads.reserve(threadCount);
+            for (size_t i = 0; i < threadCount; i++)
+            {
+                _threads.emplace_back(&ThreadPool::run, this);
+            }
+        }
+
+        ThreadPool::~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stopping = true;
+            }
+
+            _condition.notify_all();
+            for (std::thread& thread : _threads)
+            {
+                thread.join();
+            }
+        }
+
+        ThreadPool* ThreadPool::getInstance()
+        {
+            static ThreadPool instance(std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 1);
+            return &instance;
+        }
+
+        void ThreadPool::push(std::function<void()>&& task)
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _tasks.push_back(std::move(task));
+            }
+
+            _condition.notify_one();
+        }
+
+        void ThreadPool::run()
+        {
+            while (true)
+            {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _condition.wait(lock, [this]() { return _stopping || !_tasks.empty(); });
+
+                    // Queued tasks are still run when stopping, someone may wait on them
+                    if (_tasks.empty())
+                        return;
+
+                    task = std::move(_tasks.front());
+                    _tasks.pop_front();
+                }
+
+                task();
+            }
+        }
+    }
+}
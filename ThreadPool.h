@@ -0,0 +1,57 @@
+#ifndef __CCIMEDITOR_THREADPOOL_H__
+#define __CCIMEDITOR_THREADPOOL_H__
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <vector>
+#include <type_traits>
+
+namespace CCImEditor
+{
+    namespace Internal
+    {
+        // Fixed set of worker threads for jobs which do not touch the scene graph,
+        // like reading and decoding files.
+        class ThreadPool
+        {
+        public:
+            explicit ThreadPool(size_t threadCount);
+            ~ThreadPool();
+
+            // Shared pool with one thread per core, leaving one core to the main thread
+            static ThreadPool* getInstance();
+
+            template <typename Func>
+            std::future<std::invoke_result_t<Func>> enqueue(Func&& func)
+            {
+                typedef std::invoke_result_t<Func> ResultType;
+                std::shared_ptr<std::packaged_task<ResultType()>> task = std::make_shared<std::packaged_task<ResultType()>>(std::forward<Func>(func));
+                std::future<ResultType> future = task->get_future();
+                push([task]() { (*task)(); });
+                return future;
+            }
+
+            size_t getThreadCount() const { return _threads.size(); };
+
+        private:
+            ThreadPool(const ThreadPool&) = delete;
+            void operator=(const ThreadPool&) = delete;
+
+            void push(std::function<void()>&& task);
+            void run();
+
+            std::vector<std::thread> _threads;
+            std::deque<std::function<void()>> _tasks;
+            std::mutex _mutex;
+            std::condition_variable _condition;
+            bool _stopping = false;
+        };
+    }
+}
+
+#endif
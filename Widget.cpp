@@ -2,11 +2,10 @@
 
 namespace CCImEditor
 {
-    bool Widget::init(const std::string& typeName, const std::string& windowName, uint32_t mask)
+    bool Widget::init(const RegisteredType* type, const std::string& windowName)
     {
-        _typeName = typeName;
+        _type = type;
         _windowName = windowName;
-        _mask = mask;
         return true;
     }
 }
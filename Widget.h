@@ -2,6 +2,7 @@
 #define __CCIMEDITOR_WIDGET_H__
 
 #include "cocos2d.h"
+#include "RegisteredType.h"
 
 namespace CCImEditor
 {
@@ -11,24 +12,24 @@ namespace CCImEditor
         friend class WidgetFactory;
 		friend class Editor;
 
-        const std::string& getTypeName() const {return _typeName;}
+        const RegisteredType* getType() const {return _type;}
+        const std::string& getTypeName() const {return _type->getName();}
         const std::string& getWindowName() const {return _windowName;}
         
-        uint32_t getMask() const { return _mask; };
+        uint32_t getMask() const { return _type->getMask(); };
         
     protected:
         Widget() {};
         virtual ~Widget() {};
 
-        virtual bool init(const std::string& name, const std::string& windowName, uint32_t mask);
+        virtual bool init(const RegisteredType* type, const std::string& windowName);
 
     private:
         virtual void draw(bool* open) = 0;
         virtual void update(float) {};
 
-        std::string _typeName;
+        const RegisteredType* _type = nullptr;
         std::string _windowName;
-        uint32_t _mask;
     };
 }
 
@@ -5,7 +5,7 @@ namespace CCImEditor
 {
     namespace
     {
-        std::unordered_map<std::string, uint64_t> s_nameIdMap;
+        std::unordered_map<uint32_t, uint64_t> s_nameIdMap;
     }
 
     Widget* WidgetFactory::WidgetType::create() const
@@ -13,17 +13,14 @@ namespace CCImEditor
         Widget* widget = _constructor();
 
         std::ostringstream oss;
-
-        const std::string& displayName = getDisplayName();
-        size_t lastSlash = displayName.find_last_of('/');
-        oss << (lastSlash == std::string::npos ? displayName : displayName.substr(lastSlash + 1));
+        oss << getShortName();
         oss << "###";
-        oss << _name;
+        oss << getName();
         oss << ".";
-        uint64_t& id = s_nameIdMap[_name];
+        uint64_t& id = s_nameIdMap[getId()];
         oss << id++;
         
-        if (widget && widget->init(_name, oss.str(), _mask))
+        if (widget && widget->init(this, oss.str()))
         {
             widget->autorelease();
             return widget;
@@ -39,6 +36,12 @@ namespace CCImEditor
         return &instance;
     }
 
+    const WidgetFactory::WidgetType* WidgetFactory::getWidgetType(const std::string& name) const
+    {
+        std::unordered_map<std::string, WidgetType>::const_iterator it = _widgetTypes.find(name);
+        return it != _widgetTypes.end() ? &it->second : nullptr;
+    }
+
     Widget* WidgetFactory::createWidget(const std::string& name)
     {
         std::unordered_map<std::string, WidgetType>::iterator it = _widgetTypes.find(name);
@@ -16,29 +16,21 @@ namespace CCImEditor
     class WidgetFactory
     {
     public:
-        struct WidgetType
+        struct WidgetType : RegisteredType
         {
             friend class WidgetFactory;
             
             WidgetType(const std::string& name, const std::string& displayName, uint32_t mask, const std::function<Widget*()>& constructor)
-            : _name(name)
-            , _displayName(displayName)
-            , _mask(mask)
+            : RegisteredType(name, displayName, mask)
             , _constructor(constructor)
             {
             }
 
-            const std::string& getName() const { return _name; };
-            const std::string& getDisplayName() const { return _displayName; };
-            uint32_t getMask() const { return _mask; };
-            bool allowMultiple() const { return (_mask & WidgetFlags_DisallowMultiple) == 0; };
+            bool allowMultiple() const { return (getMask() & WidgetFlags_DisallowMultiple) == 0; };
 
             Widget* create() const;
 
         private:
-            std::string _name;
-            std::string _displayName;
-            uint32_t _mask;
             std::function<Widget*()> _constructor;
         };
     
@@ -49,6 +41,7 @@ namespace CCImEditor
             WidgetFactory::getInstance()->_widgetTypes.emplace(name, WidgetType(name, displayName, mask, constructor));
         }
 
+        const WidgetType* getWidgetType(const std::string& name) const;
         const std::unordered_map<std::string, WidgetType>& getWidgetTypes() { return _widgetTypes; };
 
         Widget* createWidget(const std::string& name);
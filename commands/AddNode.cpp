@@ -1,23 +1,45 @@
 #include "AddNode.h"
+#include "Editor.h"
+#include "NodeImDrawer.h"
 
 namespace CCImEditor
 {
     void AddNode::undo()
     {
+        if (!resolve())
+            return;
+
         _parent->removeChild(_child);
+        NodeImDrawer::setChildrenDirty(_parent);
         if (_parentBefore)
         {
             _parentBefore->addChild(_child);
+            NodeImDrawer::setChildrenDirty(_parentBefore);
+            Editor::getInstance()->getEventBus().publish(EditorEvents::NodeReparented{_child, _parent, _parentBefore});
+        }
+        else
+        {
+            Editor::getInstance()->getEventBus().publish(EditorEvents::NodeRemoved{_child, _parent});
         }
     }
 
     void AddNode::execute()
     {
+        if (!resolve())
+            return;
+
         if (_parentBefore)
         {
             _parentBefore->removeChild(_child);
+            NodeImDrawer::setChildrenDirty(_parentBefore);
         }
         _parent->addChild(_child);
+        NodeImDrawer::setChildrenDirty(_parent);
+
+        if (_parentBefore)
+            Editor::getInstance()->getEventBus().publish(EditorEvents::NodeReparented{_child, _parentBefore, _parent});
+        else
+            Editor::getInstance()->getEventBus().publish(EditorEvents::NodeAdded{_child, _parent});
     }
 
     AddNode* AddNode::create(cocos2d::Node* parent, cocos2d::Node* child)
@@ -29,6 +51,7 @@ namespace CCImEditor
                 command->_parentBefore = child->getParent();
                 command->_parent = parent;
                 command->_child = child;
+                command->_memorySize = sizeof(AddNode) + (command->_parentBefore ? 0 : getNodeMemorySize(child));
                 command->autorelease();
                 return command;
             }
@@ -36,4 +59,69 @@ namespace CCImEditor
 
         return nullptr;
     }
+
+    // The child is in the scene once the command is done, a new one was added by it
+    bool AddNode::serialize(cocos2d::ValueMap& target) const
+    {
+        const std::string childId = _child ? getNodeId(_child) : _childId;
+        const std::string parentId = _parent ? getNodeId(_parent) : _parentId;
+        const std::string parentBeforeId = _parentBefore ? getNodeId(_parentBefore) : _parentBeforeId;
+        if (childId.empty() || parentId.empty() || (_parentBefore && parentBeforeId.empty()))
+            return false;
+
+        target["type"] = "AddNode";
+        target["child"] = childId;
+        target["parent"] = parentId;
+        if (!parentBeforeId.empty())
+            target["parentBefore"] = parentBeforeId;
+
+        return true;
+    }
+
+    AddNode* AddNode::deserialize(const cocos2d::ValueMap& source)
+    {
+        cocos2d::ValueMap::const_iterator childIt = source.find("child");
+        cocos2d::ValueMap::const_iterator parentIt = source.find("parent");
+        if (childIt == source.end() || parentIt == source.end())
+            return nullptr;
+
+        if (AddNode* command = new (std::nothrow)AddNode())
+        {
+            command->_childId = childIt->second.asString();
+            command->_parentId = parentIt->second.asString();
+
+            cocos2d::ValueMap::const_iterator parentBeforeIt = source.find("parentBefore");
+            if (parentBeforeIt != source.end())
+                command->_parentBeforeId = parentBeforeIt->second.asString();
+
+            command->_memorySize = sizeof(AddNode);
+            command->autorelease();
+            return command;
+        }
+
+        return nullptr;
+    }
+
+    bool AddNode::resolve()
+    {
+        if (_child)
+            return true;
+
+        cocos2d::Node* child = findNode(_childId);
+        cocos2d::Node* parent = findNode(_parentId);
+        cocos2d::Node* parentBefore = _parentBeforeId.empty() ? nullptr : findNode(_parentBeforeId);
+        if (!child || !parent || (!_parentBeforeId.empty() && !parentBefore))
+        {
+            CCLOGWARN("Failed to find the nodes of AddNode %s in the editing node", _childId.c_str());
+            return false;
+        }
+
+        _child = child;
+        _parent = parent;
+        _parentBefore = parentBefore;
+        _childId.clear();
+        _parentId.clear();
+        _parentBeforeId.clear();
+        return true;
+    }
 }
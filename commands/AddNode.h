@@ -10,12 +10,24 @@ namespace CCImEditor
     public:
         void undo() override;
         void execute() override;
+        size_t getMemorySize() const override { return _memorySize; };
+        bool serialize(cocos2d::ValueMap& target) const override;
         static AddNode* create(cocos2d::Node* parent, cocos2d::Node* child);
+        static AddNode* deserialize(const cocos2d::ValueMap& source);
 
     private:
+        // Finds the nodes of a command read back by their ids
+        bool resolve();
+
         cocos2d::RefPtr<cocos2d::Node> _parent;
         cocos2d::RefPtr<cocos2d::Node> _child;
         cocos2d::RefPtr<cocos2d::Node> _parentBefore;
+        size_t _memorySize = 0; // with the subtree of a new node, kept alive once undone
+
+        // Ids of the nodes, only until a command read back has found them
+        std::string _parentId;
+        std::string _childId;
+        std::string _parentBeforeId;
     };
 }
 
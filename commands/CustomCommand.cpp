@@ -1,4 +1,6 @@
 #include "CustomCommand.h"
+#include "Editor.h"
+#include "NodeImDrawer.h"
 
 namespace CCImEditor
 {
@@ -12,7 +14,39 @@ namespace CCImEditor
         _execute();
     }
 
-    CustomCommand* CustomCommand::create(std::function<void()> execute, std::function<void()> undo)
+    // What the functions capture can not be measured, mostly the values of a property
+    size_t CustomCommand::getMemorySize() const
+    {
+        return sizeof(CustomCommand) + _mergeKey.capacity() + (_before.size() + _after.size()) * 64;
+    }
+
+    // Undoing goes back to the state before this command, executing goes to the one after next
+    bool CustomCommand::merge(Command* next)
+    {
+        CustomCommand* command = dynamic_cast<CustomCommand*>(next);
+        if (!command || _mergeKey.empty() || command->_mergeKey != _mergeKey)
+            return false;
+
+        _execute = command->_execute;
+        if (!_nodeId.empty() && command->_nodeId == _nodeId && command->_component == _component)
+        {
+            // Values of properties first changed by next are the ones before it
+            for (const std::pair<const std::string, cocos2d::Value>& pair : command->_before)
+                _before.emplace(pair.first, pair.second);
+
+            for (const std::pair<const std::string, cocos2d::Value>& pair : command->_after)
+                _after[pair.first] = pair.second;
+        }
+        else
+        {
+            _nodeId.clear();
+            _before.clear();
+            _after.clear();
+        }
+        return true;
+    }
+
+    CustomCommand* CustomCommand::create(std::function<void()> execute, std::function<void()> undo, const std::string& mergeKey)
     {
         if (execute && undo)
         {
@@ -20,6 +54,7 @@ namespace CCImEditor
             {
                 command->_execute = execute;
                 command->_undo = undo;
+                command->_mergeKey = mergeKey;
                 command->autorelease();
                 return command;
             }
@@ -27,4 +62,94 @@ namespace CCImEditor
 
         return nullptr;
     }
+
+    void CustomCommand::setProperties(const std::string& nodeId, const std::string& component, cocos2d::ValueMap before, cocos2d::ValueMap after)
+    {
+        for (cocos2d::ValueMap::iterator it = before.begin(); it != before.end();)
+        {
+            cocos2d::ValueMap::iterator afterIt = after.find(it->first);
+            if (afterIt != after.end() && afterIt->second == it->second)
+            {
+                after.erase(afterIt);
+                it = before.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        _nodeId = nodeId;
+        _component = component;
+        _before = std::move(before);
+        _after = std::move(after);
+    }
+
+    bool CustomCommand::serialize(cocos2d::ValueMap& target) const
+    {
+        if (_nodeId.empty())
+            return false;
+
+        target["type"] = "CustomCommand";
+        target["node"] = _nodeId;
+        if (!_component.empty())
+            target["component"] = _component;
+        target["before"] = _before;
+        target["after"] = _after;
+        return true;
+    }
+
+    CustomCommand* CustomCommand::deserialize(const cocos2d::ValueMap& source)
+    {
+        cocos2d::ValueMap::const_iterator nodeIt = source.find("node");
+        cocos2d::ValueMap::const_iterator beforeIt = source.find("before");
+        cocos2d::ValueMap::const_iterator afterIt = source.find("after");
+        if (nodeIt == source.end() || beforeIt == source.end() || afterIt == source.end() ||
+            beforeIt->second.getType() != cocos2d::Value::Type::MAP || afterIt->second.getType() != cocos2d::Value::Type::MAP)
+            return nullptr;
+
+        const std::string nodeId = nodeIt->second.asString();
+        cocos2d::ValueMap::const_iterator componentIt = source.find("component");
+        const std::string component = componentIt != source.end() ? componentIt->second.asString() : std::string();
+        const cocos2d::ValueMap& before = beforeIt->second.asValueMap();
+        const cocos2d::ValueMap& after = afterIt->second.asValueMap();
+
+        CustomCommand* command = create(
+            [nodeId, component, after]() { applyProperties(nodeId, component, after); },
+            [nodeId, component, before]() { applyProperties(nodeId, component, before); }
+        );
+
+        if (command)
+            command->setProperties(nodeId, component, before, after);
+
+        return command;
+    }
+
+    void CustomCommand::applyProperties(const std::string& nodeId, const std::string& component, const cocos2d::ValueMap& properties)
+    {
+        cocos2d::Node* node = findNode(nodeId);
+        NodeImDrawer* drawer = node ? node->getComponent<NodeImDrawer>() : nullptr;
+        ImPropertyGroup* group = nullptr;
+        if (drawer && component.empty())
+        {
+            group = drawer->getNodePropertyGroup();
+        }
+        else if (drawer)
+        {
+            // getComponentPropertyGroup would add an empty entry for a missing component
+            const std::map<std::string, cocos2d::RefPtr<ImPropertyGroup>>& groups = drawer->getComponentPropertyGroups();
+            std::map<std::string, cocos2d::RefPtr<ImPropertyGroup>>::const_iterator it = groups.find(component);
+            if (it != groups.end())
+                group = it->second;
+        }
+
+        if (!group)
+        {
+            CCLOGWARN("Failed to find the properties of %s in the editing node", nodeId.c_str());
+            return;
+        }
+
+        group->deserialize(properties);
+        Editor::getInstance()->getEventBus().publish(EditorEvents::PropertyChanged{node, group, nullptr});
+    }
 }
@@ -10,11 +10,35 @@ namespace CCImEditor
     public:
         void undo() override;
         void execute() override;
-        static CustomCommand* create(std::function<void()> execute, std::function<void()> undo);
+        size_t getMemorySize() const override;
+        bool merge(Command* next) override;
+        bool serialize(cocos2d::ValueMap& target) const override;
+
+        // Commands with the same non-empty merge key are merged, e.g. for the edits of one
+        // property. The key should be built from ids like getNodeId rather than addresses,
+        // which can be reused by another node once one is removed.
+        static CustomCommand* create(std::function<void()> execute, std::function<void()> undo, const std::string& mergeKey = std::string());
+        static CustomCommand* deserialize(const cocos2d::ValueMap& source);
+
+        // Describes what the functions do as the properties of a group before and after the
+        // command, so it can be serialized. The group is the one of the node with the id from
+        // getNodeId, or the one of its component if named. Properties with the same value in
+        // both are left out.
+        void setProperties(const std::string& nodeId, const std::string& component, cocos2d::ValueMap before, cocos2d::ValueMap after);
 
     private:
+        // Deserializes the properties into the group found by id
+        static void applyProperties(const std::string& nodeId, const std::string& component, const cocos2d::ValueMap& properties);
+
         std::function<void()> _execute;
         std::function<void()> _undo;
+        std::string _mergeKey;
+
+        // Empty without properties
+        std::string _nodeId;
+        std::string _component;
+        cocos2d::ValueMap _before;
+        cocos2d::ValueMap _after;
     };
 }
 
@@ -1,15 +1,47 @@
 #include "RemoveNode.h"
+#include "Editor.h"
+#include "NodeImDrawer.h"
 
 namespace CCImEditor
 {
+    namespace
+    {
+        // Same rough measure as Command::getNodeMemorySize, for the nodes described
+        size_t getDescriptionMemorySize(const cocos2d::ValueMap& description)
+        {
+            size_t size = 2048;
+            cocos2d::ValueMap::const_iterator childrenIt = description.find("children");
+            if (childrenIt != description.end() && childrenIt->second.getType() == cocos2d::Value::Type::VECTOR)
+            {
+                for (const cocos2d::Value& child : childrenIt->second.asValueVector())
+                {
+                    if (child.getType() == cocos2d::Value::Type::MAP)
+                        size += getDescriptionMemorySize(child.asValueMap());
+                }
+            }
+
+            return size;
+        }
+    }
+
     void RemoveNode::undo()
     {
+        if (!resolve())
+            return;
+
         _parent->addChild(_child);
+        NodeImDrawer::setChildrenDirty(_parent);
+        Editor::getInstance()->getEventBus().publish(EditorEvents::NodeAdded{_child, _parent});
     }
 
     void RemoveNode::execute()
     {
+        if (!_child)
+            return;
+
         _child->removeFromParent();
+        NodeImDrawer::setChildrenDirty(_parent);
+        Editor::getInstance()->getEventBus().publish(EditorEvents::NodeRemoved{_child, _parent});
     }
 
     RemoveNode* RemoveNode::create(cocos2d::Node* node)
@@ -20,6 +52,7 @@ namespace CCImEditor
             {
                 command->_parent = node->getParent();
                 command->_child = node;
+                command->_memorySize = sizeof(RemoveNode) + getNodeMemorySize(node);
                 command->autorelease();
                 return command;
             }
@@ -27,4 +60,62 @@ namespace CCImEditor
 
         return nullptr;
     }
+
+    // The child is out of the scene once the command is done, nothing edits it until it is
+    // undone, so it is only described when the command is serialized
+    bool RemoveNode::serialize(cocos2d::ValueMap& target) const
+    {
+        const std::string parentId = _parent ? getNodeId(_parent) : _parentId;
+        if (parentId.empty())
+            return false;
+
+        cocos2d::ValueMap description;
+        if (_child ? !Editor::saveNode(_child, description) : _description.empty())
+            return false;
+
+        target["type"] = "RemoveNode";
+        target["parent"] = parentId;
+        target["node"] = _child ? std::move(description) : _description;
+        return true;
+    }
+
+    RemoveNode* RemoveNode::deserialize(const cocos2d::ValueMap& source)
+    {
+        cocos2d::ValueMap::const_iterator parentIt = source.find("parent");
+        cocos2d::ValueMap::const_iterator nodeIt = source.find("node");
+        if (parentIt == source.end() || nodeIt == source.end() || nodeIt->second.getType() != cocos2d::Value::Type::MAP)
+            return nullptr;
+
+        if (RemoveNode* command = new (std::nothrow)RemoveNode())
+        {
+            command->_parentId = parentIt->second.asString();
+            command->_description = nodeIt->second.asValueMap();
+            command->_memorySize = sizeof(RemoveNode) + getDescriptionMemorySize(command->_description);
+            command->autorelease();
+            return command;
+        }
+
+        return nullptr;
+    }
+
+    bool RemoveNode::resolve()
+    {
+        if (_child)
+            return true;
+
+        cocos2d::Node* parent = findNode(_parentId);
+        cocos2d::Node* child = parent ? Editor::loadNode(_description) : nullptr;
+        if (!child)
+        {
+            CCLOGWARN("Failed to restore the node removed from %s", _parentId.c_str());
+            return false;
+        }
+
+        _parent = parent;
+        _child = child;
+        _memorySize = sizeof(RemoveNode) + getNodeMemorySize(child);
+        _parentId.clear();
+        _description.clear();
+        return true;
+    }
 }
@@ -10,11 +10,24 @@ namespace CCImEditor
     public:
         void undo() override;
         void execute() override;
+        size_t getMemorySize() const override { return _memorySize; };
+        bool serialize(cocos2d::ValueMap& target) const override;
         static RemoveNode* create(cocos2d::Node* node);
+        static RemoveNode* deserialize(const cocos2d::ValueMap& source);
 
     private:
+        // Creates the child of a command read back from its description, finds the parent by id
+        bool resolve();
+
         cocos2d::RefPtr<cocos2d::Node> _parent;
         cocos2d::RefPtr<cocos2d::Node> _child;
+        size_t _memorySize = 0; // with the subtree, as it was when removed
+
+        // Only until a command read back has found its parent
+        std::string _parentId;
+
+        // What a command read back creates the child from, until it has
+        cocos2d::ValueMap _description;
     };
 }
 
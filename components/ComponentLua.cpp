@@ -18,7 +18,7 @@ namespace CCImEditor
             },
             owner);
 
-        if (_context == Context::DRAW)
+        if (getContext() == Context::DRAW)
             reloadIfModified();
     }
 
@@ -26,25 +26,21 @@ namespace CCImEditor
     {
         cocos2d::FileUtils* fileUtils = cocos2d::FileUtils::getInstance();
         cocos2d::ComponentLua* component = static_cast<cocos2d::ComponentLua*>(getOwner());
-        auto it = _customValue.find("Script");
-        if (it != _customValue.end())
+        std::string filePath;
+        if (getCustomValue<FilePath>("Script", filePath))
         {
-            std::string filePath;
-            if (CCImEditor::PropertyImDrawer<FilePath>::deserialize(it->second, filePath))
+            if (!fileUtils->isAbsolutePath(filePath))
             {
-                if (!fileUtils->isAbsolutePath(filePath))
-                {
-                    filePath = fileUtils->fullPathForFilename(filePath);
-                }
+                filePath = fileUtils->fullPathForFilename(filePath);
+            }
 
-                if (fileUtils->isFileExist(filePath))
+            if (fileUtils->isFileExist(filePath))
+            {
+                struct stat st;
+                if (stat(filePath.c_str(), &st) == 0 && st.st_mtime > _loadTime)
                 {
-                    struct stat st;
-                    if (stat(filePath.c_str(), &st) == 0 && st.st_mtime > _loadTime)
-                    {
-                        component->loadAndExecuteScript(filePath);
-                        _loadTime = time(nullptr);
-                    }
+                    component->loadAndExecuteScript(filePath);
+                    _loadTime = time(nullptr);
                 }
             }
         }
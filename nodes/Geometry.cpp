@@ -15,7 +15,7 @@ namespace CCImEditor
 
         property<FilePath>("Material", 
             DefaultGetter<std::string>(),
-            [this] (cocos2d::Sprite3D* node, const std::string& filePath)
+            [] (cocos2d::Sprite3D* node, const std::string& filePath)
             {
                 if (cocos2d::Material* material = cocos2d::Material::createWithFilename(filePath))
                 {
@@ -9,6 +9,9 @@ namespace CCImEditor
     {
     public:
         void draw() override;
+
+        // getContentSize updates the layout of the label, which creates textures
+        bool hasThreadSafeGetters() const override {return false;}
     };
 }
 
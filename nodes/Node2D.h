@@ -9,6 +9,10 @@ namespace CCImEditor
     {
     public:
         void draw() override;
+
+        // Node and Sprite getters only read fields. Derived types with getters which do
+        // more, e.g. lay out their content on demand like Label, must return false.
+        bool hasThreadSafeGetters() const override {return true;}
     };
 }
 
@@ -9,6 +9,10 @@ namespace CCImEditor
     {
     public:
         void draw() override;
+
+        // Also true for Sprite3D, Geometry, Skybox and the lights, override it in types
+        // whose getters compute or cache values
+        bool hasThreadSafeGetters() const override {return true;}
     };
 }
 
@@ -14,7 +14,7 @@ namespace CCImEditor
 
         property<FilePath>("Model", 
             DefaultGetter<std::string>(),
-            [this] (cocos2d::Sprite3D* node, const std::string& filePath)
+            [] (cocos2d::Sprite3D* node, const std::string& filePath)
             {
                 cocos2d::Vec3 position = node->getPosition3D();
                 cocos2d::Quaternion rotation = node->getRotationQuat();
@@ -35,7 +35,7 @@ namespace CCImEditor
             std::string matName = cocos2d::StringUtils::format("Material (%zd)###Material.%zd", i, i);
             property<FilePath>(matName.c_str(), 
             DefaultGetter<std::string>(),
-            [this, i] (cocos2d::Sprite3D* node, const std::string& filePath)
+            [i] (cocos2d::Sprite3D* node, const std::string& filePath)
             {
                 if (cocos2d::Material* material = cocos2d::Material::createWithFilename(filePath))
                 {
@@ -47,7 +47,7 @@ namespace CCImEditor
             std::string texName = cocos2d::StringUtils::format("Texture (%zd)###Texture.%zd", i, i);
             property<FilePath>(texName.c_str(), 
             DefaultGetter<std::string>(),
-            [this, i] (cocos2d::Sprite3D* node, const std::string& filePath)
+            [i] (cocos2d::Sprite3D* node, const std::string& filePath)
             {
                 node->getMeshByIndex(i)->setTexture(filePath);
             },
@@ -55,11 +55,11 @@ namespace CCImEditor
 
             std::string transparentName = cocos2d::StringUtils::format("Transparent (%zd)###Transparent.%zd", i, i);
             property(transparentName.c_str(), 
-            [this, i] (cocos2d::Sprite3D* node) -> bool
+            [i] (cocos2d::Sprite3D* node) -> bool
             {
                 return node->getMeshByIndex(i)->isTransparent();
             },
-            [this, i] (cocos2d::Sprite3D* node, bool isTransparent)
+            [i] (cocos2d::Sprite3D* node, bool isTransparent)
             {
                 node->getMeshByIndex(i)->setTransparent(isTransparent);
             },
@@ -9,6 +9,9 @@ namespace CCImEditor
     {
     public:
         void draw() override;
+
+        // Material, texture and transparency are declared per mesh of the model
+        bool hasStaticProperties() const override {return false;}
     };
 }
 
@@ -0,0 +1,161 @@
+#include "AnimationPlayer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace CCImEditor
+{
+    const std::string AnimationPlayer::COMPONENT_NAME = "CCImEditor.AnimationPlayer";
+
+    bool AnimationPlayer::init()
+    {
+        if (!cocos2d::Component::init())
+            return false;
+
+        setName(COMPONENT_NAME);
+        return true;
+    }
+
+    void AnimationPlayer::play(const std::string& animation, AnimationWrapMode wrapMode)
+    {
+        std::unordered_map<std::string, Clip>::const_iterator it = _clips.find(animation);
+        if (it == _clips.end())
+        {
+            CCLOGWARN("No animation %s to play", animation.c_str());
+            return;
+        }
+
+        _clip = &it->second;
+        _animationName = animation;
+        _wrapMode = wrapMode;
+        _isPlaying = true;
+        _elapsed = 0.0f;
+        _currentFrame = wrapMode == AnimationWrapMode::Reverse || wrapMode == AnimationWrapMode::ReverseLoop ? _clip->_maxFrame : 0;
+        _sampledFrame = -1;
+        sample();
+    }
+
+    void AnimationPlayer::stop()
+    {
+        if (!_clip)
+            return;
+
+        _isPlaying = false;
+        _currentFrame = 0;
+        sample();
+    }
+
+    std::vector<std::string> AnimationPlayer::getAnimationNames() const
+    {
+        std::vector<std::string> names;
+        names.reserve(_clips.size());
+        for (const auto& [name, clip] : _clips)
+        {
+            names.push_back(name);
+        }
+
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+
+    void AnimationPlayer::addTrack(const std::string& animation, cocos2d::Ref* target, const RuntimeProperty& property, std::vector<std::pair<int, cocos2d::Value>>&& keys)
+    {
+        if (keys.empty())
+            return;
+
+        Track track;
+        track._target = target;
+        track._property = property;
+        track._keys = std::move(keys);
+        _clips[animation]._tracks.push_back(std::move(track));
+    }
+
+    void AnimationPlayer::setTiming(const std::string& animation, int maxFrame, int samples)
+    {
+        Clip& clip = _clips[animation];
+        clip._maxFrame = maxFrame;
+        clip._samples = samples;
+    }
+
+    void AnimationPlayer::update(float dt)
+    {
+        if (!_isPlaying || !_clip || _clip->_samples <= 0)
+            return;
+
+        const float secondPerFrame = 1.0f / _clip->_samples;
+        const int maxFrame = _clip->_maxFrame;
+
+        _elapsed += dt;
+        int df = static_cast<int>(std::abs(_elapsed / secondPerFrame));
+        switch (_wrapMode)
+        {
+        case AnimationWrapMode::Normal:
+            _currentFrame += df;
+            if (_currentFrame > maxFrame)
+                _currentFrame = maxFrame;
+            break;
+        case AnimationWrapMode::Loop:
+            _currentFrame += df;
+            if (_currentFrame > maxFrame)
+                _currentFrame = 0;
+            break;
+        case AnimationWrapMode::Reverse:
+            _currentFrame -= df;
+            if (_currentFrame < 0)
+                _currentFrame = 0;
+            break;
+        case AnimationWrapMode::ReverseLoop:
+            _currentFrame -= df;
+            if (_currentFrame < 0)
+                _currentFrame = maxFrame;
+            break;
+        }
+
+        _elapsed -= (df * secondPerFrame);
+        sample();
+    }
+
+    // Same keyframe lookup as the SAMPLE context of ImPropertyGroup::property, values are only
+    // set again when the frame changed
+    void AnimationPlayer::sample()
+    {
+        if (!_clip || _sampledFrame == _currentFrame)
+            return;
+
+        _sampledFrame = _currentFrame;
+        for (const Track& track : _clip->_tracks)
+        {
+            cocos2d::Ref* target = track._target.get();
+            if (!target)
+                continue;
+
+            std::vector<std::pair<int, cocos2d::Value>>::const_iterator it1 = std::upper_bound(track._keys.begin(), track._keys.end(), _currentFrame,
+                [](int frame, const std::pair<int, cocos2d::Value>& key)
+                {
+                    return frame < key.first;
+                });
+
+            if (it1 == track._keys.begin())
+            {
+                track._property._set(target, it1->second);
+            }
+            else if (it1 == track._keys.end())
+            {
+                track._property._set(target, std::prev(it1)->second);
+            }
+            else
+            {
+                std::vector<std::pair<int, cocos2d::Value>>::const_iterator it0 = std::prev(it1);
+                if (track._property._lerp)
+                {
+                    const float offset = (float)(_currentFrame - it0->first) / (it1->first - it0->first);
+                    track._property._lerp(target, it0->second, it1->second, offset);
+                }
+                else
+                {
+                    track._property._set(target, it0->second);
+                }
+            }
+        }
+    }
+}
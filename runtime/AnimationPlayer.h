@@ -0,0 +1,71 @@
+#ifndef __CCIMEDITOR_ANIMATIONPLAYER_H__
+#define __CCIMEDITOR_ANIMATIONPLAYER_H__
+
+#include "cocos2d.h"
+#include "AnimationWrapMode.h"
+#include "runtime/RuntimeProperty.h"
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace CCImEditor
+{
+    // Plays the animations of a scene loaded by SceneLoader. It is added to the root of the
+    // scene only when the scene has animations, and steps frames like NodeImDrawer::update.
+    // Each track holds the keyframes of one property of one node or component.
+    class AnimationPlayer : public cocos2d::Component
+    {
+    public:
+        static const std::string COMPONENT_NAME;
+
+        CREATE_FUNC(AnimationPlayer);
+
+        void play(const std::string& animation, AnimationWrapMode wrapMode = AnimationWrapMode::Normal);
+
+        // Leaves the animated values at the first frame
+        void stop();
+
+        bool isPlaying() const { return _isPlaying; };
+        const std::string& getAnimationName() const { return _animationName; };
+        int getCurrentFrame() const { return _currentFrame; };
+        std::vector<std::string> getAnimationNames() const;
+
+        // Used by SceneLoader
+        void addTrack(const std::string& animation, cocos2d::Ref* target, const RuntimeProperty& property, std::vector<std::pair<int, cocos2d::Value>>&& keys);
+        void setTiming(const std::string& animation, int maxFrame, int samples);
+        bool hasAnimations() const { return !_clips.empty(); };
+
+        void update(float dt) override;
+
+    private:
+        bool init() override;
+        void sample();
+
+        struct Track
+        {
+            cocos2d::WeakPtr<cocos2d::Ref> _target;
+            RuntimeProperty _property;
+            std::vector<std::pair<int, cocos2d::Value>> _keys;
+        };
+
+        struct Clip
+        {
+            int _maxFrame = 30;
+            int _samples = 30;
+            std::vector<Track> _tracks;
+        };
+
+        std::unordered_map<std::string, Clip> _clips;
+        const Clip* _clip = nullptr;
+        std::string _animationName;
+        AnimationWrapMode _wrapMode = AnimationWrapMode::Normal;
+        bool _isPlaying = false;
+        int _currentFrame = 0;
+        int _sampledFrame = -1;
+        float _elapsed = 0.0f;
+    };
+}
+
+#endif
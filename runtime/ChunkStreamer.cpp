@@ -0,0 +1,246 @@
+#include "ChunkStreamer.h"
+#include "SceneLoader.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace CCImEditor
+{
+    namespace
+    {
+        bool readVec3(const cocos2d::ValueMap& source, const char* key, cocos2d::Vec3& vec)
+        {
+            cocos2d::ValueMap::const_iterator it = source.find(key);
+            if (it == source.end() || it->second.getType() != cocos2d::Value::Type::VECTOR || it->second.asValueVector().size() < 3)
+                return false;
+
+            const cocos2d::ValueVector& v = it->second.asValueVector();
+            vec.set(v[0].asFloat(), v[1].asFloat(), v[2].asFloat());
+            return true;
+        }
+
+        float getDistance(const cocos2d::Vec3& point, const cocos2d::AABB& bounds)
+        {
+            const cocos2d::Vec3 closest(
+                std::min(std::max(point.x, bounds._min.x), bounds._max.x),
+                std::min(std::max(point.y, bounds._min.y), bounds._max.y),
+                std::min(std::max(point.z, bounds._min.z), bounds._max.z));
+            return point.distance(closest);
+        }
+    }
+
+    const std::string ChunkStreamer::COMPONENT_NAME = "CCImEditor.ChunkStreamer";
+
+    bool ChunkStreamer::init()
+    {
+        if (!cocos2d::Component::init())
+            return false;
+
+        setName(COMPONENT_NAME);
+        return true;
+    }
+
+    bool ChunkStreamer::setManifest(const cocos2d::ValueMap& manifest, const std::string& directory)
+    {
+        for (Chunk& chunk : _chunks)
+        {
+            unload(chunk);
+        }
+
+        _chunks.clear();
+
+        cocos2d::ValueMap::const_iterator chunkSizeIt = manifest.find("chunkSize");
+        if (chunkSizeIt != manifest.end() && chunkSizeIt->second.asFloat() > 0.0f)
+            setDistances(chunkSizeIt->second.asFloat(), chunkSizeIt->second.asFloat() * 1.5f);
+
+        cocos2d::ValueMap::const_iterator chunksIt = manifest.find("chunks");
+        if (chunksIt == manifest.end() || chunksIt->second.getType() != cocos2d::Value::Type::VECTOR)
+            return false;
+
+        cocos2d::FileUtils* fileUtils = cocos2d::FileUtils::getInstance();
+        for (const cocos2d::Value& chunkVal : chunksIt->second.asValueVector())
+        {
+            if (chunkVal.getType() != cocos2d::Value::Type::MAP)
+                continue;
+
+            const cocos2d::ValueMap& chunkMap = chunkVal.asValueMap();
+            cocos2d::ValueMap::const_iterator fileIt = chunkMap.find("file");
+            Chunk chunk;
+            if (fileIt == chunkMap.end() || fileIt->second.getType() != cocos2d::Value::Type::STRING ||
+                !readVec3(chunkMap, "min", chunk._bounds._min) || !readVec3(chunkMap, "max", chunk._bounds._max))
+            {
+                CCLOGWARN("Invalid chunk in manifest");
+                continue;
+            }
+
+            chunk._fullPath = fileUtils->fullPathForFilename(directory + fileIt->second.asString());
+            if (chunk._fullPath.empty())
+            {
+                CCLOGWARN("Failed to find chunk %s", fileIt->second.asString().c_str());
+                chunk._state = State::FAILED;
+            }
+
+            _chunks.push_back(std::move(chunk));
+        }
+
+        return true;
+    }
+
+    void ChunkStreamer::setDistances(float loadDistance, float unloadDistance)
+    {
+        _loadDistance = loadDistance;
+        _unloadDistance = std::max(loadDistance, unloadDistance);
+    }
+
+    size_t ChunkStreamer::getLoadedCount() const
+    {
+        return std::count_if(_chunks.begin(), _chunks.end(), [](const Chunk& chunk)
+        {
+            return chunk._state == State::LOADED;
+        });
+    }
+
+    // Position of the camera in the space of the owner, which the bounds are in
+    bool ChunkStreamer::getFocus(cocos2d::Vec3& focus) const
+    {
+        cocos2d::Node* owner = getOwner();
+        cocos2d::Camera* camera = _camera.get();
+        if (!camera)
+            camera = cocos2d::Camera::getDefaultCamera();
+
+        if (!owner || !camera)
+            return false;
+
+        camera->getNodeToWorldTransform().getTranslation(&focus);
+        owner->getWorldToNodeTransform().transformPoint(&focus);
+        return true;
+    }
+
+    void ChunkStreamer::update(float dt)
+    {
+        cocos2d::Vec3 focus;
+        if (!getFocus(focus))
+            return;
+
+        const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + _timeBudget;
+        for (Chunk& chunk : _chunks)
+        {
+            if (chunk._state == State::FAILED)
+                continue;
+
+            const float distance = getDistance(focus, chunk._bounds);
+            if (chunk._state == State::UNLOADED ? distance > _loadDistance : distance > _unloadDistance)
+                unload(chunk);
+            else
+                load(chunk, deadline);
+        }
+    }
+
+    // Moves the chunk one step further, each step returns at once if its work is not done
+    void ChunkStreamer::load(Chunk& chunk, std::chrono::steady_clock::time_point deadline)
+    {
+        switch (chunk._state)
+        {
+        case State::UNLOADED:
+            chunk._description = std::make_shared<cocos2d::ValueMap>();
+            chunk._result = Internal::ThreadPool::getInstance()->enqueue([fullPath = chunk._fullPath, description = chunk._description]()
+            {
+                return PrefabCache::decodeFile(fullPath, *description);
+            });
+            chunk._state = State::DECODING;
+            break;
+        case State::DECODING:
+        {
+            if (chunk._result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                break;
+
+            if (!chunk._result.get())
+            {
+                CCLOGWARN("Failed to load chunk %s", chunk._fullPath.c_str());
+                chunk._description.reset();
+                chunk._state = State::FAILED;
+                break;
+            }
+
+            std::vector<std::string> prefabFiles;
+            PrefabCache::collectFiles(*chunk._description, prefabFiles);
+            chunk._preload.reset(new PrefabCache::Preload(prefabFiles));
+            chunk._state = State::PRELOADING;
+            break;
+        }
+        case State::PRELOADING:
+            if (!chunk._preload->update())
+                break;
+
+            chunk._preload.reset();
+            chunk._state = State::INSTANTIATING;
+            break;
+        case State::INSTANTIATING:
+        {
+            if (!chunk._node)
+            {
+                if (std::chrono::steady_clock::now() >= deadline)
+                    break;
+
+                cocos2d::ValueMap::iterator childrenIt = chunk._description->find("children");
+                if (childrenIt != chunk._description->end() && childrenIt->second.getType() == cocos2d::Value::Type::VECTOR)
+                {
+                    chunk._children = std::move(childrenIt->second.asValueVector());
+                    chunk._description->erase(childrenIt);
+                }
+
+                chunk._node = SceneLoader::getInstance()->create(*chunk._description);
+                chunk._description.reset();
+                chunk._nextChild = 0;
+                if (!chunk._node)
+                {
+                    CCLOGWARN("Failed to load chunk %s", chunk._fullPath.c_str());
+                    chunk._children.clear();
+                    chunk._state = State::FAILED;
+                    break;
+                }
+            }
+
+            while (chunk._nextChild < chunk._children.size() && std::chrono::steady_clock::now() < deadline)
+            {
+                const cocos2d::Value& childVal = chunk._children[chunk._nextChild++];
+                if (childVal.getType() != cocos2d::Value::Type::MAP)
+                    continue;
+
+                if (cocos2d::Node* child = SceneLoader::getInstance()->create(childVal.asValueMap()))
+                    chunk._node->addChild(child);
+            }
+
+            // Added once complete, so that a chunk does not show up piece by piece
+            if (chunk._nextChild >= chunk._children.size())
+            {
+                chunk._children.clear();
+                getOwner()->addChild(chunk._node);
+                chunk._state = State::LOADED;
+            }
+            break;
+        }
+        case State::LOADED:
+        case State::FAILED:
+            break;
+        }
+    }
+
+    // Jobs still running finish in the background, their results are dropped
+    void ChunkStreamer::unload(Chunk& chunk)
+    {
+        if (chunk._state == State::UNLOADED || chunk._state == State::FAILED)
+            return;
+
+        if (chunk._node && chunk._node->getParent())
+            chunk._node->removeFromParent();
+
+        chunk._node = nullptr;
+        chunk._description.reset();
+        chunk._result = std::future<bool>();
+        chunk._preload.reset();
+        chunk._children.clear();
+        chunk._nextChild = 0;
+        chunk._state = State::UNLOADED;
+    }
+}
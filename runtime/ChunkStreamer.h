@@ -0,0 +1,82 @@
+#ifndef __CCIMEDITOR_CHUNKSTREAMER_H__
+#define __CCIMEDITOR_CHUNKSTREAMER_H__
+
+#include "cocos2d.h"
+#include "PrefabCache.h"
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace CCImEditor
+{
+    // Loads the chunks written by ChunkExporter around the camera and unloads those left
+    // behind. SceneLoader adds it to the root of a manifest. Files are decoded on the worker
+    // threads, and nodes are created on the main thread within a time budget per frame, one
+    // child of a chunk root at a time. Prefabs of unloaded chunks stay in PrefabCache only
+    // up to its size limit.
+    class ChunkStreamer : public cocos2d::Component
+    {
+    public:
+        static const std::string COMPONENT_NAME;
+
+        CREATE_FUNC(ChunkStreamer);
+
+        // Reads the "chunks" of a manifest, their files are relative to directory
+        bool setManifest(const cocos2d::ValueMap& manifest, const std::string& directory);
+
+        // The default camera of the running scene is used if none is set
+        void setCamera(cocos2d::Camera* camera) { _camera = camera; };
+
+        // Chunks closer to the camera than the load distance are loaded, those farther than
+        // the unload distance are unloaded. Both default to the chunk size and 1.5 times it.
+        void setDistances(float loadDistance, float unloadDistance);
+        void setTimeBudget(std::chrono::microseconds timeBudget) { _timeBudget = timeBudget; };
+
+        size_t getChunkCount() const { return _chunks.size(); };
+        size_t getLoadedCount() const;
+
+        void update(float dt) override;
+
+    private:
+        bool init() override;
+        bool getFocus(cocos2d::Vec3& focus) const;
+
+        enum class State
+        {
+            UNLOADED,
+            DECODING,
+            PRELOADING,
+            INSTANTIATING,
+            LOADED,
+            FAILED,
+        };
+
+        struct Chunk
+        {
+            std::string _fullPath;
+            cocos2d::AABB _bounds;
+            State _state = State::UNLOADED;
+
+            std::shared_ptr<cocos2d::ValueMap> _description;
+            std::future<bool> _result;
+            std::unique_ptr<PrefabCache::Preload> _preload;
+            cocos2d::ValueVector _children;
+            size_t _nextChild = 0;
+            cocos2d::RefPtr<cocos2d::Node> _node;
+        };
+
+        void load(Chunk& chunk, std::chrono::steady_clock::time_point deadline);
+        void unload(Chunk& chunk);
+
+        std::vector<Chunk> _chunks;
+        cocos2d::WeakPtr<cocos2d::Camera> _camera;
+        float _loadDistance = 1000.0f;
+        float _unloadDistance = 1500.0f;
+        std::chrono::microseconds _timeBudget = std::chrono::microseconds(4000);
+    };
+}
+
+#endif
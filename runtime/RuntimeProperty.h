@@ -0,0 +1,502 @@
+#ifndef __CCIMEDITOR_RUNTIMEPROPERTY_H__
+#define __CCIMEDITOR_RUNTIMEPROPERTY_H__
+
+#include "cocos2d.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <string>
+#include <type_traits>
+
+namespace CCImEditor
+{
+    namespace Internal
+    {
+        inline bool isNumber(const cocos2d::Value& value)
+        {
+            switch (value.getType())
+            {
+            case cocos2d::Value::Type::BYTE:
+            case cocos2d::Value::Type::INTEGER:
+            case cocos2d::Value::Type::UNSIGNED:
+            case cocos2d::Value::Type::FLOAT:
+            case cocos2d::Value::Type::DOUBLE:
+            case cocos2d::Value::Type::BOOLEAN:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        inline const cocos2d::ValueVector* getValueVector(const cocos2d::Value& source, size_t size)
+        {
+            if (source.getType() != cocos2d::Value::Type::VECTOR || source.asValueVector().size() < size)
+                return nullptr;
+
+            return &source.asValueVector();
+        }
+
+        inline const cocos2d::ValueVector* getNumbers(const cocos2d::Value& value, size_t count)
+        {
+            if (value.getType() != cocos2d::Value::Type::VECTOR || value.asValueVector().size() != count)
+                return nullptr;
+
+            const cocos2d::ValueVector& v = value.asValueVector();
+            return std::all_of(v.begin(), v.end(), isNumber) ? &v : nullptr;
+        }
+
+        // Literals of generated C++ (see SceneCompiler) are empty for values they can not represent
+
+        inline std::string stringLiteral(const std::string& value)
+        {
+            std::string literal = "\"";
+            for (char c : value)
+            {
+                switch (c)
+                {
+                case '"': literal += "\\\""; break;
+                case '\\': literal += "\\\\"; break;
+                case '\n': literal += "\\n"; break;
+                case '\r': literal += "\\r"; break;
+                case '\t': literal += "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20)
+                        literal += cocos2d::StringUtils::format("\\%03o", static_cast<unsigned char>(c));
+                    else
+                        literal += c;
+                    break;
+                }
+            }
+
+            return literal + "\"";
+        }
+
+        inline std::string floatLiteral(const cocos2d::Value& value)
+        {
+            if (!isNumber(value) || !std::isfinite(value.asFloat()))
+                return std::string();
+
+            std::string literal = cocos2d::StringUtils::format("%.9g", value.asFloat());
+            if (literal.find_first_of(".e") == std::string::npos)
+                literal += ".0";
+            return literal + "f";
+        }
+
+        inline std::string floatsLiteral(const cocos2d::Value& value, const char* type, size_t count)
+        {
+            const cocos2d::ValueVector* v = getNumbers(value, count);
+            if (!v)
+                return std::string();
+
+            std::string literal = type;
+            for (size_t i = 0; i < count; i++)
+            {
+                const std::string element = floatLiteral((*v)[i]);
+                if (element.empty())
+                    return std::string();
+
+                literal += (i == 0 ? "(" : ", ") + element;
+            }
+
+            return literal + ")";
+        }
+    }
+
+    // Reads the values written by PropertyImDrawer<T>::serialize, without ImGui or magic_enum.
+    // Values of another shape are rejected instead of asserting, files may come from anywhere.
+    // literal writes a value as C++ for SceneCompiler.
+    template <typename T, typename = void>
+    struct RuntimeValue
+    {
+        static constexpr bool isInterpolated = false;
+    };
+
+    template <>
+    struct RuntimeValue<bool>
+    {
+        static constexpr bool isInterpolated = false;
+
+        static bool read(const cocos2d::Value& source, bool& v)
+        {
+            v = source.asBool();
+            return true;
+        }
+
+        static std::string literal(const cocos2d::Value& source)
+        {
+            return Internal::isNumber(source) ? (source.asBool() ? "true" : "false") : std::string();
+        }
+    };
+
+    template <>
+    struct RuntimeValue<int>
+    {
+        static constexpr bool isInterpolated = true;
+
+        static bool read(const cocos2d::Value& source, int& v)
+        {
+            v = source.asInt();
+            return true;
+        }
+
+        static std::string literal(const cocos2d::Value& source)
+        {
+            return Internal::isNumber(source) ? cocos2d::StringUtils::format("%d", source.asInt()) : std::string();
+        }
+
+        static int lerp(int v1, int v2, float t)
+        {
+            return (int)(v1 + (v2 - v1) * t);
+        }
+    };
+
+    // Masks are stored as unsigned integers
+    template <typename T>
+    struct RuntimeValue<T, std::enable_if_t<std::is_unsigned_v<T> && !std::is_same_v<T, bool>>>
+    {
+        static constexpr bool isInterpolated = false;
+
+        static bool read(const cocos2d::Value& source, T& v)
+        {
+            v = (T)source.asUnsignedInt();
+            return true;
+        }
+
+        static std::string literal(const cocos2d::Value& source)
+        {
+            return Internal::isNumber(source) ? cocos2d::StringUtils::format("%uu", static_cast<unsigned int>((T)source.asUnsignedInt())) : std::string();
+        }
+    };
+
+    template <typename T>
+    struct RuntimeValue<T, std::enable_if_t<std::is_enum_v<T>>>
+    {
+        static constexpr bool isInterpolated = false;
+
+        static bool read(const cocos2d::Value& source, T& v)
+        {
+            v = static_cast<T>(source.asInt());
+            return true;
+        }
+
+        // The statement casts it to the enum, whose name is not known here
+        static std::string literal(const cocos2d::Value& source)
+        {
+            return Internal::isNumber(source) ? cocos2d::StringUtils::format("%d", source.asInt()) : std::string();
+        }
+    };
+
+    // Degrees are stored in radians, so they are floats too
+    template <>
+    struct RuntimeValue<float>
+    {
+        static constexpr bool isInterpolated = true;
+
+        static bool read(const cocos2d::Value& source, float& v)
+        {
+            v = source.asFloat();
+            return true;
+        }
+
+        static std::string literal(const cocos2d::Value& source)
+        {
+            return Internal::floatLiteral(source);
+        }
+
+        static float lerp(float v1, float v2, float t)
+        {
+            return v1 + (v2 - v1) * t;
+        }
+    };
+
+    template <>
+    struct RuntimeValue<std::string>
+    {
+        static constexpr bool isInterpolated = false;
+
+        static bool read(const cocos2d::Value& source, std::string& v)
+        {
+            v = source.asString();
+            return true;
+        }
+
+        static std::string literal(const cocos2d::Value& source)
+        {
+            return source.getType() == cocos2d::Value::Type::STRING ? Internal::stringLiteral(source.asString()) : std::string();
+        }
+    };
+
+    template <>
+    struct RuntimeValue<cocos2d::Vec2>
+    {
+        static constexpr bool isInterpolated = true;
+
+        static bool read(const cocos2d::Value& source, cocos2d::Vec2& vec)
+        {
+            const cocos2d::ValueVector* v = Internal::getValueVector(source, 2);
+            if (!v)
+                return false;
+
+            vec.x = (*v)[0].asFloat();
+            vec.y = (*v)[1].asFloat();
+            return true;
+        }
+
+        static std::string literal(const cocos2d::Value& source)
+        {
+            return Internal::floatsLiteral(source, "cocos2d::Vec2", 2);
+        }
+
+        static cocos2d::Vec2 lerp(const cocos2d::Vec2& v1, const cocos2d::Vec2& v2, float t)
+        {
+            return v1.lerp(v2, t);
+        }
+    };
+
+    template <>
+    struct RuntimeValue<cocos2d::Size>
+    {
+        static constexpr bool isInterpolated = true;
+
+        static bool read(const cocos2d::Value& source, cocos2d::Size& size)
+        {
+            const cocos2d::ValueVector* v = Internal::getValueVector(source, 2);
+            if (!v)
+                return false;
+
+            size.width = (*v)[0].asFloat();
+            size.height = (*v)[1].asFloat();
+            return true;
+        }
+
+        static std::string literal(const cocos2d::Value& source)
+        {
+            return Internal::floatsLiteral(source, "cocos2d::Size", 2);
+        }
+
+        static cocos2d::Size lerp(const cocos2d::Size& v1, const cocos2d::Size& v2, float t)
+        {
+            return cocos2d::Size(v1.width + (v2.width - v1.width) * t, v1.height + (v2.height - v1.height) * t);
+        }
+    };
+
+    template <>
+    struct RuntimeValue<cocos2d::Vec3>
+    {
+        static constexpr bool isInterpolated = true;
+
+        static bool read(const cocos2d::Value& source, cocos2d::Vec3& vec)
+        {
+            const cocos2d::ValueVector* v = Internal::getValueVector(source, 3);
+            if (!v)
+                return false;
+
+            vec.x = (*v)[0].asFloat();
+            vec.y = (*v)[1].asFloat();
+            vec.z = (*v)[2].asFloat();
+            return true;
+        }
+
+        static std::string literal(const cocos2d::Value& source)
+        {
+            return Internal::floatsLiteral(source, "cocos2d::Vec3", 3);
+        }
+
+        static cocos2d::Vec3 lerp(const cocos2d::Vec3& v1, const cocos2d::Vec3& v2, float t)
+        {
+            return v1.lerp(v2, t);
+        }
+    };
+
+    template <>
+    struct RuntimeValue<cocos2d::Color3B>
+    {
+        static constexpr bool isInterpolated = true;
+
+        static bool read(const cocos2d::Value& source, cocos2d::Color3B& color)
+        {
+            const cocos2d::ValueVector* v = Internal::getValueVector(source, 3);
+            if (!v)
+                return false;
+
+            color.r = (*v)[0].asByte();
+            color.g = (*v)[1].asByte();
+            color.b = (*v)[2].asByte();
+            return true;
+        }
+
+        static std::string literal(const cocos2d::Value& source)
+        {
+            const cocos2d::ValueVector* v = Internal::getNumbers(source, 3);
+            if (!v)
+                return std::string();
+
+            return cocos2d::StringUtils::format("cocos2d::Color3B(%d, %d, %d)", (*v)[0].asByte(), (*v)[1].asByte(), (*v)[2].asByte());
+        }
+
+        static cocos2d::Color3B lerp(const cocos2d::Color3B& v1, const cocos2d::Color3B& v2, float t)
+        {
+            cocos2d::Color3B o;
+            o.r = (GLubyte)(v1.r + (v2.r - v1.r) * t);
+            o.g = (GLubyte)(v1.g + (v2.g - v1.g) * t);
+            o.b = (GLubyte)(v1.b + (v2.b - v1.b) * t);
+            return o;
+        }
+    };
+
+    template <>
+    struct RuntimeValue<cocos2d::Color4B>
+    {
+        static constexpr bool isInterpolated = true;
+
+        static bool read(const cocos2d::Value& source, cocos2d::Color4B& color)
+        {
+            const cocos2d::ValueVector* v = Internal::getValueVector(source, 4);
+            if (!v)
+                return false;
+
+            color.r = (*v)[0].asByte();
+            color.g = (*v)[1].asByte();
+            color.b = (*v)[2].asByte();
+            color.a = (*v)[3].asByte();
+            return true;
+        }
+
+        static std::string literal(const cocos2d::Value& source)
+        {
+            const cocos2d::ValueVector* v = Internal::getNumbers(source, 4);
+            if (!v)
+                return std::string();
+
+            return cocos2d::StringUtils::format("cocos2d::Color4B(%d, %d, %d, %d)", (*v)[0].asByte(), (*v)[1].asByte(), (*v)[2].asByte(), (*v)[3].asByte());
+        }
+
+        static cocos2d::Color4B lerp(const cocos2d::Color4B& v1, const cocos2d::Color4B& v2, float t)
+        {
+            cocos2d::Color4B o;
+            o.r = (GLubyte)(v1.r + (v2.r - v1.r) * t);
+            o.g = (GLubyte)(v1.g + (v2.g - v1.g) * t);
+            o.b = (GLubyte)(v1.b + (v2.b - v1.b) * t);
+            o.a = (GLubyte)(v1.a + (v2.a - v1.a) * t);
+            return o;
+        }
+    };
+
+    template <>
+    struct RuntimeValue<cocos2d::BlendFunc>
+    {
+        static constexpr bool isInterpolated = false;
+
+        static bool read(const cocos2d::Value& source, cocos2d::BlendFunc& func)
+        {
+            const cocos2d::ValueVector* v = Internal::getValueVector(source, 2);
+            if (!v)
+                return false;
+
+            func.src = (*v)[0].asUnsignedInt();
+            func.dst = (*v)[1].asUnsignedInt();
+            return true;
+        }
+
+        static std::string literal(const cocos2d::Value& source)
+        {
+            const cocos2d::ValueVector* v = Internal::getNumbers(source, 2);
+            if (!v)
+                return std::string();
+
+            return cocos2d::StringUtils::format("cocos2d::BlendFunc{%uu, %uu}", (*v)[0].asUnsignedInt(), (*v)[1].asUnsignedInt());
+        }
+    };
+
+    // A setter of a node or component type, keyed like the property() call it mirrors.
+    // SceneLoader applies it, SceneCompiler writes code as its statement, with $ for the
+    // variable of the owner and % for the literal of the value, so both use one table.
+    // lerp is only set for the types the editor interpolates between keyframes.
+    struct RuntimeProperty
+    {
+        std::string _key;
+        std::function<void(cocos2d::Ref* owner, const cocos2d::Value& value)> _set;
+        std::function<void(cocos2d::Ref* owner, const cocos2d::Value& v0, const cocos2d::Value& v1, float t)> _lerp;
+
+        std::string _code;
+        std::function<std::string(const cocos2d::Value& value)> _literal;
+
+        // Empty paths name no file, they are not set
+        bool _isFile = false;
+
+        // Statement setting the value on variable, false if the value can not be written as C++.
+        // Empty for an empty path.
+        bool compile(const std::string& variable, const cocos2d::Value& value, std::string& statement) const
+        {
+            statement.clear();
+            if (_isFile && value.getType() == cocos2d::Value::Type::STRING && value.asString().empty())
+                return true;
+
+            const std::string literal = _literal && !_code.empty() ? _literal(value) : std::string();
+            if (literal.empty())
+                return false;
+
+            for (char c : _code)
+            {
+                if (c == '$')
+                    statement += variable;
+                else if (c == '%')
+                    statement += literal;
+                else
+                    statement += c;
+            }
+            return true;
+        }
+    };
+
+    template <typename T, typename Owner, typename Setter>
+    RuntimeProperty makeRuntimeProperty(const char* key, Setter setter, const char* code)
+    {
+        RuntimeProperty property;
+        property._key = key;
+        property._code = code;
+        property._literal = RuntimeValue<T>::literal;
+        property._set = [setter](cocos2d::Ref* owner, const cocos2d::Value& value)
+        {
+            T v;
+            if (RuntimeValue<T>::read(value, v))
+                std::invoke(setter, static_cast<Owner*>(owner), v);
+        };
+
+        if constexpr (RuntimeValue<T>::isInterpolated)
+        {
+            property._lerp = [setter](cocos2d::Ref* owner, const cocos2d::Value& v0, const cocos2d::Value& v1, float t)
+            {
+                T value0;
+                T value1;
+                if (RuntimeValue<T>::read(v0, value0) && RuntimeValue<T>::read(v1, value1))
+                    std::invoke(setter, static_cast<Owner*>(owner), RuntimeValue<T>::lerp(value0, value1, t));
+            };
+        }
+
+        return property;
+    }
+
+    // The value type is deduced from the argument of a member setter
+    template <typename Owner, typename Arg>
+    RuntimeProperty makeRuntimeProperty(const char* key, void (Owner::*setter)(Arg), const char* code)
+    {
+        return makeRuntimeProperty<std::remove_cv_t<std::remove_reference_t<Arg>>, Owner>(key, setter, code);
+    }
+
+    // A path to a file, the setter is not called for an empty one
+    template <typename Owner, typename Setter>
+    RuntimeProperty makeRuntimeFileProperty(const char* key, Setter setter, const char* code)
+    {
+        RuntimeProperty property = makeRuntimeProperty<std::string, Owner>(key, [setter](Owner* owner, const std::string& path)
+        {
+            if (!path.empty())
+                std::invoke(setter, owner, path);
+        }, code);
+        property._isFile = true;
+        return property;
+    }
+}
+
+#endif
@@ -0,0 +1,557 @@
+#include "SceneLoader.h"
+#include "AnimationPlayer.h"
+#include "ChunkStreamer.h"
+#include "NodeProxies.h"
+#include "PrefabCache.h"
+#if CCIME_LUA_ENGINE
+#include "cocos/scripting/lua-bindings/manual/CCComponentLua.h"
+#endif
+
+#include <algorithm>
+#include <map>
+
+using namespace cocos2d;
+
+namespace CCImEditor
+{
+    namespace
+    {
+        // Set by the camera mask setters of the editor for its own camera
+        const unsigned short s_editorCameraMask = 1 << 15;
+
+        const ValueMap s_emptyMap;
+
+        std::string getString(const ValueMap& source, const std::string& key)
+        {
+            ValueMap::const_iterator it = source.find(key);
+            return it != source.end() && it->second.getType() == Value::Type::STRING ? it->second.asString() : std::string();
+        }
+
+        const ValueMap& getMap(const ValueMap& source, const std::string& key)
+        {
+            ValueMap::const_iterator it = source.find(key);
+            return it != source.end() && it->second.getType() == Value::Type::MAP ? it->second.asValueMap() : s_emptyMap;
+        }
+
+        void setCameraMask(Node* node, unsigned short cameraMask)
+        {
+            node->setCameraMask(cameraMask & ~s_editorCameraMask);
+        }
+
+        // nodes/Node2D.cpp
+        std::vector<RuntimeProperty> getNode2DProperties()
+        {
+            return {
+                makeRuntimeProperty("Name", &Node::setName, "$->setName(%);"),
+                makeRuntimeProperty("Position", static_cast<void(Node::*)(const Vec2&)>(&Node::setPosition), "$->setPosition(%);"),
+                makeRuntimeProperty("ContentSize", &Node::setContentSize, "$->setContentSize(%);"),
+                makeRuntimeProperty("AnchorPoint", &Node::setAnchorPoint, "$->setAnchorPoint(%);"),
+                makeRuntimeProperty<Vec2, Node>("Scale", [](Node* node, const Vec2& scale)
+                {
+                    node->setScaleX(scale.x);
+                    node->setScaleY(scale.y);
+                }, "{ const cocos2d::Vec2 scale = %; $->setScaleX(scale.x); $->setScaleY(scale.y); }"),
+                makeRuntimeProperty("Rotation", &Node::setRotation, "$->setRotation(%);"),
+                makeRuntimeProperty<Vec2, Node>("Skew", [](Node* node, const Vec2& skew)
+                {
+                    node->setSkewX(skew.x);
+                    node->setSkewY(skew.y);
+                }, "{ const cocos2d::Vec2 skew = %; $->setSkewX(skew.x); $->setSkewY(skew.y); }"),
+                makeRuntimeProperty("Tag", &Node::setTag, "$->setTag(%);"),
+                makeRuntimeProperty("LocalZOrder", &Node::setLocalZOrder, "$->setLocalZOrder(%);"),
+                makeRuntimeProperty("Visible", &Node::setVisible, "$->setVisible(%);"),
+                makeRuntimeProperty<unsigned short, Node>("CameraMask", setCameraMask, "$->setCameraMask(static_cast<unsigned short>(% & ~(1u << 15)));"),
+                makeRuntimeProperty<Color4B, Node>("Color", [](Node* node, const Color4B& color)
+                {
+                    node->setColor(Color3B(color.r, color.g, color.b));
+                    node->setOpacity(color.a);
+                }, "{ const cocos2d::Color4B color = %; $->setColor(cocos2d::Color3B(color)); $->setOpacity(color.a); }"),
+                makeRuntimeProperty("CascadeColorEnabled", &Node::setCascadeColorEnabled, "$->setCascadeColorEnabled(%);"),
+                makeRuntimeProperty("CascadeOpacityEnabled", &Node::setCascadeOpacityEnabled, "$->setCascadeOpacityEnabled(%);"),
+                makeRuntimeProperty("OpacityModifyRGB", &Node::setOpacityModifyRGB, "$->setOpacityModifyRGB(%);"),
+            };
+        }
+
+        // nodes/Node3D.cpp
+        std::vector<RuntimeProperty> getNode3DProperties()
+        {
+            return {
+                makeRuntimeProperty("Name", &Node::setName, "$->setName(%);"),
+                makeRuntimeProperty("Position", &Node::setPosition3D, "$->setPosition3D(%);"),
+                makeRuntimeProperty("Rotation", &Node::setRotation3D, "$->setRotation3D(%);"),
+                makeRuntimeProperty("Scale", &Node::setScale3D, "$->setScale3D(%);"),
+                makeRuntimeProperty("Tag", &Node::setTag, "$->setTag(%);"),
+                makeRuntimeProperty("Visible", &Node::setVisible, "$->setVisible(%);"),
+                makeRuntimeProperty<unsigned short, Node>("CameraMask", setCameraMask, "$->setCameraMask(static_cast<unsigned short>(% & ~(1u << 15)));"),
+            };
+        }
+
+        // nodes/Sprite.cpp
+        void appendSpriteProperties(std::vector<RuntimeProperty>& properties)
+        {
+            properties.push_back(makeRuntimeFileProperty<Sprite>("Texture", static_cast<void(Sprite::*)(const std::string&)>(&Sprite::setTexture), "$->setTexture(%);"));
+            properties.push_back(makeRuntimeProperty("BlendFunc", &Sprite::setBlendFunc, "$->setBlendFunc(%);"));
+            properties.push_back(makeRuntimeProperty("FlippedX", &Sprite::setFlippedX, "$->setFlippedX(%);"));
+        }
+
+        // nodes/Label.cpp
+        void appendLabelProperties(std::vector<RuntimeProperty>& properties)
+        {
+            properties.push_back(makeRuntimeProperty("String", &Label::setString, "$->setString(%);"));
+            properties.push_back(makeRuntimeProperty<Size, Label>("Dimensions", [](Label* label, const Size& size)
+            {
+                label->setDimensions(size.width, size.height);
+            }, "{ const cocos2d::Size dimensions = %; $->setDimensions(dimensions.width, dimensions.height); }"));
+            properties.push_back(makeRuntimeProperty("HAlign", &Label::setHorizontalAlignment, "$->setHorizontalAlignment(static_cast<cocos2d::TextHAlignment>(%));"));
+            properties.push_back(makeRuntimeProperty("VAlign", &Label::setVerticalAlignment, "$->setVerticalAlignment(static_cast<cocos2d::TextVAlignment>(%));"));
+            properties.push_back(makeRuntimeFileProperty<Label>("FontName", &Label::setSystemFontName, "$->setSystemFontName(%);"));
+            properties.push_back(makeRuntimeProperty("FontSize", &Label::setSystemFontSize, "$->setSystemFontSize(%);"));
+            properties.push_back(makeRuntimeProperty("Overflow", &Label::setOverflow, "$->setOverflow(static_cast<cocos2d::Label::Overflow>(%));"));
+        }
+
+        void appendShadowProperties(std::vector<RuntimeProperty>& properties)
+        {
+            properties.push_back(makeRuntimeProperty<unsigned int, Sprite3D>("LightMask", &Sprite3D::setLightMask, "$->setLightMask(%);"));
+            properties.push_back(makeRuntimeProperty("CastShadow", &Sprite3D::setCastShadow, "$->setCastShadow(%);"));
+            properties.push_back(makeRuntimeProperty("RecieveShadow", &Sprite3D::setRecieveShadow, "$->setRecieveShadow(%);"));
+        }
+
+        // nodes/Sprite3D.cpp, the mesh properties are applied by applySprite3DMeshes.
+        // Compiled scenes load the model in the constructor, the property has no statement.
+        void appendSprite3DProperties(std::vector<RuntimeProperty>& properties)
+        {
+            properties.push_back(makeRuntimeFileProperty<Sprite3D>("Model", [](Sprite3D* node, const std::string& filePath)
+            {
+                Vec3 position = node->getPosition3D();
+                Quaternion rotation = node->getRotationQuat();
+                Vec3 scale = {node->getScaleX(), node->getScaleY(), node->getScaleZ()};
+
+                node->removeAllChildren();
+                node->initWithFile(filePath);
+
+                // initWithFile may have changed position, rotation and scale. Set them back.
+                node->setPosition3D(position);
+                node->setRotationQuat(rotation);
+                node->setScale3D(scale);
+            }, ""));
+            appendShadowProperties(properties);
+        }
+
+        void applySprite3DMeshes(Node* owner, const ValueMap& properties)
+        {
+            Sprite3D* node = static_cast<Sprite3D*>(owner);
+            for (ssize_t i = 0; i < node->getMeshCount(); ++i)
+            {
+                const std::string material = getString(properties, StringUtils::format("Material.%zd", i));
+                if (!material.empty())
+                {
+                    if (Material* created = Material::createWithFilename(material))
+                        node->setMaterial(created, i);
+                }
+
+                const std::string texture = getString(properties, StringUtils::format("Texture.%zd", i));
+                if (!texture.empty())
+                    node->getMeshByIndex(i)->setTexture(texture);
+
+                ValueMap::const_iterator transparentIt = properties.find(StringUtils::format("Transparent.%zd", i));
+                if (transparentIt != properties.end())
+                    node->getMeshByIndex(i)->setTransparent(transparentIt->second.asBool());
+            }
+        }
+
+        // nodes/Geometry.cpp
+        void appendGeometryProperties(std::vector<RuntimeProperty>& properties)
+        {
+            properties.push_back(makeRuntimeFileProperty<Sprite3D>("Material", [](Sprite3D* node, const std::string& filePath)
+            {
+                if (Material* material = Material::createWithFilename(filePath))
+                    node->setMaterial(material);
+            }, "if (cocos2d::Material* material = cocos2d::Material::createWithFilename(%)) $->setMaterial(material);"));
+            properties.push_back(makeRuntimeFileProperty<Sprite3D>("Texture", static_cast<void(Sprite3D::*)(const std::string&)>(&Sprite3D::setTexture), "$->setTexture(%);"));
+            appendShadowProperties(properties);
+        }
+
+        // nodes/Skybox.cpp
+        void applySkybox(Node* owner, const ValueMap& properties)
+        {
+            const std::string front = getString(properties, "Front");
+            const std::string back = getString(properties, "Back");
+            const std::string up = getString(properties, "Up");
+            const std::string down = getString(properties, "Down");
+            const std::string right = getString(properties, "Right");
+            const std::string left = getString(properties, "Left");
+            if (front.empty() && back.empty() && up.empty() && down.empty() && right.empty() && left.empty())
+                return;
+
+            if (TextureCube* texture = TextureCube::create(left, right, up, down, front, back))
+                static_cast<Skybox*>(owner)->setTexture(texture);
+        }
+
+        // nodes/BaseLight.cpp
+        void appendBaseLightProperties(std::vector<RuntimeProperty>& properties)
+        {
+            properties.push_back(makeRuntimeProperty("Enabled", &BaseLight::setEnabled, "$->setEnabled(%);"));
+            properties.push_back(makeRuntimeProperty("LightFlag", &BaseLight::setLightFlag, "$->setLightFlag(static_cast<cocos2d::LightFlag>(%));"));
+            properties.push_back(makeRuntimeProperty("Color", &BaseLight::setColor, "$->setColor(%);"));
+            properties.push_back(makeRuntimeProperty("Intensity", &BaseLight::setIntensity, "$->setIntensity(%);"));
+        }
+
+        template <class Constructor>
+        SceneLoader::NodeType makeNodeType(std::vector<RuntimeProperty>&& properties, std::function<void(Node*, const ValueMap&)> apply = nullptr)
+        {
+            SceneLoader::NodeType type;
+            type._create = []() -> Node* { return Constructor::create(); };
+            type._properties = std::move(properties);
+            type._apply = std::move(apply);
+            return type;
+        }
+    }
+
+    struct SceneLoader::Context
+    {
+        RefPtr<AnimationPlayer> _player;
+
+        // Prefabs being instantiated, to stop on files which instantiate themselves
+        std::unordered_set<std::string> _files;
+
+        // maxFrame and samples of an animation are those of the first node which has it,
+        // like AnimationPlayer::play on the root does in the editor
+        std::unordered_map<std::string, std::pair<int, int>> _timings;
+        std::unordered_set<std::string> _timedAnimations;
+
+        AnimationPlayer* getPlayer()
+        {
+            if (!_player)
+                _player = AnimationPlayer::create();
+
+            return _player.get();
+        }
+    };
+
+    SceneLoader* SceneLoader::getInstance()
+    {
+        static SceneLoader instance;
+        return &instance;
+    }
+
+    // Same types as Editor::registerNodes and Editor::registerComponents
+    SceneLoader::SceneLoader()
+    {
+        std::vector<RuntimeProperty> properties;
+
+        registerNode("CCImEditor.Node2D", makeNodeType<Node>(getNode2DProperties()));
+
+        properties = getNode2DProperties();
+        appendSpriteProperties(properties);
+        registerNode("CCImEditor.Sprite", makeNodeType<Sprite>(std::move(properties)));
+
+        properties = getNode2DProperties();
+        appendLabelProperties(properties);
+        registerNode("CCImEditor.Label", makeNodeType<Label>(std::move(properties)));
+
+        registerNode("CCImEditor.Node3D", makeNodeType<Node>(getNode3DProperties()));
+
+        properties = getNode3DProperties();
+        appendSprite3DProperties(properties);
+        registerNode("CCImEditor.Sprite3D", makeNodeType<Sprite3D>(std::move(properties), applySprite3DMeshes));
+
+        properties = getNode3DProperties();
+        appendGeometryProperties(properties);
+        registerNode("CCImEditor.Quad", makeNodeType<QuadProxy>(std::vector<RuntimeProperty>(properties)));
+        registerNode("CCImEditor.Cube", makeNodeType<CubeProxy>(std::move(properties)));
+
+        registerNode("CCImEditor.Skybox", makeNodeType<Skybox>(getNode3DProperties(), applySkybox));
+
+        properties = getNode3DProperties();
+        appendBaseLightProperties(properties);
+        registerNode("CCImEditor.AmbientLight", makeNodeType<AmbientLightProxy>(std::vector<RuntimeProperty>(properties)));
+
+        std::vector<RuntimeProperty> directionLight = properties;
+        directionLight.push_back(makeRuntimeProperty("CastShadow", &DirectionLight::setCastShadow, "$->setCastShadow(%);"));
+        directionLight.push_back(makeRuntimeProperty("ShadowMapSize", &DirectionLight::setShadowMapSize, "$->setShadowMapSize(%);"));
+        directionLight.push_back(makeRuntimeProperty("ShadowBias", &DirectionLight::setShadowBias, "$->setShadowBias(%);"));
+        registerNode("CCImEditor.DirectionLight", makeNodeType<DirectionLightProxy>(std::move(directionLight)));
+
+        std::vector<RuntimeProperty> pointLight = properties;
+        pointLight.push_back(makeRuntimeProperty("Range", &PointLight::setRange, "$->setRange(%);"));
+        registerNode("CCImEditor.PointLight", makeNodeType<PointLightProxy>(std::move(pointLight)));
+
+        // Angles are stored in radians
+        std::vector<RuntimeProperty> spotLight = std::move(properties);
+        spotLight.push_back(makeRuntimeProperty("InnerAngle", &SpotLight::setInnerAngle, "$->setInnerAngle(%);"));
+        spotLight.push_back(makeRuntimeProperty("OuterAngle", &SpotLight::setOuterAngle, "$->setOuterAngle(%);"));
+        spotLight.push_back(makeRuntimeProperty("Range", &SpotLight::setRange, "$->setRange(%);"));
+        registerNode("CCImEditor.SpotLight", makeNodeType<SpotLightProxy>(std::move(spotLight)));
+
+#if CCIME_LUA_ENGINE
+        ComponentType componentLua;
+        componentLua._create = []() -> cocos2d::Component* { return cocos2d::ComponentLua::create(); };
+        componentLua._properties.push_back(makeRuntimeProperty<std::string, cocos2d::ComponentLua>("Script", &cocos2d::ComponentLua::loadAndExecuteScript, ""));
+        registerComponent("CCImEditor.ComponentLua", std::move(componentLua));
+#endif
+    }
+
+    void SceneLoader::registerNode(const std::string& name, NodeType type)
+    {
+        _nodeTypes[name] = std::move(type);
+    }
+
+    void SceneLoader::registerComponent(const std::string& name, ComponentType type)
+    {
+        _componentTypes[name] = std::move(type);
+    }
+
+    const SceneLoader::NodeType* SceneLoader::getNodeType(const std::string& name) const
+    {
+        std::unordered_map<std::string, NodeType>::const_iterator it = _nodeTypes.find(name);
+        return it != _nodeTypes.end() ? &it->second : nullptr;
+    }
+
+    const SceneLoader::ComponentType* SceneLoader::getComponentType(const std::string& name) const
+    {
+        std::unordered_map<std::string, ComponentType>::const_iterator it = _componentTypes.find(name);
+        return it != _componentTypes.end() ? &it->second : nullptr;
+    }
+
+    Node* SceneLoader::load(const std::string& file)
+    {
+        const std::string fullPath = FileUtils::getInstance()->fullPathForFilename(file);
+        ValueMap description;
+        if (fullPath.empty() || !PrefabCache::decodeFile(fullPath, description))
+        {
+            CCLOGWARN("Failed to load file %s", file.c_str());
+            return nullptr;
+        }
+
+        const size_t slash = file.find_last_of("/\\");
+        return create(description, slash != std::string::npos ? file.substr(0, slash + 1) : std::string());
+    }
+
+    Node* SceneLoader::create(const ValueMap& description, const std::string& directory)
+    {
+        Context context;
+        Node* node = createNode(description, context);
+        if (!node)
+            return nullptr;
+
+        if (context._player && context._player->hasAnimations())
+            node->addComponent(context._player.get());
+
+        if (description.count("chunks") > 0)
+        {
+            ChunkStreamer* streamer = ChunkStreamer::create();
+            if (streamer->setManifest(description, directory))
+                node->addComponent(streamer);
+        }
+
+        return node;
+    }
+
+    AnimationPlayer* SceneLoader::getAnimationPlayer(Node* root)
+    {
+        return root ? dynamic_cast<AnimationPlayer*>(root->getComponent(AnimationPlayer::COMPONENT_NAME)) : nullptr;
+    }
+
+    Node* SceneLoader::createNode(const ValueMap& description, Context& context)
+    {
+        const std::string type = getString(description, "type");
+        std::unordered_map<std::string, NodeType>::const_iterator typeIt = _nodeTypes.find(type);
+        if (typeIt == _nodeTypes.end())
+        {
+            CCLOGWARN("Unknown node type %s, skipped", type.c_str());
+            return nullptr;
+        }
+
+        // Prefab instances are their prefab with the values of the instance over it.
+        // layers goes from the innermost prefab to the instance.
+        std::vector<std::shared_ptr<const ValueMap>> prefabs;
+        std::vector<const ValueMap*> layers = {&description};
+        std::vector<std::string> files;
+        for (std::string file = getString(description, "file"); !file.empty(); file = getString(*layers.front(), "file"))
+        {
+            const std::string fullPath = FileUtils::getInstance()->fullPathForFilename(file);
+            if (context._files.count(fullPath) > 0)
+            {
+                CCLOGWARN("%s instantiates itself", file.c_str());
+                break;
+            }
+
+            std::shared_ptr<const ValueMap> prefab = fullPath.empty() ? nullptr : PrefabCache::getInstance()->getDescription(fullPath);
+            if (!prefab)
+            {
+                CCLOGWARN("Failed to load file %s", file.c_str());
+                break;
+            }
+
+            if (getString(*prefab, "type") != type)
+            {
+                CCLOGWARN("Types do not match when loading %s, discard", file.c_str());
+                break;
+            }
+
+            context._files.insert(fullPath);
+            files.push_back(fullPath);
+            layers.insert(layers.begin(), prefab.get());
+            prefabs.push_back(std::move(prefab));
+        }
+
+        Node* node = typeIt->second._create();
+        if (node)
+        {
+            const NodeType& nodeType = typeIt->second;
+            ValueMap merged;
+            const ValueMap* properties = &getMap(description, "properties");
+            if (layers.size() > 1)
+            {
+                for (std::vector<const ValueMap*>::const_reverse_iterator it = layers.rbegin(); it != layers.rend(); ++it)
+                {
+                    for (const auto& [key, value] : getMap(**it, "properties"))
+                    {
+                        merged.emplace(key, value);
+                    }
+                }
+
+                properties = &merged;
+            }
+
+            for (const RuntimeProperty& property : nodeType._properties)
+            {
+                ValueMap::const_iterator it = properties->find(property._key);
+                if (it != properties->end())
+                    property._set(node, it->second);
+            }
+
+            if (nodeType._apply)
+                nodeType._apply(node, *properties);
+
+            std::map<std::string, const ValueMap*> components;
+            for (const ValueMap* layer : layers)
+            {
+                for (const auto& [name, component] : getMap(*layer, "components"))
+                {
+                    if (component.getType() == Value::Type::MAP)
+                        components[name] = &component.asValueMap();
+                }
+            }
+
+            context._timings.clear();
+            for (const auto& [name, component] : components)
+            {
+                addComponent(node, name, *component, context);
+            }
+
+            for (const ValueMap* layer : layers)
+            {
+                addTracks(getMap(*layer, "animations"), node, nodeType._properties, true, context);
+            }
+
+            for (const auto& [name, timing] : context._timings)
+            {
+                if (context._timedAnimations.insert(name).second)
+                    context.getPlayer()->setTiming(name, timing.first, timing.second);
+            }
+
+            for (const ValueMap* layer : layers)
+            {
+                ValueMap::const_iterator childrenIt = layer->find("children");
+                if (childrenIt == layer->end() || childrenIt->second.getType() != Value::Type::VECTOR)
+                    continue;
+
+                for (const Value& child : childrenIt->second.asValueVector())
+                {
+                    if (child.getType() != Value::Type::MAP)
+                        continue;
+
+                    if (Node* childNode = createNode(child.asValueMap(), context))
+                        node->addChild(childNode);
+                }
+            }
+        }
+
+        for (const std::string& fullPath : files)
+        {
+            context._files.erase(fullPath);
+        }
+
+        return node;
+    }
+
+    void SceneLoader::addComponent(Node* node, const std::string& name, const ValueMap& description, Context& context)
+    {
+        const std::string type = getString(description, "type");
+        std::unordered_map<std::string, ComponentType>::const_iterator typeIt = _componentTypes.find(type);
+        if (typeIt == _componentTypes.end())
+        {
+            CCLOGWARN("Unknown component type %s, skipped", type.c_str());
+            return;
+        }
+
+        cocos2d::Component* component = typeIt->second._create();
+        if (!component)
+            return;
+
+        component->setName(name);
+        const ValueMap& properties = getMap(description, "properties");
+        for (const RuntimeProperty& property : typeIt->second._properties)
+        {
+            ValueMap::const_iterator it = properties.find(property._key);
+            if (it != properties.end())
+                property._set(component, it->second);
+        }
+
+        node->addComponent(component);
+        addTracks(getMap(description, "animations"), component, typeIt->second._properties, false, context);
+    }
+
+    // Keyframes of properties the type has no setter for are dropped, as the editor does
+    void SceneLoader::addTracks(const ValueMap& animations, Ref* target, const std::vector<RuntimeProperty>& properties, bool overrideTiming, Context& context)
+    {
+        for (const auto& [animationName, animationVal] : animations)
+        {
+            if (animationVal.getType() != Value::Type::MAP)
+                continue;
+
+            const ValueMap& animationRoot = animationVal.asValueMap();
+            std::pair<int, int> timing(30, 30);
+            ValueMap::const_iterator maxFrameIt = animationRoot.find("maxFrame");
+            if (maxFrameIt != animationRoot.end())
+                timing.first = maxFrameIt->second.asInt();
+
+            ValueMap::const_iterator samplesIt = animationRoot.find("samples");
+            if (samplesIt != animationRoot.end())
+                timing.second = samplesIt->second.asInt();
+
+            if (overrideTiming)
+                context._timings[animationName] = timing;
+            else
+                context._timings.emplace(animationName, timing);
+
+            for (const auto& [propertyName, propertyVals] : getMap(animationRoot, "values"))
+            {
+                std::vector<RuntimeProperty>::const_iterator propertyIt = std::find_if(properties.begin(), properties.end(), [&propertyName](const RuntimeProperty& property)
+                {
+                    return property._key == propertyName;
+                });
+
+                if (propertyIt == properties.end() || propertyVals.getType() != Value::Type::VECTOR)
+                    continue;
+
+                std::map<int, Value> frames;
+                for (const Value& propertyVal : propertyVals.asValueVector())
+                {
+                    if (propertyVal.getType() != Value::Type::MAP)
+                        continue;
+
+                    const ValueMap& propertyValMap = propertyVal.asValueMap();
+                    ValueMap::const_iterator frameIt = propertyValMap.find("frame");
+                    ValueMap::const_iterator valueIt = propertyValMap.find("value");
+                    if (frameIt != propertyValMap.end() && valueIt != propertyValMap.end())
+                        frames[frameIt->second.asInt()] = valueIt->second;
+                }
+
+                std::vector<std::pair<int, Value>> keys(std::make_move_iterator(frames.begin()), std::make_move_iterator(frames.end()));
+                context.getPlayer()->addTrack(animationName, target, *propertyIt, std::move(keys));
+            }
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef __CCIMEDITOR_SCENELOADER_H__
+#define __CCIMEDITOR_SCENELOADER_H__
+
+#include "cocos2d.h"
+#include "runtime/RuntimeProperty.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace CCImEditor
+{
+    class AnimationPlayer;
+
+    // Loads the files saved by the editor into plain cocos nodes, for games which do not link
+    // the editor. Nodes get no NodeImDrawer or property groups: each registered type is a
+    // constructor and the setters bound by the property() calls of its editor counterpart,
+    // applied in the same order. Animations are played by an AnimationPlayer on the root.
+    //
+    //   cocos2d::Node* node = CCImEditor::SceneLoader::getInstance()->load("menu.json");
+    //   if (CCImEditor::AnimationPlayer* player = CCImEditor::SceneLoader::getAnimationPlayer(node))
+    //       player->play("Intro");
+    //
+    // Node types registered by the game with NodeFactory need to be registered here as well,
+    // unknown types are loaded as cocos2d::Node.
+    class SceneLoader
+    {
+    public:
+        static SceneLoader* getInstance();
+
+        struct NodeType
+        {
+            std::function<cocos2d::Node*()> _create;
+            std::vector<RuntimeProperty> _properties;
+
+            // Properties the table can not express, e.g. one per mesh. Called after the table.
+            std::function<void(cocos2d::Node*, const cocos2d::ValueMap&)> _apply;
+        };
+
+        struct ComponentType
+        {
+            std::function<cocos2d::Component*()> _create;
+            std::vector<RuntimeProperty> _properties;
+        };
+
+        void registerNode(const std::string& name, NodeType type);
+        void registerComponent(const std::string& name, ComponentType type);
+
+        // nullptr for types which are not registered. SceneCompiler writes scenes from the
+        // same properties, and the editor checks its property tables against them.
+        const NodeType* getNodeType(const std::string& name) const;
+        const ComponentType* getComponentType(const std::string& name) const;
+
+        // Returns an autoreleased node, or nullptr if the file can not be loaded.
+        // Manifests of chunks (see ChunkExporter) get a ChunkStreamer on their root,
+        // their chunk files are relative to directory.
+        cocos2d::Node* load(const std::string& file);
+        cocos2d::Node* create(const cocos2d::ValueMap& description, const std::string& directory = "");
+
+        static AnimationPlayer* getAnimationPlayer(cocos2d::Node* root);
+
+    private:
+        SceneLoader();
+
+        struct Context;
+        cocos2d::Node* createNode(const cocos2d::ValueMap& description, Context& context);
+        void addComponent(cocos2d::Node* node, const std::string& name, const cocos2d::ValueMap& description, Context& context);
+        static void addTracks(const cocos2d::ValueMap& animations, cocos2d::Ref* target, const std::vector<RuntimeProperty>& properties, bool overrideTiming, Context& context);
+
+        std::unordered_map<std::string, NodeType> _nodeTypes;
+        std::unordered_map<std::string, ComponentType> _componentTypes;
+    };
+}
+
+#endif
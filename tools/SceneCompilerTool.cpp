@@ -0,0 +1,45 @@
+// Command line scene compiler, usable without the editor, e.g. as a build step.
+//
+//   cc_imgui_editor_compile <scene> <output directory> [<name>]
+//
+// Writes <name>.h, <name>.cpp and <name>.cmake to the output directory, <name> defaults
+// to the name of the scene file. What could not be compiled is printed to stderr.
+// The exit code is 0 on success and 1 on errors.
+
+#include "SceneCompiler.h"
+#include "PrefabCache.h"
+
+#include <cstdio>
+
+int main(int argc, char** argv)
+{
+    if (argc != 3 && argc != 4)
+    {
+        fprintf(stderr, "usage: cc_imgui_editor_compile <scene> <output directory> [<name>]\n");
+        return 1;
+    }
+
+    const std::string fullPath = cocos2d::FileUtils::getInstance()->fullPathForFilename(argv[1]);
+    cocos2d::ValueMap description;
+    if (fullPath.empty() || !CCImEditor::PrefabCache::decodeFile(fullPath, description))
+    {
+        fprintf(stderr, "Failed to load %s\n", argv[1]);
+        return 1;
+    }
+
+    const std::string name = argc == 4 ? argv[3] : CCImEditor::SceneCompiler::getName(argv[1]);
+    std::vector<std::string> report;
+    const bool compiled = CCImEditor::SceneCompiler::compileToDirectory(description, argv[1], argv[2], name, report);
+    for (const std::string& line : report)
+    {
+        fprintf(stderr, "%s\n", line.c_str());
+    }
+
+    if (!compiled)
+    {
+        fprintf(stderr, "Failed to compile %s\n", argv[1]);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+// Command line diff and three-way merge of scene files, usable without the editor.
+//
+//   cc_imgui_editor_merge diff <base> <other>
+//   cc_imgui_editor_merge merge <base> <ours> <theirs> [<output>]
+//
+// merge writes to ours unless an output is given, so it can be set as a git merge driver:
+//
+//   [merge "ccscene"]
+//       driver = cc_imgui_editor_merge merge %O %A %B
+//
+// The exit code is 0 on success, 1 if there are changes (diff) or conflicts (merge)
+// and 2 on errors.
+
+#include "SceneMerge.h"
+#include "SceneWriter.h"
+#include "PrefabCache.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    bool load(const char* file, cocos2d::ValueMap& out)
+    {
+        const std::string fullPath = cocos2d::FileUtils::getInstance()->fullPathForFilename(file);
+        if (fullPath.empty() || !CCImEditor::PrefabCache::decodeFile(fullPath, out))
+        {
+            fprintf(stderr, "Failed to load %s\n", file);
+            return false;
+        }
+
+        return true;
+    }
+
+    int usage()
+    {
+        fprintf(stderr, "usage: cc_imgui_editor_merge diff <base> <other>\n");
+        fprintf(stderr, "       cc_imgui_editor_merge merge <base> <ours> <theirs> [<output>]\n");
+        return 2;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc == 4 && strcmp(argv[1], "diff") == 0)
+    {
+        cocos2d::ValueMap base;
+        cocos2d::ValueMap other;
+        if (!load(argv[2], base) || !load(argv[3], other))
+            return 2;
+
+        std::vector<CCImEditor::SceneMerge::Change> changes;
+        CCImEditor::SceneMerge::diff(base, other, changes);
+        for (const CCImEditor::SceneMerge::Change& change : changes)
+        {
+            printf("%s\n", CCImEditor::SceneMerge::toString(change).c_str());
+        }
+
+        return changes.empty() ? 0 : 1;
+    }
+
+    if ((argc == 5 || argc == 6) && strcmp(argv[1], "merge") == 0)
+    {
+        cocos2d::ValueMap base;
+        cocos2d::ValueMap ours;
+        cocos2d::ValueMap theirs;
+        if (!load(argv[2], base) || !load(argv[3], ours) || !load(argv[4], theirs))
+            return 2;
+
+        cocos2d::ValueMap merged;
+        std::vector<CCImEditor::SceneMerge::Conflict> conflicts;
+        CCImEditor::SceneMerge::merge(base, ours, theirs, merged, conflicts);
+        for (const CCImEditor::SceneMerge::Conflict& conflict : conflicts)
+        {
+            fprintf(stderr, "Conflict: %s\n", CCImEditor::SceneMerge::toString(conflict).c_str());
+        }
+
+        const char* output = argc == 6 ? argv[5] : argv[3];
+        if (!CCImEditor::SceneWriter::writeFile(output, merged, false))
+        {
+            fprintf(stderr, "Failed to write %s\n", output);
+            return 2;
+        }
+
+        return conflicts.empty() ? 0 : 1;
+    }
+
+    return usage();
+}
@@ -103,6 +103,22 @@ namespace CCImEditor
         }
     }
 
+    bool Animation::init(const RegisteredType* type, const std::string& windowName)
+    {
+        if (!Widget::init(type, windowName))
+            return false;
+
+        EventBus& eventBus = Editor::getInstance()->getEventBus();
+        _subscriptions.push_back(eventBus.subscribe<EditorEvents::EditingNodeChanged>([this](const EditorEvents::EditingNodeChanged&) { _isDirty = true; }));
+        _subscriptions.push_back(eventBus.subscribe<EditorEvents::NodeAdded>([this](const EditorEvents::NodeAdded&) { _isDirty = true; }));
+        _subscriptions.push_back(eventBus.subscribe<EditorEvents::NodeRemoved>([this](const EditorEvents::NodeRemoved&) { _isDirty = true; }));
+        _subscriptions.push_back(eventBus.subscribe<EditorEvents::NodeReparented>([this](const EditorEvents::NodeReparented&) { _isDirty = true; }));
+        _subscriptions.push_back(eventBus.subscribe<EditorEvents::PropertyChanged>([this](const EditorEvents::PropertyChanged&) { _isDirty = true; }));
+        _subscriptions.push_back(eventBus.subscribe<EditorEvents::CommandExecuted>([this](const EditorEvents::CommandExecuted&) { _isDirty = true; }));
+        _subscriptions.push_back(eventBus.subscribe<EditorEvents::CommandUndone>([this](const EditorEvents::CommandUndone&) { _isDirty = true; }));
+        return true;
+    }
+
     void Animation::draw(bool *open)
     {
         cocos2d::Node *editingNode = Editor::getInstance()->getEditingNode();
@@ -112,7 +128,14 @@ namespace CCImEditor
         {
             NodeImDrawer *drawer = editingNode->getComponent<NodeImDrawer>();
 
-            std::unordered_map<std::string, bool> animationExists = drawer->getAnimationNames();
+            if (_isDirty)
+            {
+                _animationNames = drawer->getAnimationNames();
+                _isSequenceDirty = true;
+                _isDirty = false;
+            }
+
+            const std::unordered_map<std::string, bool>& animationExists = _animationNames;
 
             std::string animation = drawer->_animationName;
 
@@ -134,7 +157,7 @@ namespace CCImEditor
                     {
                         animation = "unnamed";
                         int count = 1;
-                        while (animationExists[animation])
+                        while (animationExists.count(animation))
                             animation = cocos2d::StringUtils::format("unnamed (%d)", count++);
                     }
 
@@ -161,7 +184,14 @@ namespace CCImEditor
             }
             else
             {
-                auto items = drawer->getAnimationSequenceItems(animation);
+                if (_isSequenceDirty || _sequenceAnimation != animation)
+                {
+                    _sequence._items = drawer->getAnimationSequenceItems(animation);
+                    _sequenceAnimation = animation;
+                    _isSequenceDirty = false;
+                }
+
+                std::vector<Internal::Animation::SequenceItem>& items = _sequence._items;
                 int currentFrame = drawer->_currentFrame;
                 int maxFrame = 0;
 
@@ -234,7 +264,17 @@ namespace CCImEditor
                             maxFrame = 1;
                     }
 
-                    _sequence._items = std::move(items);
+                    // The sequencer may move the ranges, they only show the keys
+                    for (Internal::Animation::SequenceItem& item : items)
+                    {
+                        item._frameStart = item._values.begin()->first;
+                        item._frameEnd = std::prev(item._values.end())->first;
+                    }
+
+                    // Applied to the animations below, the items keep the values they were collected with
+                    if (maxFrame != items[0]._frameMax || samples != items[0]._samples)
+                        _isSequenceDirty = true;
+
                     _sequence._frameMax = maxFrame;
                     ImSequencer::Sequencer(&_sequence, &currentFrame, &_expanded, &_selectedEntry, &_firstFrame, ImSequencer::SEQUENCER_EDIT_ALL);
                 }
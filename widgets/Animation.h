@@ -2,6 +2,7 @@
 #define __CCIMEDITOR_ANIMATION_H__
 
 #include "Widget.h"
+#include "EventBus.h"
 #include "imgui.h"
 #include "ImSequencer.h"
 #include "NodeImDrawer.h"
@@ -60,6 +61,9 @@ namespace CCImEditor
 
     class Animation: public Widget
     {
+    protected:
+        bool init(const RegisteredType* type, const std::string& windowName) override;
+
     private:
         void draw(bool* open) override;
 
@@ -68,6 +72,14 @@ namespace CCImEditor
         bool _expanded = true;
         int _selectedEntry = -1;
         int _firstFrame = 0;
+
+        // Collected from the whole editing node, again only once an event may have changed
+        // the animations or the nodes having them
+        bool _isDirty = true;
+        bool _isSequenceDirty = true;
+        std::unordered_map<std::string, bool> _animationNames;
+        std::string _sequenceAnimation;
+        std::vector<EventBus::Subscription> _subscriptions;
     };
 }
 
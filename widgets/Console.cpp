@@ -3,9 +3,9 @@
 
 namespace CCImEditor
 {
-    bool Console::init(const std::string& name, const std::string& windowName, uint32_t mask)
+    bool Console::init(const RegisteredType* type, const std::string& windowName)
     {
-        if (!Widget::init(name, windowName, mask))
+        if (!Widget::init(type, windowName))
             return false;
 
         cocos2d::FileUtils* fileUtil = cocos2d::FileUtils::getInstance();
@@ -14,7 +14,7 @@ namespace CCImEditor
         void draw(bool* open) override;
 
     protected:
-        bool init(const std::string& name, const std::string& windowName, uint32_t mask) override;
+        bool init(const RegisteredType* type, const std::string& windowName) override;
 
     private:
         bool _autoScroll = true;  // Keep scrolling if already at the bottom
@@ -7,17 +7,29 @@
 
 namespace CCImEditor
 {
+    bool NodeProperties::init(const RegisteredType* type, const std::string& windowName)
+    {
+        if (!Widget::init(type, windowName))
+            return false;
+
+        cocos2d::Node* node = Editor::getInstance()->getSelectedNode();
+        _drawer = node ? node->getComponent<NodeImDrawer>() : nullptr;
+
+        _subscriptions.push_back(Editor::getInstance()->getEventBus().subscribe<EditorEvents::SelectionChanged>([this](const EditorEvents::SelectionChanged& event)
+        {
+            _drawer = event._node ? event._node->getComponent<NodeImDrawer>() : nullptr;
+        }));
+        return true;
+    }
+
     void NodeProperties::draw(bool* open)
     {
         ImGui::SetNextWindowSize(ImVec2(250, 400), ImGuiCond_FirstUseEver);
         if (ImGui::Begin(getWindowName().c_str(), open))
         {
-            if (cocos2d::Node* node = dynamic_cast<cocos2d::Node*>(Editor::getInstance()->getUserObject("CCImGuiWidgets.NodeTree.SelectedNode")))
+            if (NodeImDrawer* drawer = _drawer.get())
             {
-                if (NodeImDrawer* drawer = node->getComponent<NodeImDrawer>())
-                {
-                    drawer->draw();
-                }
+                drawer->draw();
             }
         }
 
@@ -2,14 +2,25 @@
 #define __CCIMEDITOR_NODEPROPERTIES_H__
 
 #include <string>
+#include <vector>
 #include "Widget.h"
+#include "EventBus.h"
 
 namespace CCImEditor
 {
+    class NodeImDrawer;
+
     class NodeProperties: public Widget
     {
+    protected:
+        bool init(const RegisteredType* type, const std::string& windowName) override;
+
     private:
         void draw(bool* open) override;
+
+        // Drawer of the selected node, updated when the selection changes
+        cocos2d::WeakPtr<NodeImDrawer> _drawer;
+        std::vector<EventBus::Subscription> _subscriptions;
     };
 }
 
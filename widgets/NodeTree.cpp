@@ -12,8 +12,7 @@ namespace CCImEditor
 {
     namespace
     {
-        static const std::string s_selectedNodePath = "CCImGuiWidgets.NodeTree.SelectedNode";
-
+        // Follows Editor::getSelectedNode through EditorEvents::SelectionChanged
         static WeakPtr<Node> s_selectedNode = nullptr;
 
         static bool s_shouldExpandSelectedNode = false;
@@ -44,7 +43,7 @@ namespace CCImEditor
             if (!node->getChildrenCount() || hideChildren)
                 flags |= ImGuiTreeNodeFlags_Leaf;
 
-            if (s_shouldExpandSelectedNode)
+            if (s_shouldExpandSelectedNode && s_selectedNode)
             {
                 Node* current = s_selectedNode;
                 while (Node* parent = current->getParent())
@@ -98,13 +97,13 @@ namespace CCImEditor
 
             if (ImGui::IsItemClicked())
             {
-                Editor::getInstance()->setUserObject(s_selectedNodePath, node);
+                Editor::getInstance()->setSelectedNode(node);
             }
 
             // Add context menu
             if (ImGui::BeginPopupContextItem())
             {
-                Editor::getInstance()->setUserObject(s_selectedNodePath, node);
+                Editor::getInstance()->setSelectedNode(node);
                 NodeImDrawer* drawer = node->getComponent<NodeImDrawer>();
 
                 if (drawer && drawer->canHaveChildren())
@@ -186,18 +185,28 @@ namespace CCImEditor
         }
     }
 
+    bool NodeTree::init(const RegisteredType* type, const std::string& windowName)
+    {
+        if (!Widget::init(type, windowName))
+            return false;
+
+        Node* selectedNode = Editor::getInstance()->getSelectedNode();
+        s_selectedNode = selectedNode;
+        s_shouldExpandSelectedNode = selectedNode != nullptr;
+
+        _subscriptions.push_back(Editor::getInstance()->getEventBus().subscribe<EditorEvents::SelectionChanged>([](const EditorEvents::SelectionChanged& event)
+        {
+            s_selectedNode = event._node;
+            s_shouldExpandSelectedNode = event._node != nullptr;
+        }));
+        return true;
+    }
+
     void NodeTree::draw(bool* open)
     {
         ImGui::SetNextWindowSize(ImVec2(250, 400), ImGuiCond_FirstUseEver);
         if (ImGui::Begin(getWindowName().c_str(), open))
         {
-            Node* selectedNode = dynamic_cast<Node*>(Editor::getInstance()->getUserObject(s_selectedNodePath));
-            if (selectedNode != s_selectedNode)
-            {
-                s_shouldExpandSelectedNode = true;
-            }
-            s_selectedNode = selectedNode;
-
             if (Editor::getInstance()->isDebugMode())
             {   
                 if (Scene* scene = Director::getInstance()->getRunningScene())
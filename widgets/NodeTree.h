@@ -1,14 +1,21 @@
 #ifndef __CCIMEDITOR_NODETREE_H__
 #define __CCIMEDITOR_NODETREE_H__
 
+#include <vector>
 #include "Widget.h"
+#include "EventBus.h"
 
 namespace CCImEditor
 {
     class NodeTree: public Widget
     {
+    protected:
+        bool init(const RegisteredType* type, const std::string& windowName) override;
+
     private:
         void draw(bool* open) override;
+
+        std::vector<EventBus::Subscription> _subscriptions;
     };
 }
 
@@ -18,9 +18,9 @@ namespace CCImEditor
         const float s_zoomSpeed = 50.0f;
     }
 
-    bool Viewport::init(const std::string& name, const std::string& windowName, uint32_t mask)
+    bool Viewport::init(const RegisteredType* type, const std::string& windowName)
     {
-        if (!Widget::init(name, windowName, mask))
+        if (!Widget::init(type, windowName))
             return false;
 
         _drawGrid = DrawNode3D::create();
@@ -30,6 +30,12 @@ namespace CCImEditor
         _drawGrid->setName(windowName);
         _drawGrid->setCameraMask(1 << 15);
         Editor::getInstance()->addChild(_drawGrid);
+
+        _selectedNode = Editor::getInstance()->getSelectedNode();
+        _subscriptions.push_back(Editor::getInstance()->getEventBus().subscribe<EditorEvents::SelectionChanged>([this](const EditorEvents::SelectionChanged& event)
+        {
+            _selectedNode = event._node;
+        }));
         return true;
     }
 
@@ -52,6 +58,7 @@ namespace CCImEditor
             const cocos2d::Vec3& position = node->getPosition3D();
             return [weak, position] () {
                 weak->setPosition3D(position);
+                weak->getComponent<NodeImDrawer>()->setDirty();
             };
         }
         else if (_gizmoOperation == ImGuizmo::ROTATE)
@@ -59,6 +66,7 @@ namespace CCImEditor
             const cocos2d::Quaternion& rotation = node->getRotationQuat();
             return [weak, rotation] () {
                 weak->setRotationQuat(rotation);
+                weak->getComponent<NodeImDrawer>()->setDirty();
             };
         }
         else
@@ -66,13 +74,14 @@ namespace CCImEditor
             cocos2d::Vec3 scale = { node->getScaleX(), node->getScaleY(), node->getScaleZ() };
             return [weak, scale] () {
                 weak->setScale3D(scale);
+                weak->getComponent<NodeImDrawer>()->setDirty();
             };
         }
     }
 
     void Viewport::drawGizmo()
     {
-        cocos2d::Node* selectedNode = dynamic_cast<cocos2d::Node*>(Editor::getInstance()->getUserObject("CCImGuiWidgets.NodeTree.SelectedNode"));
+        cocos2d::Node* selectedNode = _selectedNode.get();
         if (!selectedNode)
             return;
 
@@ -100,8 +109,12 @@ namespace CCImEditor
             if (!_gizmoUndo)
             {
                 _gizmoUndo = getGizmoOperationWrapper(selectedNode);
+                _gizmoUndoProperties.clear();
+                drawer->getNodePropertyGroup()->serialize(_gizmoUndoProperties);
             }
 
+            drawer->setDirty();
+
             cocos2d::Vec3 position, scale;
             cocos2d::Quaternion rotation;
             transform.decompose(&scale, &rotation, &position);
@@ -128,16 +141,26 @@ namespace CCImEditor
             {
                 selectedNode->setScale3D(scale);
             }
+
+            Editor::getInstance()->getEventBus().publish(EditorEvents::PropertyChanged{selectedNode, drawer->getNodePropertyGroup(), nullptr});
         }
         
         if (_gizmoUndo && !ImGuizmo::IsUsingAny())
         {
             CustomCommand* cmd = CustomCommand::create(
                 getGizmoOperationWrapper(selectedNode),
-                _gizmoUndo
+                _gizmoUndo,
+                Command::getNodeId(selectedNode) + cocos2d::StringUtils::format("|Gizmo.%d", _gizmoOperation)
             );
+            if (cmd)
+            {
+                cocos2d::ValueMap properties;
+                drawer->getNodePropertyGroup()->serialize(properties);
+                cmd->setProperties(Command::getNodeId(selectedNode), std::string(), std::move(_gizmoUndoProperties), std::move(properties));
+            }
             Editor::getInstance()->getCommandHistory().queue(cmd, false);
             _gizmoUndo = nullptr;
+            _gizmoUndoProperties.clear();
         }
     }
 
@@ -410,7 +433,7 @@ namespace CCImEditor
                 {
                     if (ray.intersects(sprite3D->getAABB()))
                     {
-                        Editor::getInstance()->setUserObject("CCImGuiWidgets.NodeTree.SelectedNode", child);
+                        Editor::getInstance()->setSelectedNode(child);
                     }
                 }
                 else
@@ -423,7 +446,7 @@ namespace CCImEditor
                     
                     if (ray.intersects(aabb))
                     {
-                        Editor::getInstance()->setUserObject("CCImGuiWidgets.NodeTree.SelectedNode", child);
+                        Editor::getInstance()->setSelectedNode(child);
                     }
                 }
             }
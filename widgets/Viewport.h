@@ -1,7 +1,9 @@
 #ifndef __CCIMEDITOR_VIEWPORT_H__
 #define __CCIMEDITOR_VIEWPORT_H__
 
+#include <vector>
 #include "Widget.h"
+#include "EventBus.h"
 #include "imgui.h"
 #include "ImGuizmo.h"
 #include "tests/cpp-tests/Classes/Sprite3DTest/DrawNode3D.h"
@@ -15,7 +17,7 @@ namespace CCImEditor
         ~Viewport() override;
 
     protected:
-        bool init(const std::string& name, const std::string& windowName, uint32_t mask) override;
+        bool init(const RegisteredType* type, const std::string& windowName) override;
 
     private:
         void draw(bool* open) override;
@@ -37,6 +39,11 @@ namespace CCImEditor
         ImGuizmo::OPERATION _gizmoOperation = ImGuizmo::TRANSLATE;
         bool _isGizmoModeLocal = true;
         std::function<void()> _gizmoUndo;
+        cocos2d::ValueMap _gizmoUndoProperties; // of the node before the gizmo was used
+
+        // Updated when the selection changes
+        cocos2d::WeakPtr<cocos2d::Node> _selectedNode;
+        std::vector<EventBus::Subscription> _subscriptions;
     };
 }
 